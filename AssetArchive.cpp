@@ -0,0 +1,166 @@
+#include "AssetArchive.h"
+#include "InputRecording.h"
+#include <cstring>
+#include <fstream>
+
+//-----------------------------------------------------------------------------
+// Packer Functions
+//-----------------------------------------------------------------------------
+
+uint64_t AssetHash(const unsigned char* data, size_t size) {
+    return HashCombine(HASH_SEED, data, size);
+}
+
+static std::string BaseName(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+bool BuildAssetArchive(const std::string& path, const std::vector<std::string>& files, std::string& error) {
+    if (files.size() > 0xFFFF) {
+        error = "too many files";
+        return false;
+    }
+    std::vector<std::vector<unsigned char>> contents(files.size());
+    std::vector<PackEntry> entries(files.size());
+    uint64_t offset = sizeof(PackHeader) + files.size() * sizeof(PackEntry);
+    for (size_t i = 0; i < files.size(); i++) {
+        std::string name = BaseName(files[i]);
+        if (name.size() >= PACK_NAME_SIZE) {
+            error = "name too long: " + name;
+            return false;
+        }
+        std::ifstream ifs(files[i], std::ios::binary);
+        if (!ifs) {
+            error = "cannot read " + files[i];
+            return false;
+        }
+        contents[i].assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+        PackEntry& entry = entries[i];
+        memset(&entry, 0, sizeof(entry));
+        memcpy(entry.name, name.c_str(), name.size());
+        offset = (offset + PACK_ALIGN - 1) / PACK_ALIGN * PACK_ALIGN;
+        entry.offset = offset;
+        entry.length = contents[i].size();
+        entry.hash = AssetHash(contents[i].data(), contents[i].size());
+        offset += entry.length;
+    }
+
+    PackHeader header = {};
+    header.magic = PACK_MAGIC;
+    header.version = PACK_VERSION;
+    header.entryCount = (uint16_t)files.size();
+    header.indexChecksum = SaveChecksum((const unsigned char*)entries.data(), entries.size() * sizeof(PackEntry));
+
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    if (!ofs) {
+        error = "cannot write " + path;
+        return false;
+    }
+    ofs.write((const char*)&header, sizeof(header));
+    ofs.write((const char*)entries.data(), entries.size() * sizeof(PackEntry));
+    uint64_t written = sizeof(PackHeader) + entries.size() * sizeof(PackEntry);
+    static const char padding[PACK_ALIGN] = {};
+    for (size_t i = 0; i < files.size(); i++) {
+        ofs.write(padding, (std::streamsize)(entries[i].offset - written));
+        ofs.write((const char*)contents[i].data(), contents[i].size());
+        written = entries[i].offset + entries[i].length;
+    }
+    if (!ofs) {
+        error = "write failed: " + path;
+        return false;
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// AssetArchive Functions
+//-----------------------------------------------------------------------------
+
+bool AssetArchive::Open(const std::string& path) {
+    Close();
+    if (!file.Open(path) || file.Size() < sizeof(PackHeader))
+        return false;
+    const PackHeader* h = (const PackHeader*)file.Data();
+    size_t indexSize = (size_t)h->entryCount * sizeof(PackEntry);
+    if (h->magic != PACK_MAGIC || h->version != PACK_VERSION || file.Size() - sizeof(PackHeader) < indexSize) {
+        file.Close();
+        return false;
+    }
+    const PackEntry* index = (const PackEntry*)(file.Data() + sizeof(PackHeader));
+    if (SaveChecksum((const unsigned char*)index, indexSize) != h->indexChecksum) {
+        file.Close();
+        return false;
+    }
+    for (size_t i = 0; i < h->entryCount; i++) {
+        if (index[i].offset > file.Size() || index[i].length > file.Size() - index[i].offset
+            || index[i].name[PACK_NAME_SIZE - 1] != 0) {
+            file.Close();
+            return false;
+        }
+    }
+    header = h;
+    entries = index;
+    return true;
+}
+
+void AssetArchive::Close() {
+    file.Close();
+    header = nullptr;
+    entries = nullptr;
+}
+
+bool AssetArchive::Find(const std::string& name, AssetView& view) const {
+    for (size_t i = 0; i < Count(); i++) {
+        if (name == entries[i].name) {
+            view.data = file.Data() + entries[i].offset;
+            view.size = (size_t)entries[i].length;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AssetArchive::Verify(size_t index) const {
+    const PackEntry& entry = entries[index];
+    return AssetHash(file.Data() + entry.offset, (size_t)entry.length) == entry.hash;
+}
+
+std::string AssetArchive::EntryName(size_t index) const {
+    return entries[index].name;
+}
+
+//-----------------------------------------------------------------------------
+// Icon Functions
+//-----------------------------------------------------------------------------
+
+bool FindIconImage(const unsigned char* ico, size_t size, int pixels, AssetView& image) {
+    // ICONDIR: reserved, type (1 = icon), count; then 16-byte entries.
+    if (size < 6 || ico[0] != 0 || ico[1] != 0 || ico[2] != 1 || ico[3] != 0)
+        return false;
+    int count = ico[4] | (ico[5] << 8);
+    if (count == 0 || size < 6 + (size_t)count * 16)
+        return false;
+    int best = -1, bestSize = 0, bestBits = 0;
+    for (int i = 0; i < count; i++) {
+        const unsigned char* entry = ico + 6 + i * 16;
+        int width = entry[0] ? entry[0] : 256;
+        int bits = entry[6] | (entry[7] << 8);
+        uint32_t length = entry[8] | (entry[9] << 8) | (entry[10] << 16) | ((uint32_t)entry[11] << 24);
+        uint32_t offset = entry[12] | (entry[13] << 8) | (entry[14] << 16) | ((uint32_t)entry[15] << 24);
+        if (offset > size || length > size - offset)
+            continue;
+        bool better = best < 0
+            || (width >= pixels && (bestSize < pixels || width < bestSize))
+            || (width < pixels && bestSize < pixels && width > bestSize)
+            || (width == bestSize && bits > bestBits);
+        if (better) {
+            best = i;
+            bestSize = width;
+            bestBits = bits;
+            image.data = ico + offset;
+            image.size = length;
+        }
+    }
+    return best >= 0;
+}
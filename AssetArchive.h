@@ -0,0 +1,76 @@
+// AssetArchive.h : packed asset archive, memory-mapped at runtime
+//
+// Layout (little-endian):
+//   PackHeader
+//   PackEntry[entryCount]        name, offset, length and content hash
+//   asset bytes                  each asset starts on a 16-byte boundary
+// The header checksum covers the index only, so opening the archive touches
+// one page; asset pages are read by the OS the first time a view is used.
+
+#pragma once
+
+#include "SaveFile.h"
+#include <string>
+
+#define PACK_MAGIC 0x4B505A4Du   // "MZPK"
+#define PACK_VERSION 1
+#define PACK_NAME_SIZE 48
+#define PACK_ALIGN 16
+
+#pragma pack(push, 1)
+struct PackHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t entryCount;
+    uint32_t indexChecksum;     // SaveChecksum of the PackEntry array
+    uint32_t reserved;
+};
+
+struct PackEntry {
+    char name[PACK_NAME_SIZE];  // file name, zero padded
+    uint64_t offset;
+    uint64_t length;
+    uint64_t hash;              // FNV-1a 64 of the content
+};
+#pragma pack(pop)
+
+// Bytes of one asset, straight from the mapping; valid while the archive is open.
+struct AssetView {
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+};
+
+// FNV-1a 64 of an asset's content.
+uint64_t AssetHash(const unsigned char* data, size_t size);
+
+// Pack the files into one archive under their file names (directories are
+// dropped). Returns false and sets error if a file cannot be read or written.
+bool BuildAssetArchive(const std::string& path, const std::vector<std::string>& files, std::string& error);
+
+class AssetArchive {
+public:
+    // Returns false if the file is missing or its header or index is invalid.
+    bool Open(const std::string& path);
+    void Close();
+    bool IsOpen() const { return header != nullptr; }
+
+    // Returns false if no asset has that name.
+    bool Find(const std::string& name, AssetView& view) const;
+    // Re-hash one asset and compare it with the index; this reads every page.
+    bool Verify(size_t index) const;
+
+    size_t Count() const { return header ? header->entryCount : 0; }
+    const PackEntry& Entry(size_t index) const { return entries[index]; }
+    std::string EntryName(size_t index) const;
+
+private:
+    MappedFile file;
+    const PackHeader* header = nullptr;
+    const PackEntry* entries = nullptr;
+};
+
+// Pick the image in an .ico file that best fits size x size pixels: the
+// smallest one at least that big, else the largest, and the deepest colour
+// among images of that size. Returns false if the
+// data is not a valid icon file.
+bool FindIconImage(const unsigned char* ico, size_t size, int pixels, AssetView& image);
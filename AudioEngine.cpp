@@ -0,0 +1,271 @@
+#include "AudioEngine.h"
+#include "Tracing.h"
+#include <algorithm>
+#include <string>
+
+// How long the audio thread sleeps between passes. The sink's queued buffers
+// cover the gap, so this only bounds how late a command can start.
+#define AUDIO_THREAD_SLEEP_MS 2
+
+// Music volume changes during a crossfade are sent at most this often.
+#define AUDIO_FADE_STEP_MS 30
+
+//-----------------------------------------------------------------------------
+// Music Functions
+//-----------------------------------------------------------------------------
+
+#ifdef _WIN32
+static std::wstring TrackAlias(int track) {
+    return L"bgm" + std::to_wstring(track);
+}
+
+MciMusicBackend::~MciMusicBackend() {
+    for (size_t i = 0; i < files.size(); i++)
+        Stop((int)i);
+}
+
+void MciMusicBackend::Play(int track) {
+    if (track < 0 || track >= (int)files.size())
+        return;
+    std::wstring alias = TrackAlias(track);
+    if (!open[track]) {
+        std::wstring command = L"open \"" + files[track] + L"\" type mpegvideo alias " + alias;
+        if (mciSendString(command.c_str(), nullptr, 0, nullptr) != 0)
+            return;
+        open[track] = true;
+    }
+    mciSendString((L"play " + alias + L" from 0 repeat").c_str(), nullptr, 0, nullptr);
+}
+
+void MciMusicBackend::SetVolume(int track, float volume) {
+    if (track < 0 || track >= (int)files.size() || !open[track])
+        return;
+    int level = (int)((std::min)(1.0f, (std::max)(0.0f, volume)) * 1000.0f);
+    std::wstring command = L"setaudio " + TrackAlias(track) + L" volume to " + std::to_wstring(level);
+    mciSendString(command.c_str(), nullptr, 0, nullptr);
+}
+
+void MciMusicBackend::Stop(int track) {
+    if (track < 0 || track >= (int)files.size() || !open[track])
+        return;
+    mciSendString((L"stop " + TrackAlias(track)).c_str(), nullptr, 0, nullptr);
+    mciSendString((L"close " + TrackAlias(track)).c_str(), nullptr, 0, nullptr);
+    open[track] = false;
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// Producer Functions
+//-----------------------------------------------------------------------------
+
+AudioEngine::~AudioEngine() {
+    Stop();
+}
+
+void AudioEngine::Start(AudioSink* outputSink, MusicBackend* musicBackend) {
+    Stop();
+    sink = outputSink;
+    music = musicBackend;
+    running = true;
+    thread = std::thread(&AudioEngine::ThreadLoop, this);
+}
+
+void AudioEngine::Stop() {
+    if (!thread.joinable())
+        return;
+    running = false;
+    thread.join();
+}
+
+bool AudioEngine::Post(AudioCommand command) {
+    auto start = std::chrono::steady_clock::now();
+    command.posted = start;
+    bool queued = queue.TryPush(command);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    commandCount++;
+    enqueueTotalNs += ns;
+    enqueueMaxNs = (std::max)(enqueueMaxNs, ns);
+    if (!queued)
+        droppedCount++;
+    return queued;
+}
+
+uint32_t AudioEngine::PlayEffect(const SoundClip* clip, float volume, bool loop) {
+    if (!clip)
+        return 0;
+    AudioCommand command;
+    command.type = AUDIO_PLAY;
+    command.clip = clip;
+    command.volume = volume;
+    command.loop = loop;
+    command.voice = nextVoice++;
+    if (nextVoice == 0)
+        nextVoice = 1;
+    return Post(command) ? command.voice : 0;
+}
+
+bool AudioEngine::StopEffect(uint32_t voice) {
+    AudioCommand command;
+    command.type = AUDIO_STOP;
+    command.voice = voice;
+    return Post(command);
+}
+
+bool AudioEngine::StopAllEffects() {
+    AudioCommand command;
+    command.type = AUDIO_STOP_ALL;
+    return Post(command);
+}
+
+bool AudioEngine::SetEffectsVolume(float volume) {
+    AudioCommand command;
+    command.type = AUDIO_VOLUME;
+    command.volume = volume;
+    return Post(command);
+}
+
+bool AudioEngine::PlayMusic(int track) {
+    AudioCommand command;
+    command.type = AUDIO_MUSIC;
+    command.track = track;
+    return Post(command);
+}
+
+bool AudioEngine::CrossfadeMusic(int track, int durationMs) {
+    AudioCommand command;
+    command.type = AUDIO_CROSSFADE;
+    command.track = track;
+    command.durationMs = durationMs;
+    return Post(command);
+}
+
+bool AudioEngine::StopMusic() {
+    return PlayMusic(-1);
+}
+
+bool AudioEngine::SetMusicVolume(float volume) {
+    AudioCommand command;
+    command.type = AUDIO_MUSIC_VOLUME;
+    command.volume = volume;
+    return Post(command);
+}
+
+AudioLatencyStats AudioEngine::Stats() const {
+    AudioLatencyStats stats;
+    stats.commands = commandCount;
+    stats.dropped = droppedCount;
+    stats.enqueueAvgNs = commandCount ? enqueueTotalNs / commandCount : 0;
+    stats.enqueueMaxNs = enqueueMaxNs;
+    stats.dispatchMaxMs = dispatchMaxUs.load(std::memory_order_relaxed) / 1000.0;
+    return stats;
+}
+
+//-----------------------------------------------------------------------------
+// Audio Thread Functions
+//-----------------------------------------------------------------------------
+
+void AudioEngine::ThreadLoop() {
+    AudioCommand command;
+    SetTraceThreadName("audio");
+    while (running.load(std::memory_order_acquire)) {
+        {
+            TRACE_SCOPE("AudioPass");
+            while (queue.TryPop(command)) {
+                uint64_t delayUs = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - command.posted).count();
+                if (delayUs > dispatchMaxUs.load(std::memory_order_relaxed))
+                    dispatchMaxUs.store(delayUs, std::memory_order_relaxed);
+                Execute(command);
+            }
+            UpdateCrossfade();
+            if (sink)
+                mixer.Render(*sink);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(AUDIO_THREAD_SLEEP_MS));
+    }
+    // Anything still queued is dropped; music stops with the thread that
+    // started it.
+    while (queue.TryPop(command)) {}
+    mixer.StopAll();
+    if (music) {
+        if (fadingTrack >= 0)
+            music->Stop(fadingTrack);
+        if (musicTrack >= 0)
+            music->Stop(musicTrack);
+    }
+    musicTrack = fadingTrack = -1;
+}
+
+void AudioEngine::Execute(const AudioCommand& command) {
+    switch (command.type) {
+    case AUDIO_PLAY:
+        mixer.Play(command.clip, command.volume, command.loop, command.voice);
+        break;
+    case AUDIO_STOP:
+        mixer.Stop(command.voice);
+        break;
+    case AUDIO_STOP_ALL:
+        mixer.StopAll();
+        break;
+    case AUDIO_VOLUME:
+        mixer.SetMasterVolume(command.volume);
+        break;
+    case AUDIO_MUSIC:
+        if (!music)
+            break;
+        if (fadingTrack >= 0)
+            music->Stop(fadingTrack);
+        if (musicTrack >= 0 && musicTrack != command.track)
+            music->Stop(musicTrack);
+        fadingTrack = -1;
+        musicTrack = command.track;
+        if (musicTrack >= 0) {
+            music->Play(musicTrack);
+            music->SetVolume(musicTrack, musicVolume);
+        }
+        break;
+    case AUDIO_CROSSFADE:
+        if (!music || command.track == musicTrack)
+            break;
+        if (musicTrack < 0 || command.durationMs <= 0) {
+            AudioCommand now = command;
+            now.type = AUDIO_MUSIC;
+            Execute(now);
+            break;
+        }
+        // A fade already running is cut short: its outgoing track stops.
+        if (fadingTrack >= 0)
+            music->Stop(fadingTrack);
+        fadingTrack = musicTrack;
+        musicTrack = command.track;
+        music->Play(musicTrack);
+        music->SetVolume(musicTrack, 0.0f);
+        fadeStart = fadeStepped = std::chrono::steady_clock::now();
+        fadeMs = command.durationMs;
+        break;
+    case AUDIO_MUSIC_VOLUME:
+        musicVolume = command.volume;
+        if (music && fadingTrack < 0 && musicTrack >= 0)
+            music->SetVolume(musicTrack, musicVolume);
+        break;
+    }
+}
+
+void AudioEngine::UpdateCrossfade() {
+    if (!music || fadingTrack < 0)
+        return;
+    auto now = std::chrono::steady_clock::now();
+    if (now - fadeStepped < std::chrono::milliseconds(AUDIO_FADE_STEP_MS))
+        return;
+    fadeStepped = now;
+    double elapsed = std::chrono::duration<double, std::milli>(now - fadeStart).count();
+    float t = (float)(std::min)(1.0, elapsed / fadeMs);
+    music->SetVolume(musicTrack, musicVolume * t);
+    if (t >= 1.0f) {
+        music->Stop(fadingTrack);
+        fadingTrack = -1;
+    }
+    else {
+        music->SetVolume(fadingTrack, musicVolume * (1.0f - t));
+    }
+}
@@ -0,0 +1,127 @@
+// AudioEngine.h : one long-lived audio thread that owns all playback
+//
+// The game thread never calls into the sound device. It posts small commands
+// into a lock-free SPSC queue and returns; the audio thread drains the queue,
+// runs the mixer into the output sink and drives the background music,
+// including crossfades between tracks.
+
+#pragma once
+
+#include "AudioMixer.h"
+#include "SpscQueue.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// Background music player; only ever called from the audio thread.
+class MusicBackend {
+public:
+    virtual ~MusicBackend() = default;
+    virtual void Play(int track) = 0;                   // start looping from the beginning
+    virtual void SetVolume(int track, float volume) = 0;
+    virtual void Stop(int track) = 0;
+};
+
+#ifdef _WIN32
+// MP3 tracks played through MCI, one alias per track.
+class MciMusicBackend : public MusicBackend {
+public:
+    explicit MciMusicBackend(const std::vector<std::wstring>& files) : files(files), open(files.size(), false) {}
+    ~MciMusicBackend();
+    // Point a track at another file; only before the audio thread starts.
+    void SetFile(int track, const std::wstring& file) { files[track] = file; }
+    void Play(int track) override;
+    void SetVolume(int track, float volume) override;
+    void Stop(int track) override;
+
+private:
+    std::vector<std::wstring> files;
+    std::vector<bool> open;
+};
+#endif
+
+enum AudioCommandType {
+    AUDIO_PLAY,         // start an effect voice
+    AUDIO_STOP,         // stop one effect voice
+    AUDIO_STOP_ALL,     // stop every effect voice
+    AUDIO_VOLUME,       // effects master volume
+    AUDIO_MUSIC,        // switch music track at once (-1 stops)
+    AUDIO_CROSSFADE,    // fade from the current track to another
+    AUDIO_MUSIC_VOLUME
+};
+
+struct AudioCommand {
+    AudioCommandType type = AUDIO_STOP_ALL;
+    const SoundClip* clip = nullptr;
+    uint32_t voice = 0;
+    float volume = 1.0f;
+    int track = -1;
+    int durationMs = 0;
+    bool loop = false;
+    std::chrono::steady_clock::time_point posted;
+};
+
+// Enqueue cost is measured on the game thread, dispatch delay (post to
+// execution) on the audio thread.
+struct AudioLatencyStats {
+    uint64_t commands = 0;
+    uint64_t dropped = 0;          // queue was full
+    double enqueueAvgNs = 0;
+    double enqueueMaxNs = 0;
+    double dispatchMaxMs = 0;
+};
+
+class AudioEngine {
+public:
+    AudioEngine() = default;
+    ~AudioEngine();
+    AudioEngine(const AudioEngine&) = delete;
+    AudioEngine& operator=(const AudioEngine&) = delete;
+
+    // sink and music (may be null) must outlive the engine's thread.
+    void Start(AudioSink* sink, MusicBackend* music);
+    void Stop();
+    bool IsRunning() const { return thread.joinable(); }
+
+    // Producer side: call from one thread only. None of these block; they
+    // return false (or voice 0) if the queue is full.
+    uint32_t PlayEffect(const SoundClip* clip, float volume = 1.0f, bool loop = false);
+    bool StopEffect(uint32_t voice);
+    bool StopAllEffects();
+    bool SetEffectsVolume(float volume);
+    bool PlayMusic(int track);
+    bool CrossfadeMusic(int track, int durationMs);
+    bool StopMusic();
+    bool SetMusicVolume(float volume);
+
+    AudioLatencyStats Stats() const;
+
+private:
+    bool Post(AudioCommand command);
+    void ThreadLoop();
+    void Execute(const AudioCommand& command);
+    void UpdateCrossfade();
+
+    SpscQueue<AudioCommand, 256> queue;
+    std::thread thread;
+    std::atomic<bool> running{ false };
+    AudioSink* sink = nullptr;
+    MusicBackend* music = nullptr;
+
+    // Producer-side state.
+    uint32_t nextVoice = 1;
+    uint64_t commandCount = 0;
+    uint64_t droppedCount = 0;
+    double enqueueTotalNs = 0;
+    double enqueueMaxNs = 0;
+
+    // Audio-thread state.
+    SoundMixer mixer;
+    int musicTrack = -1;
+    int fadingTrack = -1;           // track fading out, or -1
+    float musicVolume = 1.0f;
+    std::chrono::steady_clock::time_point fadeStart;
+    std::chrono::steady_clock::time_point fadeStepped;  // last volume update
+    int fadeMs = 0;
+    std::atomic<uint64_t> dispatchMaxUs{ 0 };
+};
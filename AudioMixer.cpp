@@ -0,0 +1,232 @@
+#include "AudioMixer.h"
+#include <algorithm>
+#include <cstring>
+#ifdef _WIN32
+#pragma comment(lib, "winmm.lib")
+#endif
+
+static int VolumeToGain(float volume) {
+    if (volume < 0)
+        volume = 0;
+    return (int)(volume * 256.0f + 0.5f);
+}
+
+//-----------------------------------------------------------------------------
+// Sink Functions
+//-----------------------------------------------------------------------------
+
+WavFileSink::~WavFileSink() {
+    Close();
+}
+
+#pragma pack(push, 1)
+struct WavHeader {
+    char riff[4] = { 'R', 'I', 'F', 'F' };
+    uint32_t riffSize = 36;
+    char wave[8] = { 'W', 'A', 'V', 'E', 'f', 'm', 't', ' ' };
+    uint32_t fmtSize = 16;
+    uint16_t format = 1;
+    uint16_t channels = MIXER_CHANNELS;
+    uint32_t rate = MIXER_SAMPLE_RATE;
+    uint32_t byteRate = MIXER_SAMPLE_RATE * MIXER_CHANNELS * 2;
+    uint16_t blockAlign = MIXER_CHANNELS * 2;
+    uint16_t bits = 16;
+    char data[4] = { 'd', 'a', 't', 'a' };
+    uint32_t dataSize = 0;
+};
+#pragma pack(pop)
+
+bool WavFileSink::Open(const std::string& path) {
+    Close();
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+    dataBytes = 0;
+    WavHeader header;
+    file.write((const char*)&header, sizeof(header));
+    return true;
+}
+
+void WavFileSink::Close() {
+    if (!file.is_open())
+        return;
+    WavHeader header;
+    header.riffSize = 36 + dataBytes;
+    header.dataSize = dataBytes;
+    file.seekp(0);
+    file.write((const char*)&header, sizeof(header));
+    file.close();
+}
+
+void WavFileSink::Write(const int16_t* samples, int frames) {
+    if (!file.is_open())
+        return;
+    size_t bytes = (size_t)frames * MIXER_CHANNELS * sizeof(int16_t);
+    file.write((const char*)samples, bytes);
+    dataBytes += (uint32_t)bytes;
+}
+
+#ifdef _WIN32
+WaveOutSink::~WaveOutSink() {
+    Close();
+}
+
+bool WaveOutSink::Open(int bufferCount, int frames) {
+    Close();
+    WAVEFORMATEX format = {};
+    format.wFormatTag = WAVE_FORMAT_PCM;
+    format.nChannels = MIXER_CHANNELS;
+    format.nSamplesPerSec = MIXER_SAMPLE_RATE;
+    format.wBitsPerSample = 16;
+    format.nBlockAlign = MIXER_CHANNELS * 2;
+    format.nAvgBytesPerSec = MIXER_SAMPLE_RATE * format.nBlockAlign;
+    if (waveOutOpen(&device, WAVE_MAPPER, &format, 0, 0, CALLBACK_NULL) != MMSYSERR_NOERROR) {
+        device = nullptr;
+        return false;
+    }
+    bufferFrames = frames;
+    buffers.assign(bufferCount, std::vector<int16_t>(frames * MIXER_CHANNELS));
+    headers.assign(bufferCount, WAVEHDR());
+    for (int i = 0; i < bufferCount; i++) {
+        headers[i].lpData = (LPSTR)buffers[i].data();
+        headers[i].dwBufferLength = (DWORD)(frames * MIXER_CHANNELS * sizeof(int16_t));
+        waveOutPrepareHeader(device, &headers[i], sizeof(WAVEHDR));
+        headers[i].dwFlags |= WHDR_DONE;   // free until first written
+    }
+    nextBuffer = 0;
+    return true;
+}
+
+void WaveOutSink::Close() {
+    if (!device)
+        return;
+    waveOutReset(device);
+    for (auto& header : headers)
+        waveOutUnprepareHeader(device, &header, sizeof(WAVEHDR));
+    waveOutClose(device);
+    device = nullptr;
+    headers.clear();
+    buffers.clear();
+}
+
+int WaveOutSink::FramesWanted() {
+    if (!device)
+        return 0;
+    // Buffers are handed out in ring order, so count free ones from nextBuffer.
+    int free = 0;
+    for (size_t i = 0; i < headers.size(); i++) {
+        if (!(headers[(nextBuffer + i) % headers.size()].dwFlags & WHDR_DONE))
+            break;
+        free++;
+    }
+    return free * bufferFrames;
+}
+
+void WaveOutSink::Write(const int16_t* samples, int frames) {
+    while (device && frames > 0) {
+        WAVEHDR& header = headers[nextBuffer];
+        if (!(header.dwFlags & WHDR_DONE))
+            return;
+        int count = (std::min)(frames, bufferFrames);
+        memcpy(buffers[nextBuffer].data(), samples, count * MIXER_CHANNELS * sizeof(int16_t));
+        header.dwBufferLength = (DWORD)(count * MIXER_CHANNELS * sizeof(int16_t));
+        header.dwFlags &= ~WHDR_DONE;
+        waveOutWrite(device, &header, sizeof(WAVEHDR));
+        nextBuffer = (nextBuffer + 1) % (int)headers.size();
+        samples += count * MIXER_CHANNELS;
+        frames -= count;
+    }
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// Mixer Functions
+//-----------------------------------------------------------------------------
+
+uint32_t SoundMixer::Play(const SoundClip* clip, float volume, bool loop, uint32_t id) {
+    if (!clip || clip->Frames() == 0)
+        return 0;
+    MixerVoice voice;
+    voice.id = id;
+    if (voice.id == 0) {
+        voice.id = nextId++;
+        if (nextId == 0)
+            nextId = 1;
+    }
+    voice.clip = clip;
+    voice.gain = VolumeToGain(volume);
+    voice.loop = loop;
+    voices.push_back(voice);
+    return voice.id;
+}
+
+void SoundMixer::Stop(uint32_t voice) {
+    for (size_t i = 0; i < voices.size(); i++) {
+        if (voices[i].id == voice) {
+            voices[i] = voices.back();
+            voices.pop_back();
+            return;
+        }
+    }
+}
+
+void SoundMixer::StopAll() {
+    voices.clear();
+}
+
+void SoundMixer::SetVolume(uint32_t voice, float volume) {
+    for (auto& v : voices)
+        if (v.id == voice)
+            v.gain = VolumeToGain(volume);
+}
+
+void SoundMixer::SetMasterVolume(float volume) {
+    masterGain = VolumeToGain(volume);
+}
+
+void SoundMixer::Mix(int16_t* out, int frames) {
+    int samples = frames * MIXER_CHANNELS;
+    accumulator.assign(samples, 0);
+    int32_t* acc = accumulator.data();
+    for (size_t v = 0; v < voices.size();) {
+        MixerVoice& voice = voices[v];
+        const int16_t* source = voice.clip->pcm;
+        size_t clipFrames = voice.clip->Frames();
+        int gain = voice.gain;
+        int done = 0;
+        while (done < frames) {
+            int count = (int)(std::min)((size_t)(frames - done), clipFrames - voice.position);
+            const int16_t* in = source + voice.position * MIXER_CHANNELS;
+            int32_t* dst = acc + done * MIXER_CHANNELS;
+            for (int i = 0; i < count * MIXER_CHANNELS; i++)
+                dst[i] += (in[i] * gain) >> 8;
+            done += count;
+            voice.position += count;
+            if (voice.position < clipFrames)
+                continue;
+            if (!voice.loop)
+                break;
+            voice.position = 0;
+        }
+        if (voice.position >= clipFrames && !voice.loop) {
+            voices[v] = voices.back();
+            voices.pop_back();
+        }
+        else {
+            v++;
+        }
+    }
+    for (int i = 0; i < samples; i++) {
+        int64_t value = ((int64_t)acc[i] * masterGain) >> 8;
+        out[i] = (int16_t)(std::max)((int64_t)-32768, (std::min)((int64_t)32767, value));
+    }
+}
+
+void SoundMixer::Render(AudioSink& sink) {
+    int frames = sink.FramesWanted();
+    if (frames <= 0)
+        return;
+    block.resize(frames * MIXER_CHANNELS);
+    Mix(block.data(), frames);
+    sink.Write(block.data(), frames);
+}
@@ -0,0 +1,117 @@
+// AudioMixer.h : software mixer and the output sinks it renders into
+//
+// Any number of voices play at once; each Mix() call sums them into a 32-bit
+// accumulator (room for tens of thousands of full-scale voices) and clips
+// once to 16 bits. Where the samples go is up to the sink: the sound card on
+// Windows, or a null or WAV file sink for tests and benchmarks.
+
+#pragma once
+
+#include "MazeGame.h"
+#include "SoundBank.h"
+#include <fstream>
+#ifdef _WIN32
+#include <mmsystem.h>
+#endif
+
+// Output device behind the mixer.
+class AudioSink {
+public:
+    virtual ~AudioSink() = default;
+    // Frames the sink can take right now without blocking.
+    virtual int FramesWanted() = 0;
+    virtual void Write(const int16_t* samples, int frames) = 0;
+};
+
+// Discards everything; always wants one block. Used by benchmarks.
+class NullSink : public AudioSink {
+public:
+    explicit NullSink(int blockFrames = 1024) : blockFrames(blockFrames) {}
+    int FramesWanted() override { return blockFrames; }
+    void Write(const int16_t*, int frames) override { framesWritten += frames; }
+    uint64_t FramesWritten() const { return framesWritten; }
+
+private:
+    int blockFrames;
+    uint64_t framesWritten = 0;
+};
+
+// Writes a 16-bit stereo WAV file; the header is completed by Close().
+class WavFileSink : public AudioSink {
+public:
+    explicit WavFileSink(int blockFrames = 1024) : blockFrames(blockFrames) {}
+    ~WavFileSink();
+    WavFileSink(const WavFileSink&) = delete;
+    WavFileSink& operator=(const WavFileSink&) = delete;
+
+    bool Open(const std::string& path);
+    void Close();
+    int FramesWanted() override { return file.is_open() ? blockFrames : 0; }
+    void Write(const int16_t* samples, int frames) override;
+
+private:
+    std::ofstream file;
+    int blockFrames;
+    uint32_t dataBytes = 0;
+};
+
+#ifdef _WIN32
+// waveOut device fed from a ring of buffers. FramesWanted() reports the
+// buffers the device has finished with, so rendering never waits on it.
+class WaveOutSink : public AudioSink {
+public:
+    WaveOutSink() = default;
+    ~WaveOutSink();
+    WaveOutSink(const WaveOutSink&) = delete;
+    WaveOutSink& operator=(const WaveOutSink&) = delete;
+
+    bool Open(int bufferCount = 8, int bufferFrames = 512);
+    void Close();
+    bool IsOpen() const { return device != nullptr; }
+    int FramesWanted() override;
+    void Write(const int16_t* samples, int frames) override;
+
+private:
+    HWAVEOUT device = nullptr;
+    std::vector<WAVEHDR> headers;
+    std::vector<std::vector<int16_t>> buffers;
+    int bufferFrames = 0;
+    int nextBuffer = 0;
+};
+#endif
+
+// One playing clip.
+struct MixerVoice {
+    uint32_t id = 0;
+    const SoundClip* clip = nullptr;
+    size_t position = 0;    // next frame
+    int gain = 256;         // 8.8 fixed point, 256 = unity
+    bool loop = false;
+};
+
+class SoundMixer {
+public:
+    // Start a voice; returns its id (never 0). Volume 1.0 is unity gain. A
+    // caller that hands out its own ids passes one in; 0 picks the next.
+    uint32_t Play(const SoundClip* clip, float volume = 1.0f, bool loop = false, uint32_t id = 0);
+    void Stop(uint32_t voice);
+    void StopAll();
+    void SetVolume(uint32_t voice, float volume);
+    void SetMasterVolume(float volume);
+
+    // Sum every voice into `frames` interleaved stereo frames. Finished
+    // voices are dropped.
+    void Mix(int16_t* out, int frames);
+
+    // Mix as many frames as the sink wants and write them.
+    void Render(AudioSink& sink);
+
+    int ActiveVoices() const { return (int)voices.size(); }
+
+private:
+    std::vector<MixerVoice> voices;
+    std::vector<int32_t> accumulator;
+    std::vector<int16_t> block;
+    int masterGain = 256;
+    uint32_t nextId = 1;
+};
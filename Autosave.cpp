@@ -0,0 +1,193 @@
+#include "Autosave.h"
+#include "Teleporters.h"
+#include <fstream>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+// Records are written when this many are queued, or at the latest after
+// JOURNAL_FLUSH_MS, whichever comes first.
+#define JOURNAL_BATCH 64
+#define JOURNAL_FLUSH_MS 1000
+
+static_assert(MOVE_DIR_MASK == UNDO_DIR_MASK && MOVE_TICK == UNDO_TICK && MOVE_ENTERED == UNDO_ENTERED
+    && MOVE_CELL_CHANGED == UNDO_CELL_CHANGED && MOVE_RESET == UNDO_RESET && MOVE_NEXT_LEVEL == UNDO_NEXT_LEVEL
+    && MOVE_TELEPORT == UNDO_TELEPORT, "move records reuse the undo flags");
+
+MoveRecord MoveRecordFromStep(const UndoDelta& step) {
+    MoveRecord record = {};
+    record.flags = step.flags;
+    record.cell = (uint8_t)step.NewCell();
+    record.livesDelta = step.livesDelta;
+    record.timeDelta = step.timeDelta;
+    record.scoreDelta = step.scoreDelta;
+    return record;
+}
+
+void ApplyMoveRecord(SaveGameData& data, const MoveRecord& record) {
+    if (!(record.flags & MOVE_TICK)) {
+        int dx, dy;
+        MoveDirectionStep(record.flags & MOVE_DIR_MASK, dx, dy);
+        int tx = data.playerPosition.x + dx;
+        int ty = data.playerPosition.y + dy;
+        if (record.flags & MOVE_CELL_CHANGED)
+            data.levels[data.currentLevel][ty][tx] = record.cell;
+        if (record.flags & MOVE_ENTERED)
+            data.playerPosition = { tx, ty };
+        if (record.flags & MOVE_TELEPORT)
+            FindLinkedTeleporter(data.levels, data.currentLevel, { tx, ty }, data.currentLevel, data.playerPosition);
+    }
+    if (record.flags & MOVE_RESET)
+        data.playerPosition = { 0, 0 };
+    if (record.flags & MOVE_NEXT_LEVEL) {
+        data.currentLevel++;
+        data.playerPosition = { 0, 0 };
+    }
+    data.lives += record.livesDelta;
+    data.timeLeft += record.timeDelta;
+    data.score += record.scoreDelta;
+}
+
+// Write to a temporary file and move it over the target, so a crash never
+// leaves a half-written snapshot behind.
+static bool ReplaceFile(const std::string& path, const std::vector<unsigned char>& bytes) {
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream ofs(tempPath, std::ios::binary | std::ios::trunc);
+        if (!ofs)
+            return false;
+        ofs.write((const char*)bytes.data(), bytes.size());
+        if (!ofs)
+            return false;
+    }
+#ifdef _WIN32
+    return MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(tempPath.c_str(), path.c_str()) == 0;
+#endif
+}
+
+static uint32_t SnapshotChecksum(const std::vector<unsigned char>& snapshot) {
+    SaveHeader header;
+    memcpy(&header, snapshot.data(), sizeof(header));
+    return header.checksum;
+}
+
+static void StartLog(const std::string& logPath, uint32_t snapshotChecksum) {
+    JournalHeader header = { JOURNAL_MAGIC, snapshotChecksum };
+    std::ofstream ofs(logPath, std::ios::binary | std::ios::trunc);
+    ofs.write((const char*)&header, sizeof(header));
+}
+
+bool RecoverAutosave(const std::string& snapshotPath, const std::string& logPath, SaveGameData& data) {
+    BinarySaveView snapshot;
+    if (!snapshot.Open(snapshotPath) || !snapshot.ToSaveData(data))
+        return false;
+    uint32_t snapshotChecksum = snapshot.Header().checksum;
+
+    std::ifstream ifs(logPath, std::ios::binary);
+    JournalHeader logHeader;
+    if (!ifs.read((char*)&logHeader, sizeof(logHeader)) ||
+        logHeader.magic != JOURNAL_MAGIC || logHeader.snapshotChecksum != snapshotChecksum)
+        return true;   // no log, or a stale one: the snapshot alone is the state
+    // A torn final record from a crash mid-write fails the read and is dropped.
+    MoveRecord record;
+    while (ifs.read((char*)&record, sizeof(record))) {
+        if (data.currentLevel >= (int)data.levels.size() - 1 && (record.flags & MOVE_NEXT_LEVEL))
+            break;
+        ApplyMoveRecord(data, record);
+    }
+    return true;
+}
+
+//-----------------------------------------------------
+// AutosaveJournal
+//-----------------------------------------------------
+AutosaveJournal::~AutosaveJournal() {
+    Stop();
+}
+
+void AutosaveJournal::Start(const std::string& snapshot, const std::string& log,
+    const SaveGameData& base, size_t threshold) {
+    Stop();
+    snapshotPath = snapshot;
+    logPath = log;
+    compactThreshold = threshold;
+    recordsSinceSnapshot = 0;
+    stopRequested = false;
+    pending.clear();
+    pendingSnapshot = EncodeBinarySave(base);
+    running = true;
+    worker = std::thread(&AutosaveJournal::WorkerLoop, this);
+    wake.notify_one();
+}
+
+void AutosaveJournal::Stop() {
+    if (!running)
+        return;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopRequested = true;
+    }
+    wake.notify_one();
+    worker.join();
+    running = false;
+}
+
+bool AutosaveJournal::Append(const MoveRecord& record) {
+    size_t queued;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        pending.push_back(record);
+        queued = pending.size();
+    }
+    if (queued >= JOURNAL_BATCH)
+        wake.notify_one();
+    return ++recordsSinceSnapshot >= compactThreshold;
+}
+
+void AutosaveJournal::Compact(const SaveGameData& state) {
+    std::vector<unsigned char> snapshot = EncodeBinarySave(state);
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        // Records queued so far are already part of the new snapshot.
+        pending.clear();
+        pendingSnapshot.swap(snapshot);
+    }
+    recordsSinceSnapshot = 0;
+    wake.notify_one();
+}
+
+void AutosaveJournal::WorkerLoop() {
+    std::vector<MoveRecord> batch;
+    std::vector<unsigned char> snapshot;
+    std::ofstream logFile;
+    while (true) {
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait_for(guard, std::chrono::milliseconds(JOURNAL_FLUSH_MS), [this] {
+                return stopRequested || !pendingSnapshot.empty() || pending.size() >= JOURNAL_BATCH;
+            });
+            snapshot.swap(pendingSnapshot);
+            batch.swap(pending);
+            stopping = stopRequested;
+        }
+        if (!snapshot.empty()) {
+            // New base: write it first, then begin a fresh log that refers to it.
+            logFile.close();
+            if (ReplaceFile(snapshotPath, snapshot))
+                StartLog(logPath, SnapshotChecksum(snapshot));
+            snapshot.clear();
+        }
+        if (!batch.empty()) {
+            if (!logFile.is_open())
+                logFile.open(logPath, std::ios::binary | std::ios::app);
+            logFile.write((const char*)batch.data(), batch.size() * sizeof(MoveRecord));
+            logFile.flush();
+            batch.clear();
+        }
+        if (stopping)
+            break;
+    }
+}
@@ -0,0 +1,94 @@
+// Autosave.h : journaled autosave (base snapshot + append-only move log)
+//
+// The snapshot is a regular binary save (SaveFile.h). The log starts with a
+// JournalHeader naming the checksum of the snapshot it applies to, followed
+// by fixed-size MoveRecords. A log whose header does not match the current
+// snapshot is stale (the game stopped between writing a new snapshot and
+// starting its log) and is ignored on recovery.
+
+#pragma once
+
+#include "SaveFile.h"
+#include "UndoHistory.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#define JOURNAL_MAGIC 0x4C4A5A4Du   // "MZJL"
+
+// MoveRecord::flags
+#define MOVE_DIR_MASK      0x03   // 0 up, 1 right, 2 down, 3 left
+#define MOVE_TICK          0x04   // timer tick rather than a key press
+#define MOVE_ENTERED       0x08   // player stepped onto the target cell
+#define MOVE_CELL_CHANGED  0x10   // target cell now holds MoveRecord::cell
+#define MOVE_RESET         0x20   // player sent back to the start cell
+#define MOVE_NEXT_LEVEL    0x40   // player advanced to the next level
+#define MOVE_TELEPORT      0x80   // player went through the teleporter on the target cell
+
+#pragma pack(push, 1)
+struct JournalHeader {
+    uint32_t magic;
+    uint32_t snapshotChecksum;
+};
+
+// One step of play in six bytes.
+struct MoveRecord {
+    uint8_t flags;
+    uint8_t cell;
+    int8_t livesDelta;
+    int16_t timeDelta;
+    int8_t scoreDelta;
+};
+#pragma pack(pop)
+
+// The record of a step GameSession::LastStep() describes; the flags are the
+// UndoDelta ones.
+MoveRecord MoveRecordFromStep(const UndoDelta& step);
+
+// Apply one record to a save; this is the whole replay rule set.
+void ApplyMoveRecord(SaveGameData& data, const MoveRecord& record);
+
+// Load the snapshot and replay the log over it. Returns false if there is
+// no usable snapshot.
+bool RecoverAutosave(const std::string& snapshotPath, const std::string& logPath, SaveGameData& data);
+
+// Background journal writer. Append() only copies the record into a memory
+// batch; a worker thread writes batches to the log and rewrites the
+// snapshot when asked to compact.
+class AutosaveJournal {
+public:
+    AutosaveJournal() = default;
+    ~AutosaveJournal();
+    AutosaveJournal(const AutosaveJournal&) = delete;
+    AutosaveJournal& operator=(const AutosaveJournal&) = delete;
+
+    // Start journaling from the given base state.
+    void Start(const std::string& snapshotPath, const std::string& logPath,
+        const SaveGameData& base, size_t compactThreshold = 4096);
+    // Flush pending records and stop the worker thread.
+    void Stop();
+    bool IsRunning() const { return running; }
+
+    // Queue a record. Returns true once the log has grown past the
+    // compaction threshold; the caller should then call Compact().
+    bool Append(const MoveRecord& record);
+
+    // Replace snapshot and log with a new snapshot of the given state.
+    void Compact(const SaveGameData& state);
+
+private:
+    void WorkerLoop();
+
+    std::string snapshotPath;
+    std::string logPath;
+    size_t compactThreshold = 4096;
+    size_t recordsSinceSnapshot = 0;
+    bool running = false;
+
+    std::mutex lock;
+    std::condition_variable wake;
+    std::vector<MoveRecord> pending;              // guarded by lock
+    std::vector<unsigned char> pendingSnapshot;   // guarded by lock
+    bool stopRequested = false;                   // guarded by lock
+    std::thread worker;
+};
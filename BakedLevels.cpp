@@ -0,0 +1,45 @@
+#include "BakedLevels.h"
+#include "FixedGrid.h"
+
+// The classic NewGame() generation: every level from one MazeRng in turn.
+static constexpr BakedCampaign BakeCampaign(uint32_t seed) {
+    BakedCampaign campaign{};
+    campaign.seed = seed;
+    MazeRng rng(seed);
+    for (int level = 0; level < TOTAL_LEVELS; level++) {
+        FixedGrid<GRID_ROWS, GRID_COLS> grid;
+        GenerateRandomMazeLevel(rng, grid);
+        for (int cell = 0; cell < GRID_ROWS * GRID_COLS; cell++)
+            campaign.cells[level][cell] = grid.cells[cell];
+    }
+    return campaign;
+}
+
+// Evaluated by the compiler; only the finished tables end up in the binary.
+static constexpr BakedCampaign BAKED_CAMPAIGNS[BAKED_CAMPAIGN_COUNT] = {
+    BakeCampaign(1),
+    BakeCampaign(7),
+    BakeCampaign(42),
+    BakeCampaign(1337)
+};
+
+const BakedCampaign& GetBakedCampaign(int index) {
+    return BAKED_CAMPAIGNS[index];
+}
+
+const BakedCampaign* FindBakedCampaign(uint32_t seed) {
+    for (const BakedCampaign& campaign : BAKED_CAMPAIGNS) {
+        if (campaign.seed == seed)
+            return &campaign;
+    }
+    return nullptr;
+}
+
+std::vector<std::vector<int>> BakedLevelGrid(const BakedCampaign& campaign, int level) {
+    std::vector<std::vector<int>> grid(GRID_ROWS, std::vector<int>(GRID_COLS));
+    const uint8_t* cells = campaign.cells[level];
+    for (int r = 0; r < GRID_ROWS; r++)
+        for (int c = 0; c < GRID_COLS; c++)
+            grid[r][c] = *cells++;
+    return grid;
+}
@@ -0,0 +1,29 @@
+// BakedLevels.h : campaign level sets generated at compile time
+//
+// The fixed-size generator in FixedGrid.h is constexpr, so the levels of a
+// few campaign seeds are computed by the compiler and kept as read-only
+// tables. GameSession::NewGame() copies a baked set instead of generating it
+// when it has one for the seed; the levels are the same either way, which
+// MazeTool verify-baked checks against the vector generator.
+
+#pragma once
+
+#include "MazeGame.h"
+
+#define BAKED_CAMPAIGN_COUNT 4
+
+// The TOTAL_LEVELS levels NewGame() generates for one seed, before the
+// teleporter pads go in.
+struct BakedCampaign {
+    uint32_t seed;
+    uint8_t cells[TOTAL_LEVELS][GRID_ROWS * GRID_COLS];    // row-major cell values
+};
+
+// Campaign by index, 0 to BAKED_CAMPAIGN_COUNT - 1.
+const BakedCampaign& GetBakedCampaign(int index);
+
+// Baked set for seed, or null if there is none.
+const BakedCampaign* FindBakedCampaign(uint32_t seed);
+
+// One level of a baked set, laid out as the game stores levels.
+std::vector<std::vector<int>> BakedLevelGrid(const BakedCampaign& campaign, int level);
@@ -0,0 +1,244 @@
+#include "BotAgents.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+//-----------------------------------------------------------------------------
+// Path Search Functions
+//-----------------------------------------------------------------------------
+
+// Reusable BFS buffers, so agents do not allocate once per move.
+struct BotSearch {
+    std::vector<int> queue;
+    std::vector<signed char> firstStep;   // -1 = not visited yet
+
+    // BFS from the player over the current level. Walls and obstacles always
+    // block; hazards block unless allowHazards is set. Returns the first move
+    // towards the nearest cell accepted by isTarget, or -1 if none is reachable.
+    template <typename Pred>
+    int FirstStepTowards(const GameSession& session, bool allowHazards, Pred isTarget) {
+        const std::vector<std::vector<int>>& grid = session.levels[session.currentLevel];
+        int rows = grid.size(), cols = grid[0].size();
+        queue.resize(rows * cols);
+        firstStep.assign(rows * cols, -1);
+        int start = session.playerPosition.y * cols + session.playerPosition.x;
+        firstStep[start] = 4;
+        int head = 0, tail = 0;
+        queue[tail++] = start;
+        while (head < tail) {
+            int cell = queue[head++];
+            int r = cell / cols, c = cell % cols;
+            if (cell != start && isTarget(r, c, grid[r][c]))
+                return firstStep[cell];
+            for (int dir = 0; dir < 4; dir++) {
+                int dx, dy;
+                MoveDirectionStep(dir, dx, dy);
+                int nr = r + dy, nc = c + dx;
+                if (nr < 0 || nr >= rows || nc < 0 || nc >= cols)
+                    continue;
+                int next = nr * cols + nc;
+                int value = grid[nr][nc];
+                // Pads would take the agent off the level its search covers.
+                if (firstStep[next] >= 0 || value == WALL || value == OBSTACLE || value == TELEPORTER)
+                    continue;
+                if (value == HAZARD && !allowHazards)
+                    continue;
+                firstStep[next] = cell == start ? dir : firstStep[cell];
+                queue[tail++] = next;
+            }
+        }
+        return -1;
+    }
+
+    // First move towards the exit, through hazards only if there is no other way.
+    int StepToExit(const GameSession& session) {
+        POINT end = session.endPosition;
+        auto isExit = [&](int r, int c, int) { return r == end.y && c == end.x; };
+        int dir = FirstStepTowards(session, false, isExit);
+        if (dir < 0)
+            dir = FirstStepTowards(session, true, isExit);
+        return dir;
+    }
+};
+
+//-----------------------------------------------------------------------------
+// Agent Functions
+//-----------------------------------------------------------------------------
+
+class ShortestPathBot : public BotAgent {
+public:
+    const char* Name() const override { return "shortest"; }
+    GameAction NextMove(const GameSession& session) override {
+        int dir = search.StepToExit(session);
+        return dir < 0 ? ACTION_TICK : (GameAction)dir;
+    }
+private:
+    BotSearch search;
+};
+
+class GreedyBot : public BotAgent {
+public:
+    const char* Name() const override { return "greedy"; }
+    GameAction NextMove(const GameSession& session) override {
+        int dir = search.FirstStepTowards(session, false, [](int, int, int value) {
+            return value == MINIDOT || value == COLLECTIBLE;
+        });
+        if (dir < 0)
+            dir = search.StepToExit(session);
+        return dir < 0 ? ACTION_TICK : (GameAction)dir;
+    }
+private:
+    BotSearch search;
+};
+
+class RandomBot : public BotAgent {
+public:
+    const char* Name() const override { return "random"; }
+    void Reset(uint32_t seed) override { rng = MazeRng(seed ^ 0x5EED5EEDu); }
+    GameAction NextMove(const GameSession&) override { return (GameAction)rng.Below(4); }
+private:
+    MazeRng rng;
+};
+
+std::unique_ptr<BotAgent> CreateBotAgent(BotKind kind) {
+    switch (kind) {
+    case BOT_SHORTEST_PATH: return std::unique_ptr<BotAgent>(new ShortestPathBot());
+    case BOT_GREEDY: return std::unique_ptr<BotAgent>(new GreedyBot());
+    default: return std::unique_ptr<BotAgent>(new RandomBot());
+    }
+}
+
+const char* BotKindName(BotKind kind) {
+    static const char* names[BOT_KIND_COUNT] = { "shortest", "greedy", "random" };
+    return kind >= 0 && kind < BOT_KIND_COUNT ? names[kind] : "unknown";
+}
+
+bool ParseBotKind(const std::string& name, BotKind& kind) {
+    for (int i = 0; i < BOT_KIND_COUNT; i++) {
+        if (name == BotKindName((BotKind)i)) {
+            kind = (BotKind)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+// Batch Functions
+//-----------------------------------------------------------------------------
+
+// Play one game to the end (or options.maxSteps) and add it to stats.
+static void PlayBotGame(BotAgent& agent, GameSession& session, uint32_t seed,
+    const BatchOptions& options, BatchStats& stats) {
+    session.NewGame(seed);
+    agent.Reset(seed);
+    int level = 0;
+    // Teleporters can lead back, so count each level entered and cleared once.
+    int deepest = 0;
+    std::vector<uint8_t> cleared(stats.levels.size(), 0);
+    int levelStartScore = 0;
+    stats.levels[0].entered++;
+    int tickPeriod = (std::max)(1, options.movesPerTick) + 1;
+    int step = 0;
+    for (; step < options.maxSteps; step++) {
+        GameAction action = (step % tickPeriod) == tickPeriod - 1 ? ACTION_TICK : agent.NextMove(session);
+        int timeBefore = session.timeLeft;
+        StepResult result = session.Step(action);
+        LevelStats& current = stats.levels[level];
+        if (result == STEP_HAZARD || result == STEP_TIME_UP || result == STEP_GAME_OVER) {
+            if (action == ACTION_TICK)
+                current.timeLivesLost++;
+            else
+                current.hazardLivesLost++;
+        }
+        if (result == STEP_NEXT_LEVEL || result == STEP_VICTORY) {
+            if (!cleared[level]) {
+                cleared[level] = 1;
+                current.cleared++;
+                current.timeLeftAtClear += timeBefore;
+            }
+            current.score += session.score - levelStartScore;
+            levelStartScore = session.score;
+            if (result == STEP_VICTORY) {
+                stats.wins++;
+                step++;
+                break;
+            }
+            level = session.currentLevel;
+            if (level > deepest)
+                stats.levels[deepest = level].entered++;
+        }
+        else if (result == STEP_TELEPORTED && session.currentLevel != level) {
+            current.score += session.score - levelStartScore;
+            levelStartScore = session.score;
+            level = session.currentLevel;
+            if (level > deepest)
+                stats.levels[deepest = level].entered++;
+        }
+        else if (result == STEP_GAME_OVER) {
+            step++;
+            break;
+        }
+    }
+    if (session.score > levelStartScore)
+        stats.levels[level].score += session.score - levelStartScore;
+    stats.games++;
+    stats.steps += step;
+}
+
+static void MergeBatchStats(BatchStats& into, const BatchStats& from) {
+    into.games += from.games;
+    into.wins += from.wins;
+    into.steps += from.steps;
+    for (size_t i = 0; i < from.levels.size(); i++) {
+        LevelStats& a = into.levels[i];
+        const LevelStats& b = from.levels[i];
+        a.entered += b.entered;
+        a.cleared += b.cleared;
+        a.hazardLivesLost += b.hazardLivesLost;
+        a.timeLivesLost += b.timeLivesLost;
+        a.score += b.score;
+        a.timeLeftAtClear += b.timeLeftAtClear;
+    }
+}
+
+BatchStats RunBotBatch(const BatchOptions& options) {
+    BatchStats total;
+    total.levels.resize(TOTAL_LEVELS);
+    int threadCount = options.threads > 0 ? options.threads
+        : (int)(std::max)(1u, std::thread::hardware_concurrency());
+
+    // Games differ a lot in length, so workers take small chunks from a shared
+    // counter instead of fixed slices, and merge their totals once at the end.
+    const uint64_t chunk = 64;
+    std::atomic<uint64_t> nextGame(0);
+    std::mutex mergeLock;
+    auto worker = [&]() {
+        std::unique_ptr<BotAgent> agent = CreateBotAgent(options.kind);
+        GameSession session;
+        session.generator = options.generator;
+        BatchStats local;
+        local.levels.resize(TOTAL_LEVELS);
+        for (;;) {
+            uint64_t begin = nextGame.fetch_add(chunk);
+            if (begin >= options.games)
+                break;
+            uint64_t end = (std::min)(options.games, begin + chunk);
+            for (uint64_t i = begin; i < end; i++)
+                PlayBotGame(*agent, session, options.firstSeed + (uint32_t)i, options, local);
+        }
+        std::lock_guard<std::mutex> lock(mergeLock);
+        MergeBatchStats(total, local);
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threadCount; t++)
+        workers.emplace_back(worker);
+    for (auto& w : workers)
+        w.join();
+    total.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return total;
+}
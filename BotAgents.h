@@ -0,0 +1,67 @@
+// BotAgents.h : scripted players and a parallel batch evaluator
+//
+// Agents play GameSessions headlessly. The batch runner spreads games over
+// all cores and aggregates per-level results, so level difficulty can be
+// measured before changing the DecorateMaze probabilities.
+
+#pragma once
+
+#include "GameSession.h"
+#include <memory>
+#include <string>
+
+// A scripted player. NextMove() only looks at the session; it never changes it.
+class BotAgent {
+public:
+    virtual ~BotAgent() = default;
+    virtual const char* Name() const = 0;
+    // Called at the start of every game.
+    virtual void Reset(uint32_t seed) { (void)seed; }
+    virtual GameAction NextMove(const GameSession& session) = 0;
+};
+
+enum BotKind {
+    BOT_SHORTEST_PATH,   // walks the shortest hazard-free route to the exit
+    BOT_GREEDY,          // collects the nearest reachable item, then exits
+    BOT_RANDOM,          // random direction every move
+    BOT_KIND_COUNT
+};
+
+std::unique_ptr<BotAgent> CreateBotAgent(BotKind kind);
+const char* BotKindName(BotKind kind);
+bool ParseBotKind(const std::string& name, BotKind& kind);
+
+// Results for one level index, summed over all games.
+struct LevelStats {
+    uint64_t entered = 0;         // games that reached this level
+    uint64_t cleared = 0;         // games that reached its exit
+    uint64_t hazardLivesLost = 0; // lives lost to HAZARD cells
+    uint64_t timeLivesLost = 0;   // lives lost to the timer
+    uint64_t score = 0;           // mini-dots collected on this level
+    uint64_t timeLeftAtClear = 0; // sum of timeLeft when the exit was reached
+};
+
+struct BatchStats {
+    uint64_t games = 0;
+    uint64_t wins = 0;
+    uint64_t steps = 0;
+    double seconds = 0;
+    std::vector<LevelStats> levels;
+
+    double WinRate() const { return games ? (double)wins / games : 0; }
+    double GamesPerSecond() const { return seconds > 0 ? games / seconds : 0; }
+};
+
+struct BatchOptions {
+    BotKind kind = BOT_SHORTEST_PATH;
+    uint64_t games = 100000;
+    uint32_t firstSeed = 1;
+    int threads = 0;            // 0 = one per hardware core
+    int movesPerTick = 4;       // agent moves per second of game time
+    int maxSteps = 5000;        // safety cap per game
+    LevelGenerator generator = LEVELGEN_CLASSIC;
+};
+
+// Play options.games games (seeds firstSeed, firstSeed + 1, ...) and
+// aggregate the results.
+BatchStats RunBotBatch(const BatchOptions& options);
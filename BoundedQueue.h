@@ -0,0 +1,64 @@
+// BoundedQueue.h : blocking bounded multi-producer multi-consumer queue
+//
+// The blocking counterpart of SpscQueue.h, for pipeline stages with several
+// threads on either side. Push() waits while the queue is full, which is
+// what holds back a stage that runs ahead of the next one; Pop() waits while
+// it is empty. Close() wakes every waiter: pushes fail from then on and pops
+// drain what is left.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(capacity ? capacity : 1) {}
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    // Returns false if the queue was closed.
+    bool Push(T item) {
+        std::unique_lock<std::mutex> guard(lock);
+        notFull.wait(guard, [&] { return closed || items.size() < capacity; });
+        if (closed)
+            return false;
+        items.push_back(std::move(item));
+        guard.unlock();
+        notEmpty.notify_one();
+        return true;
+    }
+
+    // Returns false once the queue is closed and empty.
+    bool Pop(T& item) {
+        std::unique_lock<std::mutex> guard(lock);
+        notEmpty.wait(guard, [&] { return closed || !items.empty(); });
+        if (items.empty())
+            return false;
+        item = std::move(items.front());
+        items.pop_front();
+        guard.unlock();
+        notFull.notify_one();
+        return true;
+    }
+
+    void Close() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            closed = true;
+        }
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+
+private:
+    const size_t capacity;
+    std::mutex lock;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+    std::deque<T> items;    // guarded by lock
+    bool closed = false;    // guarded by lock
+};
@@ -0,0 +1,157 @@
+#include "Chokepoints.h"
+#include <algorithm>
+
+//-----------------------------------------------------------------------------
+// Edge Functions
+//-----------------------------------------------------------------------------
+
+// Edges are stored with their upper or left cell: 2 * cell for the edge to
+// the right neighbour, 2 * cell + 1 for the edge to the one below.
+static int EdgeBetween(int a, int b) {
+    int first = (std::min)(a, b);
+    return 2 * first + ((std::max)(a, b) - first != 1);
+}
+
+static int EdgeFrom(int cell, int dir, int stride) {
+    static const int steps[4] = { 0, 1, 0, -1 };
+    int other = cell + (dir == 0 ? -stride : dir == 2 ? stride : steps[dir]);
+    return EdgeBetween(cell, other);
+}
+
+bool ChokepointMap::IsBridge(int row, int col, int dir) const {
+    int edge = EdgeFrom(Cell(row, col), dir, stride);
+    return (flags[edge >> 1] & ((edge & 1) ? CHOKE_BRIDGE_DOWN : CHOKE_BRIDGE_RIGHT)) != 0;
+}
+
+int ChokepointMap::EdgeBlock(int row, int col, int dir) const {
+    return edgeBlock[EdgeFrom(Cell(row, col), dir, stride)];
+}
+
+//-----------------------------------------------------------------------------
+// Analysis Functions
+//-----------------------------------------------------------------------------
+
+// Iterative Tarjan DFS over the region holding root. Tree and back edges go on
+// the edge stack as they are found; when a child's subtree cannot reach above
+// its parent, the edges pushed since the tree edge form one block and the
+// parent is an articulation point (the root only if it has several children).
+// With the start as root, a parent that cuts off a subtree holding the exit
+// also separates the exit from the start. The arrays are used through plain
+// pointers: nextDir is a byte array, and stores through it would otherwise
+// make the compiler reload every vector of the map.
+static void SearchRegion(ChokepointMap& map, const uint8_t* open, int root, int& time) {
+    const int offsets[4] = { -map.stride, 1, map.stride, -1 };
+    int* order = map.order.data();
+    int* low = map.low.data();
+    int* parent = map.parent.data();
+    uint8_t* nextDir = map.nextDir.data();
+    uint8_t* flags = map.flags.data();
+    int* edgeBlock = map.edgeBlock.data();
+    int* stack = map.stack.data();
+    int* edgeStack = map.edgeStack.data();
+    const int start = map.start, exit = map.exit;
+    int depth = 0, edges = 0, rootChildren = 0;
+    map.regions++;
+    order[root] = low[root] = ++time;
+    parent[root] = -1;
+    stack[depth++] = root;
+    while (depth > 0) {
+        int v = stack[depth - 1];
+        if (nextDir[v] < 4) {
+            int w = v + offsets[nextDir[v]++];
+            if (!open[w] || w == parent[v])
+                continue;
+            if (!order[w]) {
+                order[w] = low[w] = ++time;
+                parent[w] = v;
+                rootChildren += v == root;
+                edgeStack[edges++] = EdgeBetween(v, w);
+                stack[depth++] = w;
+            }
+            else if (order[w] < order[v]) {
+                low[v] = (std::min)(low[v], order[w]);
+                edgeStack[edges++] = EdgeBetween(v, w);
+            }
+            continue;
+        }
+
+        depth--;
+        int p = parent[v];
+        if (p < 0)
+            continue;
+        low[p] = (std::min)(low[p], low[v]);
+        if (low[v] < order[p])
+            continue;
+
+        int tree = EdgeBetween(p, v);
+        int block = map.blocks++;
+        int edge;
+        do {
+            edge = edgeStack[--edges];
+            edgeBlock[edge] = block;
+        } while (edge != tree);
+        if (low[v] > order[p]) {
+            flags[tree >> 1] |= (tree & 1) ? CHOKE_BRIDGE_DOWN : CHOKE_BRIDGE_RIGHT;
+            map.bridges++;
+        }
+        if (p == root)
+            continue;
+        if (!(flags[p] & CHOKE_ARTICULATION)) {
+            flags[p] |= CHOKE_ARTICULATION;
+            map.articulationPoints++;
+        }
+        // Descendants of v are exactly the cells found since v.
+        if (root == start && order[exit] >= order[v] && !(flags[p] & CHOKE_ROUTE_CUT)) {
+            flags[p] |= CHOKE_ROUTE_CUT;
+            map.routeCuts++;
+        }
+    }
+    if (rootChildren > 1) {
+        flags[root] |= CHOKE_ARTICULATION;
+        map.articulationPoints++;
+    }
+}
+
+void AnalyzeChokepoints(ChokepointMap& map, const std::vector<uint8_t>& open, int rows, int cols) {
+    map.rows = rows;
+    map.cols = cols;
+    map.stride = cols + 2;
+    map.start = map.stride + 1;
+    map.exit = rows * map.stride + cols;
+    map.connected = false;
+    map.regions = map.articulationPoints = map.bridges = map.blocks = map.routeCuts = 0;
+    size_t size = (size_t)(rows + 2) * map.stride;
+    map.flags.assign(size, 0);
+    map.edgeBlock.assign(2 * size, CHOKE_NO_BLOCK);
+    map.order.assign(size, 0);
+    map.low.resize(size);
+    map.parent.resize(size);
+    map.nextDir.assign(size, 0);
+    map.stack.resize(size);         // deepest DFS: every cell
+    map.edgeStack.resize(2 * size); // every edge
+    if (rows <= 0 || cols <= 0)
+        return;
+
+    // The start's region goes first, so route cuts come from its DFS tree.
+    int time = 0;
+    if (open[map.start]) {
+        SearchRegion(map, open.data(), map.start, time);
+        map.connected = map.order[map.exit] != 0;
+    }
+    for (size_t i = 0; i < size; i++)
+        if (open[i] && !map.order[i])
+            SearchRegion(map, open.data(), (int)i, time);
+}
+
+ChokepointMap AnalyzeChokepoints(const std::vector<std::vector<int>>& grid, unsigned blockedCells) {
+    ChokepointMap map;
+    if (grid.empty() || grid[0].empty())
+        return map;
+    int rows = grid.size(), cols = grid[0].size();
+    std::vector<uint8_t> open((size_t)(rows + 2) * (cols + 2), 0);
+    for (int r = 0; r < rows; r++)
+        for (int c = 0; c < cols; c++)
+            open[(r + 1) * (cols + 2) + c + 1] = (uint8_t)!((blockedCells >> (grid[r][c] & 31)) & 1);
+    AnalyzeChokepoints(map, open, rows, cols);
+    return map;
+}
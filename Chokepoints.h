@@ -0,0 +1,75 @@
+// Chokepoints.h : articulation points, bridges and biconnected components
+//
+// The analysis treats a level as a graph: passable cells are nodes, and
+// orthogonal neighbours that are both passable share an edge. One DFS per
+// connected region (Tarjan's low-link method) finds, in time linear in the
+// cell count:
+//   - articulation points: cells that split their region when blocked,
+//   - bridges: moves that are the only link between two parts of a region,
+//   - biconnected components (blocks): maximal groups of edges where any two
+//     lie on a common cycle, so no single cell can cut one off from another,
+//   - route cuts: the articulation points that separate the start from the
+//     exit, which every route between them passes.
+// Putting an OBSTACLE on a route cut seals the exit; putting a HAZARD there
+// forces the player through it; the difficulty search (LevelSearch.h) counts
+// them this way when LevelSearchOptions::routeCuts is set. The DFS keeps its
+// own stack, so very large levels cannot overflow the call stack.
+//
+// Cells are stored flat with a one-cell closed border, as in LevelSearch.cpp:
+// cell (row, col) is at (row + 1) * stride + col + 1, stride = cols + 2.
+
+#pragma once
+
+#include "MazeGame.h"
+
+// Per-cell flags.
+#define CHOKE_ARTICULATION  1   // blocking the cell splits its region
+#define CHOKE_ROUTE_CUT     2   // every start-to-exit route passes the cell
+#define CHOKE_BRIDGE_RIGHT  4   // the edge to the right neighbour is a bridge
+#define CHOKE_BRIDGE_DOWN   8   // the edge to the neighbour below is a bridge
+
+#define CHOKE_NO_BLOCK -1       // block of a missing edge
+
+// Cell values that are not nodes of the graph, as a mask of 1 << value.
+#define CHOKE_BLOCKING_CELLS ((1u << WALL) | (1u << OBSTACLE))
+
+struct ChokepointMap {
+    int rows = 0;
+    int cols = 0;
+    int stride = 0;
+    int start = 0;                  // cell (0, 0)
+    int exit = 0;                   // cell (rows - 1, cols - 1)
+    bool connected = false;         // the exit is reachable from the start
+    int regions = 0;                // connected regions of passable cells
+    int articulationPoints = 0;
+    int bridges = 0;
+    int blocks = 0;
+    int routeCuts = 0;              // the start and exit are not counted
+    std::vector<uint8_t> flags;     // CHOKE_* per cell
+    std::vector<int> edgeBlock;     // 2 per cell: block of the right and down edge
+
+    int Cell(int row, int col) const { return (row + 1) * stride + col + 1; }
+    bool IsArticulation(int row, int col) const { return (flags[Cell(row, col)] & CHOKE_ARTICULATION) != 0; }
+    bool IsRouteCut(int row, int col) const { return (flags[Cell(row, col)] & CHOKE_ROUTE_CUT) != 0; }
+
+    // Whether the move from (row, col) in direction dir (see MoveDirectionIndex)
+    // crosses a bridge, and which block that edge belongs to.
+    bool IsBridge(int row, int col, int dir) const;
+    int EdgeBlock(int row, int col, int dir) const;
+
+    // DFS scratch, kept so repeated analyses do not allocate.
+    std::vector<int> order;         // discovery time, 0 = not visited
+    std::vector<int> low;
+    std::vector<int> parent;
+    std::vector<uint8_t> nextDir;
+    std::vector<int> stack;
+    std::vector<int> edgeStack;
+};
+
+// Analyze the cells of grid whose value is not in blockedCells.
+ChokepointMap AnalyzeChokepoints(const std::vector<std::vector<int>>& grid,
+                                 unsigned blockedCells = CHOKE_BLOCKING_CELLS);
+
+// Analyze a flat bordered layout directly: open[i] != 0 for passable cells,
+// with the border closed. Reuses the map's storage.
+void AnalyzeChokepoints(ChokepointMap& map, const std::vector<uint8_t>& open, int rows, int cols);
@@ -9,77 +9,126 @@
 #include <thread>
 #include <ctime>
 #include <cstdlib>
+#include <cstdio>
 #include <string>
+#include <algorithm>
 #include <fstream>     // For file I/O
+#include "MazeGame.h"
+#include "GameSession.h"
+#include "BakedLevels.h"
+#include "LevelCodec.h"
+#include "Minimap.h"
+#include "NearestItem.h"
+#include "FieldOfView.h"
+#include "EntitySystem.h"
+#include "SaveFile.h"
+#include "Autosave.h"
+#include "InputRecording.h"
+#include "SimulationClock.h"
+#include "AudioEngine.h"
+#include "AssetArchive.h"
+#include "HighScores.h"
+#include "Tracing.h"
+#include "Resource.h"
+#include <shellapi.h>
+#include <chrono>
 
 // Link with winmm.lib for multimedia functions
 #pragma comment(lib, "winmm.lib")
 
-// Constants for maze and window dimensions
+// Constants for window dimensions (grid size and cell values live in MazeGame.h)
 #define CELL_SIZE 50
-#define GRID_ROWS 10
-#define GRID_COLS 10
-#define TIMER_ID 1
-#define TIMER_INTERVAL 1000
-
-// Total levels
-#define TOTAL_LEVELS 5
-
-// --- Cell values ---
-// For better readability, define symbolic names for cell values.
-enum CellType {
-    PASSAGE = 0,    // empty (used for start/end)
-    WALL = 1,
-    COLLECTIBLE = 2, // collectible: adds one life
-    HAZARD = 3,      // harmful hurdle: subtracts life and time
-    OBSTACLE = 4,    // blocks movement
-    MINIDOT = 5      // safe passage with a mini-dot (score available)
-};
+
+// Minimap placed under the HUD text.
+#define MINIMAP_SIZE 120
 
 // --- Game States ---
 enum GameState {
     MENU,
-    PLAYING
+    PLAYING,
+    PAUSED,     // game drawn under a pause panel until P or Esc
+    MESSAGE     // a notification waits to be dismissed
 };
 GameState currentState = MENU;
 
-// Maze cell structure for generating the maze.
-struct MazeCell {
-    bool visited = false;
-    bool top = true, bottom = true, left = true, right = true;
+// Notifications are drawn over the screen they were raised on, so the main
+// loop keeps pumping messages and rendering while one is up. The simulation
+// only ticks in PLAYING, which freezes the level timer meanwhile.
+struct Notification {
+    std::wstring title;
+    std::wstring text;
+    bool quitOnDismiss;
 };
+std::queue<Notification> notifications;
+GameState stateBeforeMessage = MENU;    // screen under the notification
 
 // Global variables
 HINSTANCE hInst;
 HWND hWndMain;
 
-// Player state: starting at (0,0) and ending at (9,9)
-POINT playerPosition = { 0, 0 };
-POINT endPosition = { GRID_COLS - 1, GRID_ROWS - 1 };
+// The game being played: levels, player state and rules (see GameSession.h).
+GameSession session;
 
-// Game state variables
-int currentLevel = 0;
-int lives = 2;      // Player starts with 2 lives.
-int timeLeft = 15;  // 15-second timer per level.
-int score = 0;      // Score increases by 1 for every mini-dot collected.
-
-// Global flags for pausing and one-time messages.
-bool g_paused = false;
+// Global flags for one-time messages.
 bool g_timeOverShown = false;
 bool g_hazardShown = false;
 bool isPlayingBackgroundMusic = true;
 
-// Container for maze levels; each level is a 2D vector (grid) of integers.
-std::vector<std::vector<std::vector<int>>> levels;
+// Occupancy pyramid per level, used to draw the minimap.
+std::vector<OccupancyPyramid> levelPyramids;
+
+// Nearest-item fields per level, used to point out the closest diamond.
+std::vector<LevelItemIndex> levelItems;
+
+// Line of sight and explored cells per level; 'F' toggles the fog of war.
+std::vector<FogOfWar> levelFogs;
+bool fogOfWar = false;
+
+// Roaming hazards and chasers of the current level, moved every
+// ENTITY_STEP_TICKS; chasers follow a flow field towards the player.
+#define ENTITY_STEP_TICKS (SIM_TICK_RATE / 2)
+EntityStore roamingHazards;
+FlowField hazardFlow;
+int hazardLevel = -1;                   // level the hazards were spawned for
+int hazardTicks = 0;
+
+// Journaled autosave, toggled with the 'A' key.
+AutosaveJournal autosave;
+bool autosaveEnabled = false;
+
+// Input stream of the current game, for headless replay.
+InputRecorder recorder;
 
-// For undo functionality (if desired)
-std::stack<POINT> playerMoveHistory;
+// Fixed-timestep simulation clock driving the game loop; the level countdown
+// runs on it as one of the per-tick systems.
+SimulationClock simClock;
+int countdownTicks = 0;                 // ticks since the last countdown second
+std::queue<GameAction> pendingActions;  // moves, undos and redos waiting for the next tick
+POINT previousPlayerPosition = { 0, 0 }; // position at the previous tick, for interpolation
+int previousLevel = 0;
+bool showFrameStats = false;            // F3 toggles the loop instrumentation
+int campaign = -1;                      // baked level set chosen with "/campaign <n>", or -1
+std::string startLevelCode;             // share code given with "/level <code>", played at startup
+
+// Best score per (level seed, player), kept in highscores.dat.
+HighScoreStore highScores;
+
+// Sounds, music and icons packed by MazeTool's PackAssets build step; mapped
+// once for the whole run. Loose files are used when it is missing.
+AssetArchive assets;
+
+// Sound effects are decoded once at startup. All playback, including the
+// music, runs on the audio engine's thread; the game only posts commands.
+SoundBank soundBank;
+WaveOutSink audioOut;
+MciMusicBackend musicPlayer({ L"background 01.mp3", L"background 02.mp3" });
+AudioEngine audio;
 
 // Forward declarations for functions defined later.
 LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
 std::wstring ConvertToWString(int number);
 void PlayGameSound(const std::wstring& soundFile);     // GF1
-void PlayBackgroundMusic(const std::wstring& soundFile); // GF2
+void PlayBackgroundMusic(int track);                     // GF2
 void StopBackgroundMusic();                              // GF3
 
 // Menu drawing and mouse click handling.
@@ -89,245 +138,180 @@ void HandleMenuClick(int x, int y);
 // File handling for saving and loading game state.
 void SaveGameState();
 bool LoadGameState();
+void RestartAutosave();
 
-//-----------------------------------------------------
-// Maze Generation Functions
-//-----------------------------------------------------
+// Recast the player's line of sight if they moved since the last call.
+void RevealAroundPlayer() {
+    UpdateFogOfWar(levelFogs[session.currentLevel], session.levels[session.currentLevel], session.playerPosition);
+}
 
-// Initialize a 2D vector of MazeCell objects.
-std::vector<std::vector<MazeCell>> InitializeMazeCells(int rows, int cols) {
-    return std::vector<std::vector<MazeCell>>(rows, std::vector<MazeCell>(cols));
-}
-
-// Remove wall between two adjacent cells.
-void RemoveWall(MazeCell& current, MazeCell& next, int dx, int dy) {
-    if (dx == 1) {
-        current.right = false;
-        next.left = false;
-    }
-    else if (dx == -1) {
-        current.left = false;
-        next.right = false;
-    }
-    else if (dy == 1) {
-        current.bottom = false;
-        next.top = false;
-    }
-    else if (dy == -1) {
-        current.top = false;
-        next.bottom = false;
-    }
-}
-
-// Maze generation using DFS (iterative with a stack).
-void GenerateMazeDFS(std::vector<std::vector<MazeCell>>& maze, int startRow, int startCol) {
-    int rows = maze.size(), cols = maze[0].size();
-    std::stack<POINT> cellStack;
-    maze[startRow][startCol].visited = true;
-    cellStack.push({ startCol, startRow });
-    std::vector<POINT> directions = { {0, -1}, {1, 0}, {0, 1}, {-1, 0} };
-    while (!cellStack.empty()) {
-        POINT current = cellStack.top();
-        int curRow = current.y, curCol = current.x;
-        std::vector<POINT> neighbors;
-        for (auto dir : directions) {
-            int newRow = curRow + dir.y, newCol = curCol + dir.x;
-            if (newRow >= 0 && newRow < rows && newCol >= 0 && newCol < cols &&
-                !maze[newRow][newCol].visited) {
-                neighbors.push_back(dir);
-            }
-        }
-        if (!neighbors.empty()) {
-            int index = rand() % neighbors.size();
-            POINT chosen = neighbors[index];
-            int newRow = curRow + chosen.y, newCol = curCol + chosen.x;
-            RemoveWall(maze[curRow][curCol], maze[newRow][newCol], chosen.x, chosen.y);
-            maze[newRow][newCol].visited = true;
-            cellStack.push({ newCol, newRow });
-        }
-        else {
-            cellStack.pop();
-        }
-    }
+// Spawn the current level's roaming hazards: one roamer per level after the
+// first and a chaser every second level, the same for every play of a seed.
+void SpawnLevelHazards() {
+    hazardLevel = session.currentLevel;
+    hazardTicks = 0;
+    roamingHazards.Clear();
+    BuildFlowField(hazardFlow, session.levels[hazardLevel]);
+    MazeRng rng(session.seed ^ (0x9E3779B9u * (uint32_t)(hazardLevel + 1)));
+    SpawnEntities(roamingHazards, hazardFlow, hazardLevel, hazardLevel / 2, 4, rng);
 }
 
-// Convert the MazeCell grid to a grid of integers.
-// Initially mark passages as PASSAGE.
-std::vector<std::vector<int>> ConvertMazeToGrid(const std::vector<std::vector<MazeCell>>& maze) {
-    int rows = maze.size(), cols = maze[0].size();
-    std::vector<std::vector<int>> grid(rows, std::vector<int>(cols, WALL));
-    for (int r = 0; r < rows; r++)
-        for (int c = 0; c < cols; c++)
-            if (!maze[r][c].top || !maze[r][c].bottom || !maze[r][c].left || !maze[r][c].right || maze[r][c].visited)
-                grid[r][c] = PASSAGE;
-    grid[0][0] = PASSAGE;
-    grid[rows - 1][cols - 1] = PASSAGE;
-    return grid;
-}
-
-// Check if there is a valid path from start to end using BFS.
-bool IsPathValid(const std::vector<std::vector<int>>& grid) {
-    int rows = grid.size(), cols = grid[0].size();
-    std::vector<std::vector<bool>> visited(rows, std::vector<bool>(cols, false));
-    std::queue<POINT> q;
-    POINT start = { 0, 0 }, end = { cols - 1, rows - 1 };
-    q.push(start);
-    visited[start.y][start.x] = true;
-    std::vector<POINT> directions = { {0, -1}, {1, 0}, {0, 1}, {-1, 0} };
-    while (!q.empty()) {
-        POINT cur = q.front();
-        q.pop();
-        if (cur.x == end.x && cur.y == end.y)
-            return true;
-        for (auto d : directions) {
-            int nx = cur.x + d.x, ny = cur.y + d.y;
-            if (nx >= 0 && nx < cols && ny >= 0 && ny < rows &&
-                !visited[ny][nx] && grid[ny][nx] == PASSAGE) {
-                visited[ny][nx] = true;
-                q.push({ nx, ny });
-            }
-        }
-    }
-    return false;
-}
-
-// Get one valid path from start to end using BFS with predecessor tracking.
-std::vector<POINT> GetValidPath(const std::vector<std::vector<int>>& grid) {
-    int rows = grid.size(), cols = grid[0].size();
-    std::vector<std::vector<bool>> visited(rows, std::vector<bool>(cols, false));
-    std::vector<std::vector<POINT>> parent(rows, std::vector<POINT>(cols, { -1, -1 }));
-    std::queue<POINT> q;
-    POINT start = { 0, 0 }, end = { cols - 1, rows - 1 };
-    q.push(start);
-    visited[start.y][start.x] = true;
-    std::vector<POINT> directions = { {0, -1}, {1, 0}, {0, 1}, {-1, 0} };
-    bool found = false;
-    while (!q.empty() && !found) {
-        POINT cur = q.front();
-        q.pop();
-        if (cur.x == end.x && cur.y == end.y) {
-            found = true;
-            break;
-        }
-        for (auto d : directions) {
-            int nx = cur.x + d.x, ny = cur.y + d.y;
-            if (nx >= 0 && nx < cols && ny >= 0 && ny < rows &&
-                !visited[ny][nx] && grid[ny][nx] == PASSAGE) {
-                visited[ny][nx] = true;
-                parent[ny][nx] = cur;
-                q.push({ nx, ny });
-            }
-        }
-    }
-    std::vector<POINT> path;
-    if (found) {
-        POINT cur = end;
-        while (!(cur.x == start.x && cur.y == start.y)) {
-            path.push_back(cur);
-            cur = parent[cur.y][cur.x];
-        }
-        path.push_back(start);
-    }
-    return path;
-}
-
-// Decorate the maze: for every PASSAGE cell not on the valid path,
-// randomly change it to COLLECTIBLE, HAZARD, or OBSTACLE. Then convert remaining PASSAGE cells to MINIDOT.
-void DecorateMaze(std::vector<std::vector<int>>& grid) {
-    int rows = grid.size(), cols = grid[0].size();
-    std::vector<POINT> validPath = GetValidPath(grid);
-    std::vector<std::vector<bool>> isValidPath(rows, std::vector<bool>(cols, false));
-    for (auto p : validPath)
-        isValidPath[p.y][p.x] = true;
-    for (int r = 0; r < rows; r++) {
-        for (int c = 0; c < cols; c++) {
-            if (grid[r][c] == PASSAGE && !isValidPath[r][c]) {
-                if ((r == 0 && c == 0) || (r == rows - 1 && c == cols - 1))
-                    continue;
-                int randVal = rand() % 100;
-                if (randVal < 5)
-                    grid[r][c] = COLLECTIBLE;
-                else if (randVal < 15)
-                    grid[r][c] = HAZARD;
-                else if (randVal < 35)
-                    grid[r][c] = OBSTACLE;
-            }
-        }
+// Rebuild the minimap pyramids, nearest-item fields, fog and roaming hazards
+// after levels were generated or loaded.
+void RebuildLevelViews() {
+    levelPyramids.clear();
+    levelItems.clear();
+    levelFogs.clear();
+    for (const auto& grid : session.levels) {
+        levelPyramids.push_back(BuildOccupancyPyramid(grid));
+        levelItems.push_back(BuildLevelItemIndex(grid));
+        levelFogs.push_back(CreateFogOfWar(grid.size(), grid[0].size()));
     }
-    for (int r = 0; r < rows; r++)
-        for (int c = 0; c < cols; c++)
-            if (grid[r][c] == PASSAGE)
-                grid[r][c] = MINIDOT;
+    RevealAroundPlayer();
+    SpawnLevelHazards();
 }
 
-// Generate one valid maze level and decorate it.
-std::vector<std::vector<int>> GenerateRandomMazeLevel() {
-    while (true) {
-        auto mazeCells = InitializeMazeCells(GRID_ROWS, GRID_COLS);
-        GenerateMazeDFS(mazeCells, 0, 0);
-        auto grid = ConvertMazeToGrid(mazeCells);
-        if (IsPathValid(grid)) {
-            DecorateMaze(grid);
-            grid[0][0] = PASSAGE;
-            grid[GRID_ROWS - 1][GRID_COLS - 1] = PASSAGE;
-            return grid;
-        }
-    }
+// Patch the per-level views after one cell of a level changed.
+void UpdateLevelViews(int level, int row, int col, int oldValue, int newValue) {
+    UpdateOccupancyPyramid(levelPyramids[level], row, col, oldValue, newValue);
+    UpdateLevelItemIndex(levelItems[level], session.levels[level], row, col, oldValue, newValue);
 }
 
-// Generate all levels.
-void GenerateRandomLevels() {
-    levels.clear();
-    for (int i = 0; i < TOTAL_LEVELS; i++) {
-        levels.push_back(GenerateRandomMazeLevel());
-    }
-    currentLevel = 0;
+// Pick a fresh seed for a new game; in campaign mode, the campaign's seed,
+// whose levels need no generating.
+uint32_t NewLevelSeed() {
+    if (campaign >= 0)
+        return GetBakedCampaign(campaign).seed;
+    return ((uint32_t)rand() << 16) ^ (uint32_t)rand() ^ (uint32_t)time(NULL);
 }
 
 //-----------------------------------------------------
 // File Handling Functions
 //-----------------------------------------------------
+// Replace the current game with a loaded one.
+void ApplySaveData(const SaveGameData& data) {
+    session.LoadSaveData(data);
+    RebuildLevelViews();
+}
+
+// Saves are written in the binary format from SaveFile.h and cover every level.
 void SaveGameState() {
-    std::ofstream ofs("savegame.dat");
-    if (!ofs)
+    TRACE_SCOPE("SaveGameState");
+    WriteBinarySave("savegame.dat", session.ToSaveData());
+}
+
+// Put the current level on the clipboard as a share code (LevelCodec.h).
+void CopyLevelShareCode() {
+    std::string code = LevelToShareCode(session.levels[session.currentLevel]);
+    if (code.empty() || !OpenClipboard(hWndMain))
         return;
-    ofs << currentLevel << "\n"
-        << lives << "\n"
-        << timeLeft << "\n"
-        << score << "\n"
-        << playerPosition.x << " " << playerPosition.y << "\n";
-    const auto& grid = levels[currentLevel];
-    int rows = grid.size(), cols = grid[0].size();
-    ofs << rows << " " << cols << "\n";
-    for (int r = 0; r < rows; r++) {
-        for (int c = 0; c < cols; c++) {
-            ofs << grid[r][c] << " ";
-        }
-        ofs << "\n";
+    EmptyClipboard();
+    HGLOBAL text = GlobalAlloc(GMEM_MOVEABLE, code.size() + 1);
+    if (text) {
+        memcpy(GlobalLock(text), code.c_str(), code.size() + 1);
+        GlobalUnlock(text);
+        if (!SetClipboardData(CF_TEXT, text))
+            GlobalFree(text);
     }
-    ofs.close();
+    CloseClipboard();
 }
 
-bool LoadGameState() {
+// Replace the current level with a shared one and restart it. A shared
+// level is not part of the seed, so the input recording ends here.
+bool LoadLevelShareCode(const std::string& code) {
+    std::vector<std::vector<int>> grid;
+    if (!LevelFromShareCode(code, grid, GRID_ROWS, GRID_COLS) || !session.LoadSharedLevel(grid))
+        return false;
+    recorder.Finish(session.StateHash());
+    RebuildLevelViews();
+    countdownTicks = 0;
+    previousPlayerPosition = session.playerPosition;
+    previousLevel = session.currentLevel;
+    RestartAutosave();
+    InvalidateRect(hWndMain, NULL, TRUE);
+    return true;
+}
+
+// Older text saves: the current level only, whitespace-separated ints. The
+// level, its size and the player are checked before anything is replaced,
+// and the undo history of the previous game is dropped.
+bool LoadTextGameState() {
     std::ifstream ifs("savegame.dat");
     if (!ifs)
         return false;
-    ifs >> currentLevel >> lives >> timeLeft >> score;
-    ifs >> playerPosition.x >> playerPosition.y;
+    int level, lives, timeLeft, score;
+    POINT position;
     int rows, cols;
+    ifs >> level >> lives >> timeLeft >> score;
+    ifs >> position.x >> position.y;
     ifs >> rows >> cols;
+    if (!ifs || level < 0 || level > (int)session.levels.size() || rows != GRID_ROWS || cols != GRID_COLS
+        || position.x < 0 || position.x >= cols || position.y < 0 || position.y >= rows)
+        return false;
     std::vector<std::vector<int>> grid(rows, std::vector<int>(cols));
     for (int r = 0; r < rows; r++)
         for (int c = 0; c < cols; c++)
             ifs >> grid[r][c];
+    if (!ifs)
+        return false;
     ifs.close();
-    if (currentLevel < levels.size())
-        levels[currentLevel] = grid;
+    session.currentLevel = level;
+    session.lives = lives;
+    session.timeLeft = timeLeft;
+    session.score = score;
+    session.playerPosition = position;
+    if (level < (int)session.levels.size())
+        session.levels[level] = grid;
     else
-        levels.push_back(grid);
+        session.levels.push_back(grid);
+    session.teleporters = BuildTeleportNetwork(session.levels);
+    session.history.Clear();
+    RebuildLevelViews();
+    return true;
+}
+
+bool LoadGameState() {
+    TRACE_SCOPE("LoadGameState");
+    if (!BinarySaveView::HasBinaryMagic("savegame.dat"))
+        return LoadTextGameState();
+    BinarySaveView save;
+    SaveGameData data;
+    if (!save.Open("savegame.dat") || !save.ToSaveData(data))
+        return false;
+    ApplySaveData(data);
+    return true;
+}
+
+//-----------------------------------------------------
+// Autosave Functions
+//-----------------------------------------------------
+
+// (Re)start the journal from the current state when autosave mode is on.
+void RestartAutosave() {
+    if (autosaveEnabled)
+        autosave.Start("autosave.dat", "autosave.log", session.ToSaveData());
+    SetWindowText(hWndMain, autosaveEnabled ? L"Maze Game - Autosave on" : L"Maze Game");
+}
+
+// Resume the game recorded by the autosave snapshot and its move log.
+bool RecoverAutosaveState() {
+    SaveGameData data;
+    if (!RecoverAutosave("autosave.dat", "autosave.log", data))
+        return false;
+    ApplySaveData(data);
     return true;
 }
 
+// Append the step the session just took to the autosave journal. A step
+// whose change does not fit a record is saved as a fresh snapshot instead.
+void JournalLastStep(StepResult result) {
+    if (!autosave.IsRunning() || result == STEP_BLOCKED)
+        return;
+    const UndoDelta* step = session.LastStep();
+    if (!step || autosave.Append(MoveRecordFromStep(*step)))
+        autosave.Compact(session.ToSaveData());
+}
+
 //-----------------------------------------------------
 // Sound and Utility Functions
 //-----------------------------------------------------
@@ -337,34 +321,234 @@ std::wstring ConvertToWString(int number) {
     return ss.str();
 }
 
+// MCI can only play files, so a music track from the archive is written once
+// to the temp directory under its content hash and reused on later runs.
+// Returns an empty string on failure.
+std::wstring ExtractMusicTrack(const AssetView& view) {
+    char tempPath[MAX_PATH];
+    if (GetTempPathA(MAX_PATH, tempPath) == 0)
+        return L"";
+    std::string dir = std::string(tempPath) + "MazeGame";
+    CreateDirectoryA(dir.c_str(), nullptr);
+    char hash[17];
+    sprintf_s(hash, "%016llx", (unsigned long long)AssetHash(view.data, view.size));
+    std::string path = dir + "\\" + hash + ".mp3";
+    if (GetFileAttributesA(path.c_str()) == INVALID_FILE_ATTRIBUTES) {
+        std::ofstream out(path, std::ios::binary);
+        out.write((const char*)view.data, view.size);
+        if (!out)
+            return L"";
+    }
+    wchar_t widePath[MAX_PATH];
+    MultiByteToWideChar(CP_ACP, 0, path.c_str(), -1, widePath, MAX_PATH);
+    return widePath;
+}
+
+// Decode every sound effect into the bank, open the output device and start
+// the audio thread. About 60 ms of audio is kept queued on the device. Clips
+// from the archive play straight out of the mapping without a copy.
+void StartAudio() {
+    const char* files[] = { "hazard01.wav", "lvl.wav", "mov.wav", "powerup.wav", "thrill01.wav", "win01.wav" };
+    for (const char* file : files) {
+        AssetView view;
+        if (assets.Find(file, view) && soundBank.LoadView(file, view.data, view.size))
+            continue;
+        soundBank.LoadFile(file, file);
+    }
+    const char* tracks[] = { "background 01.mp3", "background 02.mp3" };
+    for (int i = 0; i < 2; i++) {
+        AssetView view;
+        std::wstring path;
+        if (assets.Find(tracks[i], view) && !(path = ExtractMusicTrack(view)).empty())
+            musicPlayer.SetFile(i, path);
+    }
+    audioOut.Open(6, 441);
+    audio.Start(audioOut.IsOpen() ? &audioOut : nullptr, &musicPlayer);
+}
+
+// Effects overlap instead of cutting each other off. Without a device or a
+// decoded clip, fall back to PlaySound.
 void PlayGameSound(const std::wstring& soundFile) {
-    PlaySound(soundFile.c_str(), NULL, SND_FILENAME | SND_ASYNC);
+    TRACE_SCOPE("PlayGameSound");
+    char name[MAX_PATH];
+    WideCharToMultiByte(CP_ACP, 0, soundFile.c_str(), -1, name, MAX_PATH, nullptr, nullptr);
+    const SoundClip* clip = soundBank.Find(name);
+    if (!audioOut.IsOpen() || !clip) {
+        PlaySound(soundFile.c_str(), NULL, SND_FILENAME | SND_ASYNC);
+        return;
+    }
+    audio.PlayEffect(clip);
 }
 
-void PlayBackgroundMusic(const std::wstring& soundFile) {
-    std::wstring command = L"open \"" + soundFile + L"\" type mpegvideo alias bgm";
-    mciSendString(command.c_str(), nullptr, 0, nullptr);
-    mciSendString(L"play bgm repeat", nullptr, 0, nullptr);
+// Track 0 is "background 01.mp3", track 1 "background 02.mp3". Switching
+// tracks crossfades over two seconds.
+void PlayBackgroundMusic(int track) {
+    audio.CrossfadeMusic(track, 2000);
 }
 
 void StopBackgroundMusic() {
-    mciSendString(L"stop bgm", nullptr, 0, nullptr);
-    mciSendString(L"close bgm", nullptr, 0, nullptr);
+    audio.StopMusic();
+}
+
+// Player name for the high-score table: the Windows user name.
+std::string PlayerName() {
+    char name[HIGHSCORE_NAME_SIZE];
+    DWORD length = GetEnvironmentVariableA("USERNAME", name, sizeof(name));
+    return length > 0 && length < sizeof(name) ? std::string(name) : std::string("Player");
+}
+
+// Record the finished game's score and describe where it placed.
+std::wstring RecordHighScore() {
+    std::string name = PlayerName();
+    highScores.Submit(session.seed, name, session.score);
+    long long rank = highScores.Table().Rank(session.seed, name);
+    return L"\nScore " + ConvertToWString(session.score) + L", rank #" + ConvertToWString((int)rank + 1) +
+        L" of " + ConvertToWString((int)highScores.Table().Count()) + L".";
+}
+
+// Queue a notification; it shows once those before it are dismissed.
+void ShowNotification(LPCWSTR message, LPCWSTR title, bool quitOnDismiss = false) {
+    notifications.push({ title, message, quitOnDismiss });
+    if (currentState != MESSAGE) {
+        stateBeforeMessage = currentState;
+        currentState = MESSAGE;
+    }
+    InvalidateRect(hWndMain, NULL, TRUE);
+}
+
+// Close the front notification and return to the screen under it once the
+// queue is empty.
+void DismissNotification() {
+    if (notifications.empty())
+        return;
+    bool quit = notifications.front().quitOnDismiss;
+    notifications.pop();
+    if (quit) {
+        PostQuitMessage(0);
+        return;
+    }
+    if (notifications.empty())
+        currentState = stateBeforeMessage;
+    InvalidateRect(hWndMain, NULL, TRUE);
 }
 
-void ShowPausedMessage(LPCWSTR message, LPCWSTR title) {
-    KillTimer(hWndMain, TIMER_ID);
-    MessageBox(hWndMain, message, title, MB_OK);
-    SetTimer(hWndMain, TIMER_ID, TIMER_INTERVAL, NULL);
+void TogglePause() {
+    currentState = currentState == PAUSED ? PLAYING : PAUSED;
+    InvalidateRect(hWndMain, NULL, TRUE);
+}
+
+// Start recording spans (Tracing.h), or stop and write them for Perfetto.
+void ToggleTracing() {
+    if (!TracingEnabled()) {
+        EnableTracing(true);
+        return;
+    }
+    EnableTracing(false);
+    if (WriteChromeTrace("trace.json"))
+        ShowNotification(L"Trace written to trace.json. Open it at ui.perfetto.dev.", L"Tracing");
+    else
+        ShowNotification(L"Could not write trace.json.", L"Tracing");
+}
+
+// Play the share code on the clipboard in place of the current level.
+void PasteLevelShareCode() {
+    std::string code;
+    if (OpenClipboard(hWndMain)) {
+        HANDLE text = GetClipboardData(CF_TEXT);
+        const char* chars = text ? (const char*)GlobalLock(text) : nullptr;
+        if (chars) {
+            code = chars;
+            GlobalUnlock(text);
+        }
+        CloseClipboard();
+    }
+    // Copied codes often pick up surrounding whitespace.
+    code.erase(0, code.find_first_not_of(" \t\r\n"));
+    code.erase(code.find_last_not_of(" \t\r\n") + 1);
+    if (!LoadLevelShareCode(code))
+        ShowNotification(L"The clipboard does not hold a share code for a level of this size.", L"Paste Level");
 }
 
 //-----------------------------------------------------
 // Drawing Functions: Game Screen and Menu Screen
 //-----------------------------------------------------
 
+// DrawMinimap: Draws the current level from the pyramid level that matches the
+// minimap size. Every node becomes one pixel of a small bitmap (its colour is the
+// density-weighted mix of its cells), which is then stretched into the rectangle.
+void DrawMinimap(HDC hdc, const RECT& rect) {
+    const OccupancyPyramid& pyramid = levelPyramids[session.currentLevel];
+    int width = rect.right - rect.left;
+    int height = rect.bottom - rect.top;
+    int k = SelectPyramidLevel(pyramid, width, height);
+    const PyramidLevel& level = pyramid.levels[k];
+    std::vector<DWORD> pixels(level.rows * level.cols);
+    for (int i = 0; i < (int)pixels.size(); i++) {
+        const OccupancyNode& node = level.nodes[i];
+        // Plain passages are white, walls black, hazards red and items gold.
+        int plain = node.passable - node.collectible;
+        int red = (plain * 255 + node.hazard * 255 + node.collectible * 255) / node.cells;
+        int green = (plain * 255 + node.collectible * 215) / node.cells;
+        int blue = (plain * 255) / node.cells;
+        pixels[i] = (red << 16) | (green << 8) | blue;
+    }
+    BITMAPINFO bmi = {};
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = level.cols;
+    bmi.bmiHeader.biHeight = -level.rows; // top-down rows
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+    SetStretchBltMode(hdc, COLORONCOLOR);
+    StretchDIBits(hdc, rect.left, rect.top, width, height,
+        0, 0, level.cols, level.rows, pixels.data(), &bmi, DIB_RGB_COLORS, SRCCOPY);
+    FrameRect(hdc, &rect, (HBRUSH)GetStockObject(BLACK_BRUSH));
+    // Mark the player position.
+    int gridCols = pyramid.levels[0].cols, gridRows = pyramid.levels[0].rows;
+    int px = rect.left + (session.playerPosition.x * width) / gridCols;
+    int py = rect.top + (session.playerPosition.y * height) / gridRows;
+    RECT playerRect = { px, py, px + (std::max)(width / gridCols, 3), py + (std::max)(height / gridRows, 3) };
+    HBRUSH playerBrush = CreateSolidBrush(RGB(0, 0, 255));
+    FillRect(hdc, &playerRect, playerBrush);
+    DeleteObject(playerBrush);
+}
+
+// DrawFrameStats: Draws the game loop instrumentation and the length of the
+// shortest route to the finish under the minimap.
+void DrawFrameStats(HDC hdc) {
+    FrameStats stats = simClock.Stats();
+    AudioLatencyStats audioStats = audio.Stats();
+    int route = session.RouteToFinish();
+    wchar_t text[448];
+    swprintf(text, 448,
+        L"Tick: %.1f us avg, %.1f us max\nFrame p50/p95/p99: %.1f / %.1f / %.1f ms\nMissed deadlines: %llu\nDropped ticks: %llu\n"
+        L"Audio enqueue: %.0f ns avg, %.0f ns max\nAudio dispatch: %.1f ms max, %llu dropped\nRoute to finish: %d moves",
+        stats.tickCostAvgUs, stats.tickCostMaxUs, stats.frameP50Ms, stats.frameP95Ms, stats.frameP99Ms,
+        (unsigned long long)stats.missedDeadlines, (unsigned long long)stats.droppedTicks,
+        audioStats.enqueueAvgNs, audioStats.enqueueMaxNs, audioStats.dispatchMaxMs, (unsigned long long)audioStats.dropped,
+        route);
+    HFONT hFont = CreateFont(
+        16, 0, 0, 0, FW_NORMAL,
+        FALSE, FALSE, FALSE,
+        DEFAULT_CHARSET,
+        OUT_DEFAULT_PRECIS,
+        CLIP_DEFAULT_PRECIS,
+        CLEARTYPE_QUALITY,
+        VARIABLE_PITCH,
+        L"Segoe UI"
+    );
+    HFONT oldFont = (HFONT)SelectObject(hdc, hFont);
+    RECT statsRect = { GRID_COLS * CELL_SIZE + 10, 170 + MINIMAP_SIZE, GRID_COLS * CELL_SIZE + 290, 310 + MINIMAP_SIZE };
+    SetBkMode(hdc, TRANSPARENT);
+    SetTextColor(hdc, RGB(0, 0, 0));
+    DrawText(hdc, text, -1, &statsRect, DT_LEFT | DT_TOP);
+    SelectObject(hdc, oldFont);
+    DeleteObject(hFont);
+}
+
 // DrawMaze: Draws the maze, the door at the end, the player, and the HUD.
 void DrawMaze(HDC hdc) {
-    const std::vector<std::vector<int>>& maze = levels[currentLevel];
+    const std::vector<std::vector<int>>& maze = session.levels[session.currentLevel];
     HFONT hFont = CreateFont(
         48, 0, 0, 0, FW_BOLD,
         FALSE, FALSE, FALSE,
@@ -376,8 +560,19 @@ void DrawMaze(HDC hdc) {
         L"Segoe UI Emoji"
     );
     HFONT oldFont = (HFONT)SelectObject(hdc, hFont);
+    // Under the fog one dark fill covers every unexplored cell, which are
+    // then skipped; explored cells out of sight are greyed.
+    const FogOfWar& fog = levelFogs[session.currentLevel];
+    if (fogOfWar) {
+        RECT mazeRect = { 0, 0, GRID_COLS * CELL_SIZE, GRID_ROWS * CELL_SIZE };
+        HBRUSH fogBrush = CreateSolidBrush(RGB(40, 40, 40));
+        FillRect(hdc, &mazeRect, fogBrush);
+        DeleteObject(fogBrush);
+    }
     for (int row = 0; row < GRID_ROWS; ++row) {
         for (int col = 0; col < GRID_COLS; ++col) {
+            if (fogOfWar && !fog.Explored(row, col))
+                continue;
             RECT cell = { col * CELL_SIZE, row * CELL_SIZE, (col + 1) * CELL_SIZE, (row + 1) * CELL_SIZE };
             if (maze[row][col] == WALL) {
                 HBRUSH wallBrush = CreateSolidBrush(RGB(0, 0, 0));
@@ -386,7 +581,8 @@ void DrawMaze(HDC hdc) {
             }
             else {
                 // Fill non-wall cells with plain white.
-                HBRUSH whiteBrush = CreateSolidBrush(RGB(255, 255, 255));
+                bool remembered = fogOfWar && !fog.Visible(row, col);
+                HBRUSH whiteBrush = CreateSolidBrush(remembered ? RGB(190, 190, 190) : RGB(255, 255, 255));
                 FillRect(hdc, &cell, whiteBrush);
                 DeleteObject(whiteBrush);
             }
@@ -411,6 +607,10 @@ void DrawMaze(HDC hdc) {
                 symbol = L"•";
                 symbolColor = RGB(255, 215, 0);
                 break;
+            case TELEPORTER:
+                symbol = L"🌀";
+                symbolColor = RGB(138, 43, 226);
+                break;
             default:
                 break;
             }
@@ -425,6 +625,20 @@ void DrawMaze(HDC hdc) {
             }
         }
     }
+    // Ring the nearest diamond the player can reach without crossing a hazard.
+    POINT nearest;
+    int steps;
+    if (QueryNearestItem(levelItems[session.currentLevel].collectibles, session.playerPosition.y,
+                         session.playerPosition.x, nearest, steps)
+        && (!fogOfWar || fog.Explored(nearest.y, nearest.x))) {
+        HBRUSH ringBrush = CreateSolidBrush(RGB(0, 191, 255));
+        for (int inset = 2; inset <= 4; inset++) {
+            RECT ring = { nearest.x * CELL_SIZE + inset, nearest.y * CELL_SIZE + inset,
+                          (nearest.x + 1) * CELL_SIZE - inset, (nearest.y + 1) * CELL_SIZE - inset };
+            FrameRect(hdc, &ring, ringBrush);
+        }
+        DeleteObject(ringBrush);
+    }
     // Leave the starting cell as is (plain white).
     // Draw the ending cell: fill with dark orange.
     RECT endRect = { (GRID_COLS - 1) * CELL_SIZE, (GRID_ROWS - 1) * CELL_SIZE,
@@ -441,9 +655,29 @@ void DrawMaze(HDC hdc) {
     SetBkMode(hdc, TRANSPARENT);
     SetTextColor(hdc, RGB(255, 255, 255));
     TextOut(hdc, doorX, doorY, doorSymbol.c_str(), doorSymbol.length());
+    // Draw the roaming hazards the player can see.
+    SetTextColor(hdc, RGB(255, 0, 0));
+    for (size_t i = 0; i < roamingHazards.Count(); i++) {
+        int col = roamingHazards.x[i], row = roamingHazards.y[i];
+        if (fogOfWar && !fog.Visible(row, col))
+            continue;
+        std::wstring hazardSymbol = roamingHazards.behavior[i] == ENTITY_CHASER ? L"👹" : L"👻";
+        SIZE hazardSize;
+        GetTextExtentPoint32(hdc, hazardSymbol.c_str(), hazardSymbol.length(), &hazardSize);
+        TextOut(hdc, col * CELL_SIZE + (CELL_SIZE - hazardSize.cx) / 2, row * CELL_SIZE + (CELL_SIZE - hazardSize.cy) / 2,
+                hazardSymbol.c_str(), hazardSymbol.length());
+    }
     // Draw the player.
-    int playerX = playerPosition.x * CELL_SIZE;
-    int playerY = playerPosition.y * CELL_SIZE;
+    // Slide between the last two tick positions; jumps (hazards, new level) snap.
+    int playerX = session.playerPosition.x * CELL_SIZE;
+    int playerY = session.playerPosition.y * CELL_SIZE;
+    int stepX = session.playerPosition.x - previousPlayerPosition.x;
+    int stepY = session.playerPosition.y - previousPlayerPosition.y;
+    if (previousLevel == session.currentLevel && abs(stepX) + abs(stepY) == 1) {
+        double alpha = (std::min)(simClock.Alpha(), 1.0);
+        playerX = (int)((previousPlayerPosition.x + stepX * alpha) * CELL_SIZE);
+        playerY = (int)((previousPlayerPosition.y + stepY * alpha) * CELL_SIZE);
+    }
     std::wstring playerSymbol = L"🤺";
     SIZE pSize;
     GetTextExtentPoint32(hdc, playerSymbol.c_str(), playerSymbol.length(), &pSize);
@@ -452,16 +686,78 @@ void DrawMaze(HDC hdc) {
     SetTextColor(hdc, RGB(0, 0, 255));
     TextOut(hdc, pTextX, pTextY, playerSymbol.c_str(), playerSymbol.length());
     // Draw the HUD.
-    std::wstring hud = L"Lives: " + ConvertToWString(lives) +
-        L"\nTime: " + ConvertToWString(timeLeft) +
-        L"\nScore: " + ConvertToWString(score);
+    std::wstring hud = L"Lives: " + ConvertToWString(session.lives) +
+        L"\nTime: " + ConvertToWString(session.timeLeft) +
+        L"\nScore: " + ConvertToWString(session.score);
     RECT hudRect = { GRID_COLS * CELL_SIZE + 10, 10, GRID_COLS * CELL_SIZE + 250, 150 };
     DrawText(hdc, hud.c_str(), -1, &hudRect, DT_LEFT | DT_TOP);
     SelectObject(hdc, oldFont);
     DeleteObject(hFont);
+    // Draw the minimap under the HUD; it would give a fogged level away.
+    RECT miniRect = { GRID_COLS * CELL_SIZE + 10, 160,
+                      GRID_COLS * CELL_SIZE + 10 + MINIMAP_SIZE, 160 + MINIMAP_SIZE };
+    if (!fogOfWar)
+        DrawMinimap(hdc, miniRect);
+    if (showFrameStats)
+        DrawFrameStats(hdc);
 }
 
-// DrawMenu: Draws a menu screen with three buttons.
+// DrawOverlay: Draws the pause panel or the front notification centred over
+// whatever screen is under it.
+void DrawOverlay(HDC hdc) {
+    std::wstring title = L"Paused";
+    std::wstring text = L"Press P or Esc to resume.";
+    if (currentState == MESSAGE) {
+        title = notifications.front().title;
+        text = notifications.front().text + L"\n\nPress Enter or click to continue.";
+    }
+    RECT clientRect;
+    GetClientRect(hWndMain, &clientRect);
+    int left = (clientRect.right - 460) / 2;
+    int top = (clientRect.bottom - 200) / 2;
+    RECT panel = { left, top, left + 460, top + 200 };
+    HBRUSH panelBrush = CreateSolidBrush(RGB(255, 255, 255));
+    FillRect(hdc, &panel, panelBrush);
+    DeleteObject(panelBrush);
+    RECT titleBar = { panel.left, panel.top, panel.right, panel.top + 50 };
+    HBRUSH titleBrush = CreateSolidBrush(RGB(100, 149, 237));
+    FillRect(hdc, &titleBar, titleBrush);
+    DeleteObject(titleBrush);
+    FrameRect(hdc, &panel, (HBRUSH)GetStockObject(BLACK_BRUSH));
+    HFONT titleFont = CreateFont(
+        32, 0, 0, 0, FW_BOLD,
+        FALSE, FALSE, FALSE,
+        DEFAULT_CHARSET,
+        OUT_DEFAULT_PRECIS,
+        CLIP_DEFAULT_PRECIS,
+        CLEARTYPE_QUALITY,
+        VARIABLE_PITCH,
+        L"Segoe UI"
+    );
+    HFONT oldFont = (HFONT)SelectObject(hdc, titleFont);
+    SetBkMode(hdc, TRANSPARENT);
+    SetTextColor(hdc, RGB(255, 255, 255));
+    DrawText(hdc, title.c_str(), -1, &titleBar, DT_CENTER | DT_VCENTER | DT_SINGLELINE);
+    HFONT textFont = CreateFont(
+        20, 0, 0, 0, FW_NORMAL,
+        FALSE, FALSE, FALSE,
+        DEFAULT_CHARSET,
+        OUT_DEFAULT_PRECIS,
+        CLIP_DEFAULT_PRECIS,
+        CLEARTYPE_QUALITY,
+        VARIABLE_PITCH,
+        L"Segoe UI"
+    );
+    SelectObject(hdc, textFont);
+    RECT textRect = { panel.left + 20, titleBar.bottom + 20, panel.right - 20, panel.bottom - 10 };
+    SetTextColor(hdc, RGB(0, 0, 0));
+    DrawText(hdc, text.c_str(), -1, &textRect, DT_CENTER | DT_TOP | DT_WORDBREAK);
+    SelectObject(hdc, oldFont);
+    DeleteObject(titleFont);
+    DeleteObject(textFont);
+}
+
+// DrawMenu: Draws a menu screen with four buttons.
 void DrawMenu(HDC hdc) {
     RECT clientRect;
     GetClientRect(hWndMain, &clientRect);
@@ -486,82 +782,238 @@ void DrawMenu(HDC hdc) {
     // Define button rectangles.
     RECT startBtn = { clientRect.right / 2 - 100, 150, clientRect.right / 2 + 100, 210 };
     RECT loadBtn = { clientRect.right / 2 - 100, 230, clientRect.right / 2 + 100, 290 };
-    RECT exitBtn = { clientRect.right / 2 - 100, 310, clientRect.right / 2 + 100, 370 };
+    RECT continueBtn = { clientRect.right / 2 - 100, 310, clientRect.right / 2 + 100, 370 };
+    RECT exitBtn = { clientRect.right / 2 - 100, 390, clientRect.right / 2 + 100, 450 };
     HBRUSH btnBrush = CreateSolidBrush(RGB(100, 149, 237));
     FillRect(hdc, &startBtn, btnBrush);
     FillRect(hdc, &loadBtn, btnBrush);
+    FillRect(hdc, &continueBtn, btnBrush);
     FillRect(hdc, &exitBtn, btnBrush);
     DeleteObject(btnBrush);
     FrameRect(hdc, &startBtn, (HBRUSH)GetStockObject(BLACK_BRUSH));
     FrameRect(hdc, &loadBtn, (HBRUSH)GetStockObject(BLACK_BRUSH));
+    FrameRect(hdc, &continueBtn, (HBRUSH)GetStockObject(BLACK_BRUSH));
     FrameRect(hdc, &exitBtn, (HBRUSH)GetStockObject(BLACK_BRUSH));
     SetTextColor(hdc, RGB(255, 255, 255));
     DrawText(hdc, L"Start Game", -1, &startBtn, DT_CENTER | DT_VCENTER | DT_SINGLELINE);
     DrawText(hdc, L"Load Game", -1, &loadBtn, DT_CENTER | DT_VCENTER | DT_SINGLELINE);
+    DrawText(hdc, L"Continue", -1, &continueBtn, DT_CENTER | DT_VCENTER | DT_SINGLELINE);
     DrawText(hdc, L"Exit", -1, &exitBtn, DT_CENTER | DT_VCENTER | DT_SINGLELINE);
+    // Top five scores to the right of the buttons.
+    HFONT listFont = CreateFont(
+        20, 0, 0, 0, FW_NORMAL,
+        FALSE, FALSE, FALSE,
+        DEFAULT_CHARSET,
+        OUT_DEFAULT_PRECIS,
+        CLIP_DEFAULT_PRECIS,
+        CLEARTYPE_QUALITY,
+        VARIABLE_PITCH,
+        L"Segoe UI"
+    );
+    SelectObject(hdc, listFont);
+    std::wstring board = L"High Scores\n";
+    std::vector<HighScore> top = highScores.Table().Top(5);
+    for (size_t i = 0; i < top.size(); i++)
+        board += ConvertToWString((int)i + 1) + L". " + std::wstring(top[i].name.begin(), top[i].name.end()) +
+            L"  " + ConvertToWString(top[i].score) + L"\n";
+    if (top.empty())
+        board += L"No games finished yet.";
+    RECT boardRect = { clientRect.right / 2 + 120, 150, clientRect.right - 10, 450 };
+    SetTextColor(hdc, RGB(0, 0, 128));
+    DrawText(hdc, board.c_str(), -1, &boardRect, DT_LEFT | DT_TOP);
     SelectObject(hdc, oldFont);
     DeleteObject(hFont);
+    DeleteObject(listFont);
 }
 
 //-----------------------------------------------------
 // Input and Timer Handling
 //-----------------------------------------------------
 
-// MovePlayer: Moves the player based on arrow key input.
-void MovePlayer(int dx, int dy) {
-    int newX = playerPosition.x + dx;
-    int newY = playerPosition.y + dy;
-    if (newX >= 0 && newX < GRID_COLS && newY >= 0 && newY < GRID_ROWS) {
-        int cellValue = levels[currentLevel][newY][newX];
-        if (cellValue == WALL || cellValue == OBSTACLE) {
-            return;
-        }
-        else if (cellValue == HAZARD) {
-            lives--;
-            // Optionally adjust timeLeft if desired.
-            playerPosition = { 0, 0 };
-            PlayGameSound(L"hazard01.wav");
-            if (lives <= 0) {
-                KillTimer(hWndMain, TIMER_ID);
-                MessageBox(hWndMain, L"You hit a harmful hurdle! No lives remaining. Game Over.", L"Game Over", MB_OK);
-                PostQuitMessage(0);
-                return;
-            }
-            else {
-                ShowPausedMessage(L"You hit a harmful hurdle! Restarting from the beginning.", L"Hazard");
-                InvalidateRect(hWndMain, NULL, TRUE);
-                return;
-            }
-        }
-        else if (cellValue == COLLECTIBLE) {
-            lives++;
-            timeLeft += 5;
-            PlayGameSound(L"powerup.wav");
-            levels[currentLevel][newY][newX] = PASSAGE;
-        }
-        else if (cellValue == MINIDOT) {
-            score++;
-            levels[currentLevel][newY][newX] = PASSAGE;
-        }
-        playerMoveHistory.push(playerPosition);
-        playerPosition.x = newX;
-        playerPosition.y = newY;
-    }
-    if (playerPosition.x == endPosition.x && playerPosition.y == endPosition.y) {
-        if (currentLevel < TOTAL_LEVELS - 1) {
-            currentLevel++;
-            PlayGameSound(L"lvl.wav");
-            playerPosition = { 0, 0 };
-            timeLeft = 25;
-        }
-        else {
-            KillTimer(hWndMain, TIMER_ID);
-            PlayGameSound(L"win01.wav");
-            MessageBox(hWndMain, L"Congratulations! You've completed all levels!", L"Victory", MB_OK);
-            PostQuitMessage(0);
-        }
+// MovePlayer: Moves the player based on arrow key input and returns what
+// the session made of it.
+StepResult MovePlayer(int dx, int dy) {
+    TRACE_SCOPE("MovePlayer");
+    int level = session.currentLevel;
+    StepResult result = session.Move(dx, dy);
+    switch (result) {
+    case STEP_BLOCKED:
+        return result;
+    case STEP_HAZARD:
+        PlayGameSound(L"hazard01.wav");
+        ShowNotification(L"You hit a harmful hurdle! Restarting from the beginning.", L"Hazard");
+        break;
+    case STEP_GAME_OVER:
+        PlayGameSound(L"hazard01.wav");
+        ShowNotification((L"You hit a harmful hurdle! No lives remaining. Game Over." + RecordHighScore()).c_str(), L"Game Over", true);
+        return result;
+    case STEP_COLLECTED:
+        PlayGameSound(L"powerup.wav");
+        UpdateLevelViews(session.currentLevel, session.playerPosition.y, session.playerPosition.x, COLLECTIBLE, PASSAGE);
+        break;
+    case STEP_DOT:
+        UpdateLevelViews(session.currentLevel, session.playerPosition.y, session.playerPosition.x, MINIDOT, PASSAGE);
+        break;
+    case STEP_NEXT_LEVEL:
+        PlayGameSound(L"lvl.wav");
+        PlayBackgroundMusic(session.currentLevel % 2);
+        break;
+    case STEP_TELEPORTED:
+        PlayGameSound(L"powerup.wav");
+        if (session.currentLevel != level)
+            PlayBackgroundMusic(session.currentLevel % 2);
+        break;
+    case STEP_VICTORY:
+        PlayGameSound(L"win01.wav");
+        ShowNotification((L"Congratulations! You've completed all levels!" + RecordHighScore()).c_str(), L"Victory", true);
+        break;
+    default:
+        break;
     }
     InvalidateRect(hWndMain, NULL, TRUE);
+    return result;
+}
+
+// CountdownSystem: The level timer, one second of game time every
+// SIM_TICK_RATE ticks.
+void CountdownSystem() {
+    if (++countdownTicks < SIM_TICK_RATE)
+        return;
+    countdownTicks = 0;
+    StepResult result = session.Tick();
+    recorder.Record(INPUT_TICK);
+    if (result == STEP_GAME_OVER) {
+        ShowNotification((L"Time's up and no lives remaining. Game Over." + RecordHighScore()).c_str(), L"Game Over", true);
+        return;
+    }
+    else if (result == STEP_TIME_UP) {
+        ShowNotification(L"Time's up! Restarting level.", L"Timer");
+    }
+    JournalLastStep(result);
+}
+
+// HitPlayer: A roaming hazard caught the player. Goes through the session
+// like any other step, so undo, replays and the autosave all see it.
+void HitPlayer() {
+    StepResult result = session.Hit();
+    recorder.Record(INPUT_HIT);
+    PlayGameSound(L"hazard01.wav");
+    if (result == STEP_GAME_OVER) {
+        ShowNotification((L"A roaming hazard caught you! No lives remaining. Game Over." + RecordHighScore()).c_str(), L"Game Over", true);
+        return;
+    }
+    ShowNotification(L"A roaming hazard caught you! Restarting from the beginning.", L"Hazard");
+    JournalLastStep(result);
+}
+
+// HazardSystem: Moves the roaming hazards every ENTITY_STEP_TICKS and checks
+// whether the player walked into one or one walked into the player.
+void HazardSystem() {
+    if (session.currentLevel != hazardLevel)
+        SpawnLevelHazards();
+    if (CountEntitiesAt(roamingHazards, session.playerPosition) == 0 && ++hazardTicks >= ENTITY_STEP_TICKS) {
+        hazardTicks = 0;
+        UpdateFlowField(hazardFlow, session.playerPosition);
+        StepEntities(roamingHazards, hazardFlow);
+    }
+    if (CountEntitiesAt(roamingHazards, session.playerPosition) > 0)
+        HitPlayer();
+}
+
+// UndoStep: Reverts or re-applies one step, then brings the level views, music,
+// roaming hazards and autosave in line. A move record cannot express a rewind,
+// so the autosave journal is compacted to a fresh snapshot instead.
+// The player can come back to a cell a roaming hazard has moved onto since.
+// The hazard is stepped aside and the step timer restarted, so the undo is
+// not answered by a hit on the next tick (which would also drop the history).
+// Only a hazard with no open neighbour stays and hits.
+void UndoStep(GameAction action) {
+    int level = session.currentLevel;
+    const UndoDelta* delta = action == ACTION_UNDO ? session.Undo() : session.Redo();
+    if (!delta)
+        return;
+    if (delta->flags & UNDO_CELL_CHANGED) {
+        POINT target = delta->Target();
+        if (action == ACTION_UNDO)
+            UpdateLevelViews(session.currentLevel, target.y, target.x, delta->NewCell(), delta->OldCell());
+        else
+            UpdateLevelViews(level, target.y, target.x, delta->OldCell(), delta->NewCell());
+    }
+    if (session.currentLevel != level)
+        PlayBackgroundMusic(session.currentLevel % 2);
+    if (session.currentLevel != hazardLevel)
+        SpawnLevelHazards();
+    MoveEntitiesOff(roamingHazards, hazardFlow, session.playerPosition);
+    hazardTicks = 0;
+    if (autosave.IsRunning())
+        autosave.Compact(session.ToSaveData());
+}
+
+// SimulationTick: One fixed step of the game: queued actions, the roaming
+// hazards, then the timer.
+// A notification raised by a move stops the rest of the tick, but the
+// player's line of sight always follows where they ended up.
+void SimulationTick() {
+    TRACE_SCOPE("SimulationTick");
+    previousPlayerPosition = session.playerPosition;
+    previousLevel = session.currentLevel;
+    if (currentState != PLAYING) {
+        pendingActions = std::queue<GameAction>();
+        return;
+    }
+    while (!pendingActions.empty() && currentState == PLAYING) {
+        GameAction action = pendingActions.front();
+        pendingActions.pop();
+        recorder.Record((InputCode)action);
+        if (action == ACTION_UNDO || action == ACTION_REDO) {
+            UndoStep(action);
+            continue;
+        }
+        int dx, dy;
+        MoveDirectionStep(action, dx, dy);
+        JournalLastStep(MovePlayer(dx, dy));
+    }
+    if (currentState == PLAYING)
+        HazardSystem();
+    if (currentState == PLAYING)
+        CountdownSystem();
+    RevealAroundPlayer();
+}
+
+// Start a new game and reset the per-game UI state.
+void StartNewGame(uint32_t seed) {
+    TRACE_SCOPE("StartNewGame");
+    session.NewGame(seed);
+    RebuildLevelViews();
+    countdownTicks = 0;
+    previousPlayerPosition = session.playerPosition;
+    previousLevel = session.currentLevel;
+}
+
+// Replay a recording through a GameSession as fast as possible: no window,
+// timer, drawing or sound. Prints the result to the console the game was
+// started from and returns 0 if the final state hash matches the recording.
+int RunHeadlessReplay(const std::string& path, int repeat) {
+    if (AttachConsole(ATTACH_PARENT_PROCESS) || AllocConsole()) {
+        FILE* stream;
+        freopen_s(&stream, "CONOUT$", "w", stdout);
+    }
+    InputRecording recording;
+    if (!LoadInputRecording(path, recording)) {
+        printf("replay: cannot read %s\n", path.c_str());
+        return 2;
+    }
+    ReplayResult result = ReplayRecording(recording, repeat);
+    printf("replay: seed %u, %zu inputs, %d run(s)\n", recording.seed, recording.inputs.size(), repeat);
+    printf("replay: %.0f moves/s (%.3f ms total)\n", result.MovesPerSecond(), result.seconds * 1000.0);
+    printf("replay: final state hash %016llx\n", (unsigned long long)result.finalHash);
+    if (!recording.hasFinalHash) {
+        printf("replay: recording has no final hash to compare against\n");
+        return 0;
+    }
+    bool match = result.finalHash == recording.finalHash;
+    printf("replay: %s (recorded %016llx)\n", match ? "MATCH" : "MISMATCH", (unsigned long long)recording.finalHash);
+    return match ? 0 : 1;
 }
 
 // Handle menu clicks.
@@ -570,21 +1022,34 @@ void HandleMenuClick(int x, int y) {
     GetClientRect(hWndMain, &clientRect);
     RECT startBtn = { clientRect.right / 2 - 100, 150, clientRect.right / 2 + 100, 210 };
     RECT loadBtn = { clientRect.right / 2 - 100, 230, clientRect.right / 2 + 100, 290 };
-    RECT exitBtn = { clientRect.right / 2 - 100, 310, clientRect.right / 2 + 100, 370 };
+    RECT continueBtn = { clientRect.right / 2 - 100, 310, clientRect.right / 2 + 100, 370 };
+    RECT exitBtn = { clientRect.right / 2 - 100, 390, clientRect.right / 2 + 100, 450 };
     POINT pt = { x, y };
     if (PtInRect(&startBtn, pt)) {
         currentState = PLAYING;
-        lives = 2;
-        timeLeft = 15;
-        score = 0;
-        playerPosition = { 0, 0 };
-        GenerateRandomLevels();
+        recorder.Finish(session.StateHash());
+        StartNewGame(NewLevelSeed());
+        recorder.Start("session.rec", session.seed);
+        RestartAutosave();
     }
     else if (PtInRect(&loadBtn, pt)) {
-        if (LoadGameState())
+        recorder.Finish(session.StateHash());
+        if (LoadGameState()) {
             currentState = PLAYING;
+            RestartAutosave();
+        }
         else
-            MessageBox(hWndMain, L"No saved game found.", L"Load Game", MB_OK);
+            ShowNotification(L"No saved game found.", L"Load Game");
+    }
+    else if (PtInRect(&continueBtn, pt)) {
+        recorder.Finish(session.StateHash());
+        if (RecoverAutosaveState()) {
+            currentState = PLAYING;
+            autosaveEnabled = true;
+            RestartAutosave();
+        }
+        else
+            ShowNotification(L"No autosave found.", L"Continue");
     }
     else if (PtInRect(&exitBtn, pt)) {
         PostQuitMessage(0);
@@ -596,6 +1061,7 @@ void HandleMenuClick(int x, int y) {
 LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) {
     switch (message) {
     case WM_PAINT: {
+        TRACE_SCOPE("WM_PAINT");
         PAINTSTRUCT ps;
         HDC hdc = BeginPaint(hWnd, &ps);
         HDC hdcMem = CreateCompatibleDC(hdc);
@@ -608,10 +1074,13 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         HBRUSH hbrBkGnd = CreateSolidBrush(RGB(240, 240, 240));
         FillRect(hdcMem, &clientRect, hbrBkGnd);
         DeleteObject(hbrBkGnd);
-        if (currentState == MENU)
+        GameState screen = currentState == MESSAGE ? stateBeforeMessage : currentState;
+        if (screen == MENU)
             DrawMenu(hdcMem);
-        else if (currentState == PLAYING)
+        else
             DrawMaze(hdcMem);
+        if (currentState == PAUSED || currentState == MESSAGE)
+            DrawOverlay(hdcMem);
         BitBlt(hdc, 0, 0, width, height, hdcMem, 0, 0, SRCCOPY);
         SelectObject(hdcMem, hbmOld);
         DeleteObject(hbmMem);
@@ -621,7 +1090,9 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                  break;
 
     case WM_LBUTTONDOWN:
-        if (currentState == MENU) {
+        if (currentState == MESSAGE)
+            DismissNotification();
+        else if (currentState == MENU) {
             int xPos = LOWORD(lParam);
             int yPos = HIWORD(lParam);
             HandleMenuClick(xPos, yPos);
@@ -629,45 +1100,67 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         break;
 
     case WM_KEYDOWN:
-        if (currentState == PLAYING) {
+        if (currentState == MESSAGE) {
+            if (wParam == VK_RETURN || wParam == VK_SPACE || wParam == VK_ESCAPE)
+                DismissNotification();
+        }
+        else if (currentState == PAUSED) {
+            if (wParam == 'P' || wParam == VK_ESCAPE)
+                TogglePause();
+        }
+        else if (currentState == PLAYING) {
+            int dx = 0, dy = 0;
             switch (wParam) {
             case VK_UP:
-                MovePlayer(0, -1);
+                dy = -1;
                 break;
             case VK_DOWN:
-                MovePlayer(0, 1);
+                dy = 1;
                 break;
             case VK_LEFT:
-                MovePlayer(-1, 0);
+                dx = -1;
                 break;
             case VK_RIGHT:
-                MovePlayer(1, 0);
+                dx = 1;
                 break;
             case 'S':  // Save game on pressing 'S'
                 SaveGameState();
                 break;
+            case 'C':  // Copy the level's share code on pressing 'C'
+                CopyLevelShareCode();
+                break;
+            case 'V':  // Play the share code on the clipboard on pressing 'V'
+                PasteLevelShareCode();
+                break;
+            case 'A':  // Toggle journaled autosave on pressing 'A'
+                autosaveEnabled = !autosaveEnabled;
+                if (!autosaveEnabled)
+                    autosave.Stop();
+                RestartAutosave();
+                break;
+            case VK_F3:  // Toggle the game loop instrumentation
+                showFrameStats = !showFrameStats;
+                break;
+            case VK_F4:  // Start tracing, or stop and write trace.json
+                ToggleTracing();
+                break;
+            case 'F':  // Toggle the fog of war on pressing 'F'
+                fogOfWar = !fogOfWar;
+                break;
+            case 'P':  // Pause on pressing 'P' or Esc
+            case VK_ESCAPE:
+                TogglePause();
+                break;
+            case 'Z':  // Undo the last step on pressing 'Z', redo with 'Y'
+                pendingActions.push(ACTION_UNDO);
+                break;
+            case 'Y':
+                pendingActions.push(ACTION_REDO);
+                break;
             }
-        }
-        break;
-
-    case WM_TIMER:
-        if (currentState == PLAYING && wParam == TIMER_ID) {
-            timeLeft--;
-            if (timeLeft <= 0) {
-                lives--;
-                if (lives <= 0) {
-                    KillTimer(hWndMain, TIMER_ID);
-                    MessageBox(hWndMain, L"Time's up and no lives remaining. Game Over.", L"Game Over", MB_OK);
-                    PostQuitMessage(0);
-                    break;
-                }
-                else {
-                    ShowPausedMessage(L"Time's up! Restarting level.", L"Timer");
-                    timeLeft = 25;
-                    playerPosition = { 0, 0 };
-                }
-            }
-            InvalidateRect(hWnd, NULL, TRUE);
+            // Moves are applied by the next simulation tick.
+            if (dx || dy)
+                pendingActions.push((GameAction)MoveDirectionIndex(dx, dy));
         }
         break;
 
@@ -684,6 +1177,19 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
     return 0;
 }
 
+// Build an icon of the given size from an .ico in the archive, or load the
+// matching one from the resources.
+HICON LoadGameIcon(const char* name, int resource, int pixels) {
+    AssetView file, image;
+    if (assets.Find(name, file) && FindIconImage(file.data, file.size, pixels, image)) {
+        HICON icon = CreateIconFromResourceEx((PBYTE)image.data, (DWORD)image.size, TRUE, 0x00030000,
+            pixels, pixels, LR_DEFAULTCOLOR);
+        if (icon)
+            return icon;
+    }
+    return LoadIcon(hInst, MAKEINTRESOURCE(resource));
+}
+
 //-----------------------------------------------------
 // Main Function
 //-----------------------------------------------------
@@ -693,16 +1199,50 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
     _In_ int nCmdShow)
 {
     UNREFERENCED_PARAMETER(hPrevInstance);
-    UNREFERENCED_PARAMETER(lpCmdLine);
     srand((unsigned int)time(NULL));
     hInst = hInstance;
 
+    // "/replay <file> [repeat]" runs a recording headlessly and exits.
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(lpCmdLine, &argc);
+    if (argv && lpCmdLine[0] && argc >= 2 && lstrcmpiW(argv[0], L"/replay") == 0) {
+        char path[MAX_PATH];
+        WideCharToMultiByte(CP_ACP, 0, argv[1], -1, path, MAX_PATH, nullptr, nullptr);
+        int repeat = argc >= 3 ? (std::max)(_wtoi(argv[2]), 1) : 1;
+        LocalFree(argv);
+        return RunHeadlessReplay(path, repeat);
+    }
+    // "/campaign <n>" plays baked level set n (0 to BAKED_CAMPAIGN_COUNT - 1).
+    if (argv && lpCmdLine[0] && argc >= 2 && lstrcmpiW(argv[0], L"/campaign") == 0) {
+        int index = _wtoi(argv[1]);
+        if (index >= 0 && index < BAKED_CAMPAIGN_COUNT)
+            campaign = index;
+    }
+    // "/level <code>" starts straight into a shared level.
+    if (argv && lpCmdLine[0] && argc >= 2 && lstrcmpiW(argv[0], L"/level") == 0) {
+        char code[1024];
+        if (WideCharToMultiByte(CP_ACP, 0, argv[1], -1, code, sizeof(code), nullptr, nullptr))
+            startLevelCode = code;
+    }
+    // "/trace" records spans from startup; they are written to trace.json
+    // on exit or when F4 stops tracing.
+    for (int i = 0; argv && lpCmdLine[0] && i < argc; i++)
+        if (lstrcmpiW(argv[i], L"/trace") == 0)
+            EnableTracing(true);
+    if (argv)
+        LocalFree(argv);
+    SetTraceThreadName("main");
+
+    assets.Open("assets.pak");
+    highScores.Open("highscores.dat");
+
     WNDCLASS wc = {};
     wc.lpfnWndProc = WndProc;
     wc.hInstance = hInstance;
     wc.lpszClassName = L"MazeGameClass";
     wc.hbrBackground = (HBRUSH)(COLOR_WINDOW + 1);
     wc.hCursor = LoadCursor(nullptr, IDC_ARROW);
+    wc.hIcon = LoadGameIcon("DSA Project.ico", IDI_DSAPROJECT, GetSystemMetrics(SM_CXICON));
     RegisterClass(&wc);
 
     hWndMain = CreateWindow(L"MazeGameClass", L"Maze Game",
@@ -712,22 +1252,55 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
         nullptr, nullptr, hInstance, nullptr);
     if (!hWndMain)
         return FALSE;
+    SendMessage(hWndMain, WM_SETICON, ICON_SMALL,
+        (LPARAM)LoadGameIcon("small.ico", IDI_SMALL, GetSystemMetrics(SM_CXSMICON)));
     ShowWindow(hWndMain, nCmdShow);
+    StartAudio();
 
     currentState = MENU;
-    GenerateRandomLevels();
-    SetTimer(hWndMain, TIMER_ID, TIMER_INTERVAL, NULL);
+    StartNewGame(NewLevelSeed());
+    if (!startLevelCode.empty()) {
+        if (LoadLevelShareCode(startLevelCode))
+            currentState = PLAYING;
+        else
+            ShowNotification(L"That share code is not a level of this size.", L"Shared Level");
+    }
 
-    // Start background music in a separate thread.
-    std::thread bgMusicThread(PlayBackgroundMusic, L"background 01.mp3");
-    bgMusicThread.detach();
+    PlayBackgroundMusic(0);
 
-    MSG msg;
-    while (GetMessage(&msg, nullptr, 0, 0)) {
-        TranslateMessage(&msg);
-        DispatchMessage(&msg);
+    // Game loop: drain messages, run the fixed ticks that are due, render,
+    // then sleep until the next tick or the next input, whichever is first.
+    MSG msg = {};
+    simClock.Reset();
+    while (true) {
+        while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+            if (msg.message == WM_QUIT)
+                break;
+            TranslateMessage(&msg);
+            DispatchMessage(&msg);
+        }
+        if (msg.message == WM_QUIT)
+            break;
+        int ticks = simClock.BeginFrame();
+        for (int i = 0; i < ticks; i++) {
+            auto tickStart = SimulationClock::Clock::now();
+            SimulationTick();
+            simClock.RecordTickCost(SimulationClock::Clock::now() - tickStart);
+        }
+        if (currentState == PLAYING) {
+            InvalidateRect(hWndMain, NULL, TRUE);
+            UpdateWindow(hWndMain);
+        }
+        simClock.EndFrame();
+        DWORD waitMs = (DWORD)std::chrono::duration_cast<std::chrono::milliseconds>(simClock.UntilNextTick()).count();
+        MsgWaitForMultipleObjectsEx(0, nullptr, waitMs, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
     }
 
-    StopBackgroundMusic();
+    recorder.Finish(session.StateHash());
+    autosave.Stop();
+    audio.Stop();       // also stops the music
+    audioOut.Close();
+    if (TracingEnabled())
+        WriteChromeTrace("trace.json");
     return (int)msg.wParam;
 }
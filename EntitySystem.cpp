@@ -0,0 +1,172 @@
+#include "EntitySystem.h"
+#include <algorithm>
+
+// Heading for each flow step code: unreached, up, right, down, left, target.
+static const int32_t FLOW_DX[6] = { 0, 0, 1, 0, -1, 0 };
+static const int32_t FLOW_DY[6] = { 0, -1, 0, 1, 0, 0 };
+
+//-----------------------------------------------------------------------------
+// EntityStore Functions
+//-----------------------------------------------------------------------------
+
+void EntityStore::Add(int col, int row, int dx, int dy, EntityBehavior kind) {
+    x.push_back(col);
+    y.push_back(row);
+    vx.push_back(dx);
+    vy.push_back(dy);
+    behavior.push_back(kind);
+}
+
+void EntityStore::Clear() {
+    x.clear();
+    y.clear();
+    vx.clear();
+    vy.clear();
+    behavior.clear();
+}
+
+//-----------------------------------------------------------------------------
+// Flow Field Functions
+//-----------------------------------------------------------------------------
+
+void BuildFlowField(FlowField& field, const std::vector<std::vector<int>>& grid) {
+    field.rows = grid.size();
+    field.cols = grid.empty() ? 0 : grid[0].size();
+    field.target = { -1, -1 };
+    int stride = field.cols + 2;
+    size_t cells = (size_t)(field.rows + 2) * stride;
+    field.open.assign(cells, 0);
+    field.step.assign(cells, 0);
+    field.queue.resize(cells);
+    for (int r = 0; r < field.rows; r++) {
+        for (int c = 0; c < field.cols; c++) {
+            int value = grid[r][c];
+            field.open[(r + 1) * stride + c + 1] = value != WALL && value != OBSTACLE;
+        }
+    }
+    if (field.rows > 0 && field.cols > 0) {
+        field.open[stride + 1] = 0;
+        field.open[field.rows * stride + field.cols] = 0;
+    }
+}
+
+int UpdateFlowField(FlowField& field, POINT target) {
+    if (target.x == field.target.x && target.y == field.target.y)
+        return -1;
+    field.target = target;
+    std::fill(field.step.begin(), field.step.end(), 0);
+    if (target.x < 0 || target.x >= field.cols || target.y < 0 || target.y >= field.rows)
+        return 0;
+    int stride = field.cols + 2;
+    const int offsets[4] = { -stride, 1, stride, -1 };
+    int start = (target.y + 1) * stride + target.x + 1;
+    field.step[start] = FLOW_TARGET;
+    int head = 0, tail = 0;
+    field.queue[tail++] = start;
+    while (head < tail) {
+        int cell = field.queue[head++];
+        for (int dir = 0; dir < 4; dir++) {
+            int next = cell + offsets[dir];
+            if (!field.open[next] || field.step[next])
+                continue;
+            // From next, the way back is the opposite direction.
+            field.step[next] = (uint8_t)(((dir + 2) & 3) + 1);
+            field.queue[tail++] = next;
+        }
+    }
+    return tail;
+}
+
+//-----------------------------------------------------------------------------
+// Entity Update Functions
+//-----------------------------------------------------------------------------
+
+void SpawnEntities(EntityStore& store, const FlowField& field, int roamers, int chasers, int minDistance,
+                   MazeRng& rng) {
+    std::vector<POINT> cells;
+    int stride = field.cols + 2;
+    for (int r = 0; r < field.rows; r++) {
+        for (int c = 0; c < field.cols; c++) {
+            if (field.open[(r + 1) * stride + c + 1] && r + c >= minDistance)
+                cells.push_back({ (long)c, (long)r });
+        }
+    }
+    if (cells.empty())
+        return;
+    for (int i = 0; i < roamers + chasers; i++) {
+        POINT cell = cells[rng.Below((uint32_t)cells.size())];
+        int dx, dy;
+        MoveDirectionStep(rng.Below(4), dx, dy);
+        store.Add(cell.x, cell.y, dx, dy, i < roamers ? ENTITY_ROAMER : ENTITY_CHASER);
+    }
+}
+
+// Each pass is a straight loop over the arrays with selects instead of
+// branches; only the reads from the padded maps are gathers.
+void StepEntities(EntityStore& store, const FlowField& field) {
+    int count = (int)store.Count();
+    int stride = field.cols + 2;
+    int32_t* x = store.x.data();
+    int32_t* y = store.y.data();
+    int32_t* vx = store.vx.data();
+    int32_t* vy = store.vy.data();
+    const int32_t* behavior = store.behavior.data();
+    const uint8_t* open = field.open.data();
+    const uint8_t* step = field.step.data();
+
+    // Chasers take their heading from the flow field.
+    for (int i = 0; i < count; i++) {
+        int code = step[(y[i] + 1) * stride + x[i] + 1];
+        bool chase = behavior[i] == ENTITY_CHASER;
+        vx[i] = chase ? FLOW_DX[code] : vx[i];
+        vy[i] = chase ? FLOW_DY[code] : vy[i];
+    }
+    // Move where the heading is open; a blocked entity turns right instead.
+    for (int i = 0; i < count; i++) {
+        int32_t free = open[(y[i] + vy[i] + 1) * stride + x[i] + vx[i] + 1];
+        int32_t turnX = -vy[i], turnY = vx[i];
+        x[i] += free * vx[i];
+        y[i] += free * vy[i];
+        vx[i] = free ? vx[i] : turnX;
+        vy[i] = free ? vy[i] : turnY;
+    }
+}
+
+size_t CountEntitiesAt(const EntityStore& store, POINT cell) {
+    size_t count = store.Count(), hits = 0;
+    const int32_t* x = store.x.data();
+    const int32_t* y = store.y.data();
+    int32_t cx = (int32_t)cell.x, cy = (int32_t)cell.y;
+    for (size_t i = 0; i < count; i++)
+        hits += (x[i] == cx) & (y[i] == cy);
+    return hits;
+}
+
+size_t MoveEntitiesOff(EntityStore& store, const FlowField& field, POINT cell) {
+    int stride = field.cols + 2;
+    size_t left = 0;
+    for (size_t i = 0; i < store.Count(); i++) {
+        if (store.x[i] != cell.x || store.y[i] != cell.y)
+            continue;
+        int32_t dx = store.vx[i], dy = store.vy[i];
+        if (!dx && !dy)
+            dx = 1;
+        bool moved = false;
+        for (int turn = 0; turn < 4 && !moved; turn++) {
+            if (field.open[(store.y[i] + dy + 1) * stride + store.x[i] + dx + 1]) {
+                store.x[i] += dx;
+                store.y[i] += dy;
+                store.vx[i] = dx;
+                store.vy[i] = dy;
+                moved = true;
+            }
+            else {
+                int32_t turnX = -dy;
+                dy = dx;
+                dx = turnX;
+            }
+        }
+        left += !moved;
+    }
+    return left;
+}
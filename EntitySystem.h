@@ -0,0 +1,73 @@
+// EntitySystem.h : roaming hazards and chasers kept as structure of arrays
+//
+// Entities are moving hazards on top of the level grid. Each one is a slot
+// in parallel arrays (position, heading, behaviour), so a step is a few flat
+// passes over plain integer arrays with no per-entity objects or branches
+// the compiler cannot turn into selects. Roamers walk straight and turn
+// right when blocked. Chasers do not search for the player themselves: one
+// flow field, a BFS outwards from the player, stores for every cell the
+// step towards the player, and a chaser only reads the step under it.
+//
+// Walls and obstacles block entities; they also keep off the start and
+// exit cells, so a player sent back to the start is safe there.
+
+#pragma once
+
+#include "MazeGame.h"
+#include <cstddef>
+
+enum EntityBehavior {
+    ENTITY_ROAMER = 0,
+    ENTITY_CHASER = 1
+};
+
+struct EntityStore {
+    std::vector<int32_t> x;         // cell column
+    std::vector<int32_t> y;         // cell row
+    std::vector<int32_t> vx;        // heading, one cell per step
+    std::vector<int32_t> vy;
+    std::vector<int32_t> behavior;  // EntityBehavior
+
+    size_t Count() const { return x.size(); }
+    void Add(int col, int row, int dx, int dy, EntityBehavior kind);
+    void Clear();
+};
+
+// The level as entities see it plus the flow field towards the player. Both
+// use a grid padded by one closed cell on every side, so no step needs a
+// bounds check: cell (row, col) is at (row + 1) * (cols + 2) + col + 1.
+struct FlowField {
+    int rows = 0;
+    int cols = 0;
+    POINT target = { -1, -1 };  // cell the flow currently leads to
+    std::vector<uint8_t> open;  // 1 where entities may walk
+    std::vector<uint8_t> step;  // 0 = unreached, 1 + direction index, FLOW_TARGET
+    std::vector<int> queue;
+};
+
+#define FLOW_TARGET 5
+
+// Set up the padded open map for a level; the flow is empty until the first
+// UpdateFlowField().
+void BuildFlowField(FlowField& field, const std::vector<std::vector<int>>& grid);
+
+// Recompute every cell's step towards target with one BFS. Does nothing if
+// target has not moved. Returns the number of cells reached, or -1.
+int UpdateFlowField(FlowField& field, POINT target);
+
+// Place entities on random open cells at least minDistance steps (Manhattan)
+// from the start; roamers get a random heading.
+void SpawnEntities(EntityStore& store, const FlowField& field, int roamers, int chasers, int minDistance,
+                   MazeRng& rng);
+
+// Advance every entity one cell: chasers take the flow step under them,
+// roamers keep their heading or turn right if it is blocked.
+void StepEntities(EntityStore& store, const FlowField& field);
+
+// Number of entities on the given cell.
+size_t CountEntitiesAt(const EntityStore& store, POINT cell);
+
+// Step every entity on the given cell to an open neighbour: ahead if it can,
+// else the first open one turning right. Returns the number left on the cell,
+// those with no open neighbour.
+size_t MoveEntitiesOff(EntityStore& store, const FlowField& field, POINT cell);
@@ -0,0 +1,106 @@
+#include "FieldOfView.h"
+#include <algorithm>
+
+// Column and row steps (xx, xy, yx, yy) mapping one octant's (dx, dy) scan
+// coordinates onto the grid.
+static const int OCTANTS[8][4] = {
+    { 1, 0, 0, 1 }, { 0, 1, 1, 0 }, { 0, -1, 1, 0 }, { -1, 0, 0, 1 },
+    { -1, 0, 0, -1 }, { 0, -1, -1, 0 }, { 0, 1, -1, 0 }, { 1, 0, 0, -1 }
+};
+
+static bool BlocksSight(int value) {
+    return value == WALL || value == OBSTACLE;
+}
+
+FogOfWar CreateFogOfWar(int rows, int cols, int radius) {
+    FogOfWar fog;
+    fog.rows = rows;
+    fog.cols = cols;
+    fog.radius = radius;
+    size_t words = ((size_t)rows * cols + 63) / 64;
+    fog.visible.assign(words, 0);
+    fog.explored.assign(words, 0);
+    return fog;
+}
+
+// Light one cell; returns 1 if it was not lit yet.
+static int Reveal(FogOfWar& fog, int row, int col) {
+    size_t cell = (size_t)row * fog.cols + col;
+    uint64_t bit = 1ull << (cell & 63);
+    fog.explored[cell >> 6] |= bit;
+    if (fog.visible[cell >> 6] & bit)
+        return 0;
+    fog.visible[cell >> 6] |= bit;
+    return 1;
+}
+
+// Scan one octant from depth `depth` outwards while the slopes in
+// [end, start] are lit. A run of blocking cells recurses for the lit part
+// before it and continues the scan after it.
+static int CastLight(FogOfWar& fog, const std::vector<std::vector<int>>& grid, int row, int col,
+                     int depth, double start, double end, const int* octant) {
+    if (start < end)
+        return 0;
+    int lit = 0;
+    int radiusSquared = fog.radius * fog.radius + fog.radius;
+    double nextStart = start;
+    for (int j = depth; j <= fog.radius; j++) {
+        bool blocked = false;
+        for (int dx = -j, dy = -j; dx <= 0; dx++) {
+            int c = col + dx * octant[0] + dy * octant[1];
+            int r = row + dx * octant[2] + dy * octant[3];
+            double leftSlope = (dx - 0.5) / (dy + 0.5);
+            double rightSlope = (dx + 0.5) / (dy - 0.5);
+            if (start < rightSlope)
+                continue;
+            if (end > leftSlope)
+                break;
+            bool inside = r >= 0 && r < fog.rows && c >= 0 && c < fog.cols;
+            if (inside && dx * dx + dy * dy <= radiusSquared)
+                lit += Reveal(fog, r, c);
+            bool opaque = !inside || BlocksSight(grid[r][c]);
+            if (blocked) {
+                if (opaque) {
+                    nextStart = rightSlope;
+                    continue;
+                }
+                blocked = false;
+                start = nextStart;
+            }
+            else if (opaque && j < fog.radius) {
+                blocked = true;
+                lit += CastLight(fog, grid, row, col, j + 1, start, leftSlope, octant);
+                nextStart = rightSlope;
+            }
+        }
+        if (blocked)
+            break;
+    }
+    return lit;
+}
+
+int UpdateFogOfWar(FogOfWar& fog, const std::vector<std::vector<int>>& grid, POINT viewer) {
+    if (viewer.x == fog.viewer.x && viewer.y == fog.viewer.y)
+        return -1;
+    // Nothing outside the radius box of the old viewpoint can be lit.
+    if (fog.viewer.x >= 0) {
+        int top = (std::max)(0, (int)fog.viewer.y - fog.radius);
+        int bottom = (std::min)(fog.rows - 1, (int)fog.viewer.y + fog.radius);
+        int left = (std::max)(0, (int)fog.viewer.x - fog.radius);
+        int right = (std::min)(fog.cols - 1, (int)fog.viewer.x + fog.radius);
+        for (int r = top; r <= bottom; r++) {
+            for (int c = left; c <= right; c++) {
+                size_t cell = (size_t)r * fog.cols + c;
+                fog.visible[cell >> 6] &= ~(1ull << (cell & 63));
+            }
+        }
+    }
+    fog.viewer = viewer;
+    int row = viewer.y, col = viewer.x;
+    if (row < 0 || row >= fog.rows || col < 0 || col >= fog.cols)
+        return 0;
+    int lit = Reveal(fog, row, col);
+    for (int i = 0; i < 8; i++)
+        lit += CastLight(fog, grid, row, col, 1, 1.0, 0.0, OCTANTS[i]);
+    return lit;
+}
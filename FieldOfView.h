@@ -0,0 +1,44 @@
+// FieldOfView.h : line of sight and explored cells for the fog-of-war mode
+//
+// The player sees the cells within FOV_RADIUS that have a clear line of
+// sight; WALL and OBSTACLE cells block it but are seen themselves. Sight is
+// found by recursive shadowcasting: each of the eight octants is scanned row
+// by row outwards, and a blocking cell narrows the slopes still lit instead
+// of being tested against a ray per cell. A move only clears the radius box
+// around the old position and casts from the new one, so the cost does not
+// depend on the level size.
+//
+// Every cell ever seen stays explored for the rest of the game.
+
+#pragma once
+
+#include "MazeGame.h"
+#include <cstddef>
+
+#define FOV_RADIUS 4
+
+struct FogOfWar {
+    int rows = 0;
+    int cols = 0;
+    int radius = FOV_RADIUS;
+    POINT viewer = { -1, -1 };      // position the visible set was cast from
+    std::vector<uint64_t> visible;  // row-major bitsets
+    std::vector<uint64_t> explored;
+
+    bool Visible(int row, int col) const { return TestBit(visible, row, col); }
+    bool Explored(int row, int col) const { return TestBit(explored, row, col); }
+
+private:
+    bool TestBit(const std::vector<uint64_t>& bits, int row, int col) const {
+        size_t cell = (size_t)row * cols + col;
+        return (bits[cell >> 6] >> (cell & 63)) & 1;
+    }
+};
+
+// Fog for one level, with nothing seen yet.
+FogOfWar CreateFogOfWar(int rows, int cols, int radius = FOV_RADIUS);
+
+// Move the viewpoint to viewer: forget what was visible from the old one,
+// cast from the new one and mark every cell seen as explored. Returns the
+// number of cells now visible, or -1 if the viewpoint did not change.
+int UpdateFogOfWar(FogOfWar& fog, const std::vector<std::vector<int>>& grid, POINT viewer);
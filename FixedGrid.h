@@ -0,0 +1,306 @@
+// FixedGrid.h : maze generation on grids whose size is a template argument
+//
+// The shipped levels are always GRID_ROWS x GRID_COLS, but the functions in
+// MazeGenerator.h take any size and pay for it with nested vectors, a heap
+// allocation per row and std::stack / std::queue traffic. The overloads here
+// take the size as template arguments instead: every buffer is a fixed array
+// on the stack, neighbour offsets are compile-time constants and the loops
+// have constant trip counts the compiler can unroll.
+//
+// They draw from the MazeRng exactly as the vector versions do, so a seed
+// gives the same level either way. GenerateRandomMazeLevel() uses them for
+// the default size and keeps the vector code for every other one. Everything
+// here is constexpr as well, which is how BakedLevels.cpp has the compiler
+// generate whole levels.
+
+#pragma once
+
+#include "MazeGenerator.h"
+
+// FixedMaze::walls bits, one per side still standing.
+#define MAZE_WALL_TOP     0x1
+#define MAZE_WALL_RIGHT   0x2
+#define MAZE_WALL_BOTTOM  0x4
+#define MAZE_WALL_LEFT    0x8
+#define MAZE_WALL_ALL     0xF
+
+// Plain array that can also be written in constant expressions, which
+// std::array only allows from C++17 on.
+template <typename T, int N>
+struct FixedArray {
+    T items[N];
+
+    constexpr T& operator[](int i) { return items[i]; }
+    constexpr const T& operator[](int i) const { return items[i]; }
+};
+
+// Packed set of N flags, a bitset that can be used in constant expressions,
+// which std::bitset cannot.
+template <int N>
+struct FixedBits {
+    uint32_t words[(N + 31) / 32];
+
+    constexpr bool Test(int i) const { return (words[i >> 5] >> (i & 31)) & 1; }
+    constexpr void Set(int i) { words[i >> 5] |= 1u << (i & 31); }
+};
+
+// Cell values in row-major order.
+template <int Rows, int Cols>
+struct FixedGrid {
+    static_assert(Rows > 0 && Cols > 0, "grid must not be empty");
+
+    FixedArray<uint8_t, Rows * Cols> cells{};
+
+    constexpr uint8_t& operator()(int row, int col) { return cells[row * Cols + col]; }
+    constexpr uint8_t operator()(int row, int col) const { return cells[row * Cols + col]; }
+
+    // The grid as the rest of the game stores levels.
+    std::vector<std::vector<int>> ToVector() const {
+        std::vector<std::vector<int>> grid(Rows, std::vector<int>(Cols));
+        for (int r = 0; r < Rows; r++)
+            for (int c = 0; c < Cols; c++)
+                grid[r][c] = cells[r * Cols + c];
+        return grid;
+    }
+};
+
+// Carve state of a FixedGrid-sized maze: the walls each cell still has and
+// the cells the DFS has visited.
+template <int Rows, int Cols>
+struct FixedMaze {
+    FixedArray<uint8_t, Rows * Cols> walls{};
+    FixedBits<Rows * Cols> visited{};
+
+    constexpr FixedMaze() {
+        for (int cell = 0; cell < Rows * Cols; cell++)
+            walls[cell] = MAZE_WALL_ALL;
+    }
+};
+
+// Moves in the order the vector code tries them: up, right, down, left.
+namespace FixedGridDetail {
+    constexpr int STEP_X[4] = { 0, 1, 0, -1 };
+    constexpr int STEP_Y[4] = { -1, 0, 1, 0 };
+    constexpr uint8_t WALL_BIT[4] = { MAZE_WALL_TOP, MAZE_WALL_RIGHT, MAZE_WALL_BOTTOM, MAZE_WALL_LEFT };
+
+    // Index difference between a cell and its neighbour in direction dir.
+    template <int Cols>
+    constexpr int Offset(int dir) {
+        return STEP_Y[dir] * Cols + STEP_X[dir];
+    }
+
+    // Whether the neighbour in direction dir is inside the grid.
+    template <int Rows, int Cols>
+    constexpr bool HasNeighbor(int cell, int dir) {
+        switch (dir) {
+        case 0: return cell >= Cols;
+        case 1: return cell % Cols != Cols - 1;
+        case 2: return cell < (Rows - 1) * Cols;
+        default: return cell % Cols != 0;
+        }
+    }
+
+    // Whether SealUnreachableIslands() lets the player walk a cell.
+    constexpr bool Walkable(int value) {
+        return value != WALL && value != OBSTACLE && value != HAZARD;
+    }
+
+    // Root of a provisional region label, halving the path on the way.
+    template <int N>
+    constexpr int FindLabel(FixedArray<int, N>& parent, int label) {
+        while (parent[label] != label) {
+            parent[label] = parent[parent[label]];
+            label = parent[label];
+        }
+        return label;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Fixed-Size Generation Functions
+//-----------------------------------------------------------------------------
+
+// Maze generation using DFS; the stack is an array as deep as the grid.
+template <int Rows, int Cols>
+constexpr void GenerateMazeDFS(FixedMaze<Rows, Cols>& maze, int startRow, int startCol, MazeRng& rng) {
+    using namespace FixedGridDetail;
+    FixedArray<int, Rows * Cols> stack{};
+    int top = 0;
+    int start = startRow * Cols + startCol;
+    maze.visited.Set(start);
+    stack[top++] = start;
+    while (top > 0) {
+        int cell = stack[top - 1];
+        int choices[4] = {};
+        int count = 0;
+        for (int dir = 0; dir < 4; dir++) {
+            if (HasNeighbor<Rows, Cols>(cell, dir) && !maze.visited.Test(cell + Offset<Cols>(dir)))
+                choices[count++] = dir;
+        }
+        if (count > 0) {
+            int dir = choices[rng.Below(count)];
+            int next = cell + Offset<Cols>(dir);
+            maze.walls[cell] &= ~WALL_BIT[dir];
+            maze.walls[next] &= ~WALL_BIT[(dir + 2) & 3];
+            maze.visited.Set(next);
+            stack[top++] = next;
+        }
+        else {
+            top--;
+        }
+    }
+}
+
+// Convert the carved maze to cell values, as the vector ConvertMazeToGrid().
+template <int Rows, int Cols>
+constexpr void ConvertMazeToGrid(const FixedMaze<Rows, Cols>& maze, FixedGrid<Rows, Cols>& grid) {
+    for (int cell = 0; cell < Rows * Cols; cell++)
+        grid.cells[cell] = maze.walls[cell] != MAZE_WALL_ALL || maze.visited.Test(cell) ? PASSAGE : WALL;
+    grid.cells[0] = PASSAGE;
+    grid.cells[Rows * Cols - 1] = PASSAGE;
+}
+
+// BFS over PASSAGE cells from the start. Fills parent (when given) with each
+// reached cell's predecessor and returns whether the exit was reached.
+template <int Rows, int Cols>
+constexpr bool SearchFixedPath(const FixedGrid<Rows, Cols>& grid, FixedArray<int, Rows * Cols>* parent) {
+    using namespace FixedGridDetail;
+    FixedArray<int, Rows * Cols> queue{};
+    FixedBits<Rows * Cols> visited{};
+    const int end = Rows * Cols - 1;
+    int head = 0, tail = 0;
+    queue[tail++] = 0;
+    visited.Set(0);
+    while (head < tail) {
+        int cell = queue[head++];
+        if (cell == end)
+            return true;
+        for (int dir = 0; dir < 4; dir++) {
+            int next = cell + Offset<Cols>(dir);
+            if (!HasNeighbor<Rows, Cols>(cell, dir) || visited.Test(next) || grid.cells[next] != PASSAGE)
+                continue;
+            visited.Set(next);
+            if (parent)
+                (*parent)[next] = cell;
+            queue[tail++] = next;
+        }
+    }
+    return false;
+}
+
+// Check if there is a valid path from start to end.
+template <int Rows, int Cols>
+constexpr bool IsPathValid(const FixedGrid<Rows, Cols>& grid) {
+    return SearchFixedPath<Rows, Cols>(grid, nullptr);
+}
+
+// The path the vector GetValidPath() finds, as cell indices from the exit
+// back to the start. Returns its length, 0 if there is no path.
+template <int Rows, int Cols>
+constexpr int GetValidPath(const FixedGrid<Rows, Cols>& grid, FixedArray<int, Rows * Cols>& path) {
+    FixedArray<int, Rows * Cols> parent{};
+    if (!SearchFixedPath<Rows, Cols>(grid, &parent))
+        return 0;
+    int length = 0;
+    for (int cell = Rows * Cols - 1; cell != 0; cell = parent[cell])
+        path[length++] = cell;
+    path[length++] = 0;
+    return length;
+}
+
+// Decorate the maze exactly as the vector DecorateMaze() does.
+template <int Rows, int Cols>
+constexpr void DecorateMaze(FixedGrid<Rows, Cols>& grid, MazeRng& rng, const DecorationMix& mix = DecorationMix()) {
+    FixedArray<int, Rows * Cols> path{};
+    FixedBits<Rows * Cols> onPath{};
+    int length = GetValidPath(grid, path);
+    for (int i = 0; i < length; i++)
+        onPath.Set(path[i]);
+    for (int cell = 1; cell < Rows * Cols - 1; cell++) {
+        if (grid.cells[cell] == PASSAGE && !onPath.Test(cell))
+            grid.cells[cell] = (uint8_t)mix.CellForRoll(rng.Below(100));
+    }
+    for (int cell = 0; cell < Rows * Cols; cell++) {
+        if (grid.cells[cell] == PASSAGE)
+            grid.cells[cell] = MINIDOT;
+    }
+}
+
+// Fill the regions the start cannot reach, as the vector
+// SealUnreachableIslands() does.
+template <int Rows, int Cols>
+constexpr LevelReach SealUnreachableIslands(FixedGrid<Rows, Cols>& grid) {
+    using namespace FixedGridDetail;
+    LevelReach reach;
+    FixedArray<int, Rows * Cols> label{};
+    FixedArray<int, Rows * Cols> parent{};
+    FixedBits<Rows * Cols> counted{};
+    if (!Walkable(grid.cells[0]))
+        return reach;
+    int labels = 0;
+    for (int cell = 0; cell < Rows * Cols; cell++) {
+        label[cell] = -1;
+        if (!Walkable(grid.cells[cell]))
+            continue;
+        int up = cell >= Cols ? label[cell - Cols] : -1;
+        int left = cell % Cols ? label[cell - 1] : -1;
+        if (up < 0 && left < 0) {
+            label[cell] = labels;
+            parent[labels] = labels;
+            labels++;
+        }
+        else if (up < 0 || left < 0) {
+            label[cell] = up > left ? up : left;
+        }
+        else {
+            int a = FindLabel(parent, up), b = FindLabel(parent, left);
+            parent[a > b ? a : b] = a < b ? a : b;
+            label[cell] = a < b ? a : b;
+        }
+    }
+    int startRoot = FindLabel(parent, label[0]);
+    for (int cell = 0; cell < Rows * Cols; cell++) {
+        uint8_t value = grid.cells[cell];
+        if (label[cell] < 0) {
+            bool touched = false;
+            for (int dir = 0; dir < 4 && value == HAZARD && !touched; dir++) {
+                int next = cell + Offset<Cols>(dir);
+                if (HasNeighbor<Rows, Cols>(cell, dir) && label[next] >= 0)
+                    touched = FindLabel(parent, label[next]) == startRoot;
+            }
+            reach.hazards += touched;
+            continue;
+        }
+        int root = FindLabel(parent, label[cell]);
+        if (root == startRoot) {
+            reach.collectibles += value == COLLECTIBLE;
+            reach.minidots += value == MINIDOT;
+            continue;
+        }
+        if (!counted.Test(root)) {
+            counted.Set(root);
+            reach.islands++;
+        }
+        reach.sealedItems += value == COLLECTIBLE || value == MINIDOT;
+        reach.sealedCells++;
+        grid.cells[cell] = OBSTACLE;
+    }
+    return reach;
+}
+
+// Generate one valid maze level and decorate it.
+template <int Rows, int Cols>
+constexpr void GenerateRandomMazeLevel(MazeRng& rng, FixedGrid<Rows, Cols>& grid) {
+    while (true) {
+        FixedMaze<Rows, Cols> maze;
+        GenerateMazeDFS(maze, 0, 0, rng);
+        ConvertMazeToGrid(maze, grid);
+        if (IsPathValid(grid)) {
+            DecorateMaze(grid, rng);
+            grid.cells[0] = PASSAGE;
+            grid.cells[Rows * Cols - 1] = PASSAGE;
+            SealUnreachableIslands(grid);
+            return;
+        }
+    }
+}
@@ -0,0 +1,329 @@
+#include "GameSession.h"
+#include "MazeGenerator.h"
+#include "BakedLevels.h"
+#include "InputRecording.h"
+#include "Tracing.h"
+
+void GameSession::NewGame(uint32_t levelSeed, int levelCount) {
+    TRACE_SCOPE("NewGame");
+    seed = levelSeed;
+    MazeRng rng(levelSeed);
+    levels.clear();
+    // Campaign seeds were generated at compile time; copy those levels.
+    const BakedCampaign* baked = generator == LEVELGEN_CLASSIC && levelCount == TOTAL_LEVELS
+        ? FindBakedCampaign(levelSeed) : nullptr;
+    for (int i = 0; i < levelCount; i++) {
+        if (baked)
+            levels.push_back(BakedLevelGrid(*baked, i));
+        else if (generator == LEVELGEN_TARGETED)
+            levels.push_back(GenerateTargetedMazeLevel(rng, TargetDifficulty(i, levelCount)));
+        else
+            levels.push_back(GenerateRandomMazeLevel(rng));
+    }
+    // Pads draw from their own stream, so every seed still gives the mazes
+    // it gave before there were pads.
+    MazeRng padRng(levelSeed ^ 0x7E1E9047u);
+    PlaceTeleporters(levels, padRng);
+    teleporters = BuildTeleportNetwork(levels);
+    currentLevel = 0;
+    lives = 2;
+    timeLeft = 15;
+    score = 0;
+    playerPosition = { 0, 0 };
+    endPosition = { (long)levels[0][0].size() - 1, (long)levels[0].size() - 1 };
+    history.Clear();
+}
+
+StepResult GameSession::Step(GameAction action) {
+    if (action == ACTION_TICK)
+        return Tick();
+    if (action == ACTION_UNDO)
+        return Undo() ? STEP_MOVED : STEP_BLOCKED;
+    if (action == ACTION_REDO)
+        return Redo() ? STEP_MOVED : STEP_BLOCKED;
+    if (action == ACTION_HIT)
+        return Hit();
+    int dx, dy;
+    MoveDirectionStep(action, dx, dy);
+    return Move(dx, dy);
+}
+
+StepResult GameSession::Move(int dx, int dy) {
+    StepSnapshot before = Snapshot(dx, dy);
+    StepResult result = ApplyMove(dx, dy);
+    if (RecordStep(before, dx, dy))
+        history.Push(lastStep);
+    return result;
+}
+
+// Ticks and hits are not undone, so Z always takes back a move. One that
+// sends the player back to the start ends the history: the moves before it
+// no longer lead to where the player is.
+StepResult GameSession::Tick() {
+    StepSnapshot before = Snapshot(0, 0);
+    StepResult result = ApplyTick();
+    RecordStep(before, 0, 0);
+    if (result != STEP_MOVED)
+        history.Clear();
+    return result;
+}
+
+StepResult GameSession::Hit() {
+    StepSnapshot before = Snapshot(0, 0);
+    StepResult result = ApplyHit();
+    RecordStep(before, 0, 0);
+    history.Clear();
+    return result;
+}
+
+StepResult GameSession::ApplyMove(int dx, int dy) {
+    std::vector<std::vector<int>>& grid = levels[currentLevel];
+    int rows = grid.size(), cols = grid[0].size();
+    StepResult result = STEP_BLOCKED;
+    int newX = playerPosition.x + dx;
+    int newY = playerPosition.y + dy;
+    if (newX >= 0 && newX < cols && newY >= 0 && newY < rows) {
+        int cellValue = grid[newY][newX];
+        if (cellValue == WALL || cellValue == OBSTACLE) {
+            return STEP_BLOCKED;
+        }
+        else if (cellValue == HAZARD) {
+            lives--;
+            // Optionally adjust timeLeft if desired.
+            playerPosition = { 0, 0 };
+            return lives <= 0 ? STEP_GAME_OVER : STEP_HAZARD;
+        }
+        else if (cellValue == COLLECTIBLE) {
+            lives++;
+            timeLeft += 5;
+            SetCell(currentLevel, { newX, newY }, PASSAGE);
+            result = STEP_COLLECTED;
+        }
+        else if (cellValue == MINIDOT) {
+            score++;
+            SetCell(currentLevel, { newX, newY }, PASSAGE);
+            result = STEP_DOT;
+        }
+        else if (cellValue == TELEPORTER
+                 && TeleportDestination(teleporters, currentLevel, { newX, newY }, currentLevel, playerPosition)) {
+            return STEP_TELEPORTED;
+        }
+        else {
+            result = STEP_MOVED;
+        }
+        playerPosition.x = newX;
+        playerPosition.y = newY;
+    }
+    if (playerPosition.x == endPosition.x && playerPosition.y == endPosition.y) {
+        if (currentLevel < (int)levels.size() - 1) {
+            currentLevel++;
+            playerPosition = { 0, 0 };
+            timeLeft = 25;
+            return STEP_NEXT_LEVEL;
+        }
+        return STEP_VICTORY;
+    }
+    return result;
+}
+
+StepResult GameSession::ApplyTick() {
+    timeLeft--;
+    if (timeLeft <= 0) {
+        lives--;
+        if (lives <= 0)
+            return STEP_GAME_OVER;
+        timeLeft = 25;
+        playerPosition = { 0, 0 };
+        return STEP_TIME_UP;
+    }
+    return STEP_MOVED;
+}
+
+StepResult GameSession::ApplyHit() {
+    lives--;
+    playerPosition = { 0, 0 };
+    return lives <= 0 ? STEP_GAME_OVER : STEP_HAZARD;
+}
+
+//-----------------------------------------------------------------------------
+// Undo Functions
+//-----------------------------------------------------------------------------
+
+GameSession::StepSnapshot GameSession::Snapshot(int dx, int dy) const {
+    StepSnapshot step = { playerPosition, currentLevel, lives, timeLeft, score, WALL };
+    const std::vector<std::vector<int>>& grid = levels[currentLevel];
+    int tx = playerPosition.x + dx, ty = playerPosition.y + dy;
+    if ((dx || dy) && tx >= 0 && tx < (int)grid[0].size() && ty >= 0 && ty < (int)grid.size())
+        step.targetCell = grid[ty][tx];
+    return step;
+}
+
+// Describe what the step changed in lastStep; returns false for a step that
+// changed nothing. A delta that does not fit the packed fields empties the
+// history rather than recording something Undo() would apply wrongly.
+bool GameSession::RecordStep(const StepSnapshot& before, int dx, int dy) {
+    lastStepKept = false;
+    UndoDelta delta = {};
+    POINT expected = before.position;
+    if (dx || dy) {
+        delta.flags = (uint8_t)MoveDirectionIndex(dx, dy);
+        if (before.targetCell != WALL && before.targetCell != OBSTACLE) {
+            int tx = before.position.x + dx, ty = before.position.y + dy;
+            int cellNow = levels[before.level][ty][tx];
+            if (cellNow != before.targetCell) {
+                delta.flags |= UNDO_CELL_CHANGED;
+                delta.cells = (uint8_t)(before.targetCell | (cellNow << 4));
+            }
+            if (before.targetCell != HAZARD) {
+                delta.flags |= UNDO_ENTERED;
+                expected = { tx, ty };
+            }
+        }
+    }
+    else {
+        delta.flags = UNDO_TICK;
+    }
+    bool elsewhere = currentLevel != before.level || playerPosition.x != expected.x
+        || playerPosition.y != expected.y;
+    if (elsewhere && before.targetCell == TELEPORTER)
+        delta.flags |= UNDO_TELEPORT;
+    else if (currentLevel != before.level)
+        delta.flags |= UNDO_NEXT_LEVEL;
+    else if (elsewhere)
+        delta.flags |= UNDO_RESET;
+    int livesDelta = lives - before.lives;
+    int timeDelta = timeLeft - before.timeLeft;
+    int scoreDelta = score - before.score;
+    bool changed = (delta.flags & (UNDO_ENTERED | UNDO_CELL_CHANGED | UNDO_RESET | UNDO_NEXT_LEVEL | UNDO_TELEPORT))
+        || livesDelta || timeDelta || scoreDelta;
+    if (!changed)
+        return false;
+    if (livesDelta != (int8_t)livesDelta || scoreDelta != (int8_t)scoreDelta || timeDelta != (int16_t)timeDelta
+        || before.position.x > 0xFFFF || before.position.y > 0xFFFF) {
+        history.Clear();
+        return false;
+    }
+    delta.livesDelta = (int8_t)livesDelta;
+    delta.timeDelta = (int16_t)timeDelta;
+    delta.scoreDelta = (int8_t)scoreDelta;
+    delta.fromX = (uint16_t)before.position.x;
+    delta.fromY = (uint16_t)before.position.y;
+    lastStep = delta;
+    lastStepKept = true;
+    return true;
+}
+
+const UndoDelta* GameSession::LastStep() const {
+    return lastStepKept ? &lastStep : nullptr;
+}
+
+const UndoDelta* GameSession::Undo() {
+    const UndoDelta* delta = history.Undo();
+    if (!delta)
+        return nullptr;
+    if (delta->flags & UNDO_NEXT_LEVEL)
+        currentLevel--;
+    // The player stands on the partner of the pad they stepped onto, which
+    // leads back to the level the step started on.
+    POINT pad;
+    if (delta->flags & UNDO_TELEPORT)
+        TeleportDestination(teleporters, currentLevel, playerPosition, currentLevel, pad);
+    if (delta->flags & UNDO_CELL_CHANGED)
+        SetCell(currentLevel, delta->Target(), delta->OldCell());
+    playerPosition = { (long)delta->fromX, (long)delta->fromY };
+    lives -= delta->livesDelta;
+    timeLeft -= delta->timeDelta;
+    score -= delta->scoreDelta;
+    return delta;
+}
+
+const UndoDelta* GameSession::Redo() {
+    const UndoDelta* delta = history.Redo();
+    if (!delta)
+        return nullptr;
+    playerPosition = { (long)delta->fromX, (long)delta->fromY };
+    if (!(delta->flags & UNDO_TICK)) {
+        POINT target = delta->Target();
+        if (delta->flags & UNDO_CELL_CHANGED)
+            SetCell(currentLevel, target, delta->NewCell());
+        if (delta->flags & UNDO_ENTERED)
+            playerPosition = target;
+    }
+    if (delta->flags & UNDO_TELEPORT)
+        TeleportDestination(teleporters, currentLevel, delta->Target(), currentLevel, playerPosition);
+    if (delta->flags & UNDO_RESET)
+        playerPosition = { 0, 0 };
+    if (delta->flags & UNDO_NEXT_LEVEL) {
+        currentLevel++;
+        playerPosition = { 0, 0 };
+    }
+    lives += delta->livesDelta;
+    timeLeft += delta->timeDelta;
+    score += delta->scoreDelta;
+    return delta;
+}
+
+// Write one cell and keep the portal table of its level in line.
+void GameSession::SetCell(int level, POINT cell, int value) {
+    int& slot = levels[level][cell.y][cell.x];
+    int old = slot;
+    slot = value;
+    PortalCellChanged(teleporters, levels, level, old, value);
+}
+
+int GameSession::RouteToFinish() {
+    return ShortestRouteSteps(teleporters, levels, currentLevel, playerPosition);
+}
+
+uint64_t GameSession::StateHash() const {
+    uint64_t hash = HASH_SEED;
+    int32_t fields[] = { currentLevel, lives, timeLeft, score, (int32_t)playerPosition.x, (int32_t)playerPosition.y };
+    hash = HashCombine(hash, fields, sizeof(fields));
+    for (const auto& grid : levels)
+        for (const auto& row : grid)
+            hash = HashCombine(hash, row.data(), row.size() * sizeof(int));
+    return hash;
+}
+
+SaveGameData GameSession::ToSaveData() const {
+    SaveGameData data;
+    data.seed = seed;
+    data.currentLevel = currentLevel;
+    data.lives = lives;
+    data.timeLeft = timeLeft;
+    data.score = score;
+    data.playerPosition = playerPosition;
+    data.levels = levels;
+    return data;
+}
+
+void GameSession::LoadSaveData(const SaveGameData& data) {
+    seed = data.seed;
+    currentLevel = data.currentLevel;
+    lives = data.lives;
+    timeLeft = data.timeLeft;
+    score = data.score;
+    playerPosition = data.playerPosition;
+    levels = data.levels;
+    endPosition = { (long)levels[0][0].size() - 1, (long)levels[0].size() - 1 };
+    teleporters = BuildTeleportNetwork(levels);
+    history.Clear();
+}
+
+bool GameSession::LoadSharedLevel(const std::vector<std::vector<int>>& grid) {
+    const std::vector<std::vector<int>>& current = levels[currentLevel];
+    if (grid.size() != current.size() || grid[0].size() != current[0].size())
+        return false;
+    for (const auto& row : grid)
+        for (int value : row)
+            if (value < PASSAGE || value > TELEPORTER)
+                return false;
+    if (grid[0][0] != PASSAGE || grid[endPosition.y][endPosition.x] != PASSAGE)
+        return false;
+    levels[currentLevel] = grid;
+    teleporters = BuildTeleportNetwork(levels);
+    playerPosition = { 0, 0 };
+    timeLeft = 25;
+    history.Clear();
+    return true;
+}
@@ -0,0 +1,115 @@
+// GameSession.h : one self-contained game (levels, player state and rules)
+//
+// A session never touches the UI, sound, files or globals. Step() applies an
+// action and returns what happened; the window turns that into sound and
+// messages, while replays, benchmarks and bots just keep stepping.
+
+#pragma once
+
+#include "MazeGame.h"
+#include "SaveFile.h"
+#include "LevelSearch.h"
+#include "UndoHistory.h"
+#include "Teleporters.h"
+
+// Actions a session can take; the moves use the MoveDirectionIndex values,
+// so they match the input recording codes.
+enum GameAction {
+    ACTION_UP = 0,
+    ACTION_RIGHT = 1,
+    ACTION_DOWN = 2,
+    ACTION_LEFT = 3,
+    ACTION_TICK = 4,    // one second of the level timer
+    ACTION_UNDO = 5,    // revert the last step
+    ACTION_REDO = 6,    // apply the last undone step again
+    ACTION_HIT = 7      // a roaming hazard caught the player
+};
+
+// Events returned by one step of the rules.
+enum StepResult {
+    STEP_BLOCKED,      // move into a wall, obstacle or the edge; nothing to undo or redo
+    STEP_MOVED,        // plain move, a timer tick with time remaining, or an undo or redo
+    STEP_COLLECTED,    // picked up a COLLECTIBLE (extra life and time)
+    STEP_DOT,          // picked up a MINIDOT (score)
+    STEP_HAZARD,       // hit a HAZARD or a roaming hazard and went back to the start
+    STEP_TIME_UP,      // timer ran out and the level restarted
+    STEP_NEXT_LEVEL,   // reached the exit of a level
+    STEP_TELEPORTED,   // stepped onto a linked teleporter and came out at its partner
+    STEP_VICTORY,      // reached the exit of the last level
+    STEP_GAME_OVER     // no lives left
+};
+
+struct GameSession {
+    uint32_t seed = 0;
+    LevelGenerator generator = LEVELGEN_CLASSIC;   // used by NewGame()
+
+    // Container for maze levels; each level is a 2D vector (grid) of integers.
+    std::vector<std::vector<std::vector<int>>> levels;
+
+    // Player state: starting at (0,0) and ending at the bottom-right cell.
+    POINT playerPosition = { 0, 0 };
+    POINT endPosition = { GRID_COLS - 1, GRID_ROWS - 1 };
+
+    int currentLevel = 0;
+    int lives = 2;      // Player starts with 2 lives.
+    int timeLeft = 15;  // 15-second timer per level.
+    int score = 0;      // Score increases by 1 for every mini-dot collected.
+
+    // The moves that changed the state, for Undo() and Redo(). Timer ticks and
+    // roaming hazard hits are not kept (see Tick()).
+    UndoHistory history;
+
+    // Teleporter links and the per-level portal tables, rebuilt whenever
+    // the levels are replaced.
+    TeleportNetwork teleporters;
+
+    // Reset the player and generate the levels for a new game; the same seed
+    // always gives the same levels.
+    void NewGame(uint32_t levelSeed, int levelCount = TOTAL_LEVELS);
+
+    // Apply one action.
+    StepResult Step(GameAction action);
+    StepResult Move(int dx, int dy);
+    StepResult Tick();
+    // Caught by a roaming hazard: a life lost and back to the start.
+    StepResult Hit();
+    // Revert or re-apply one step; null if there is none. The returned delta
+    // says which cell changed, for views that cache the grid.
+    const UndoDelta* Undo();
+    const UndoDelta* Redo();
+    // What the last Move(), Tick() or Hit() changed, as the undo history
+    // describes a step; null if it changed nothing, or more than the packed
+    // fields can hold.
+    const UndoDelta* LastStep() const;
+
+    // Fewest moves from the player to the exit of the last level, using
+    // teleporters, or -1 if there is no hazard-free route.
+    int RouteToFinish();
+
+    // Hash of everything the rules can change; a replay must reproduce it exactly.
+    uint64_t StateHash() const;
+
+    SaveGameData ToSaveData() const;
+    void LoadSaveData(const SaveGameData& data);
+
+    // Replace the current level with a shared one (LevelFromShareCode) and
+    // start it over; the other levels, lives and score stay. Returns false if
+    // the level is not the size of the others, holds an unknown cell value or
+    // has its start or exit blocked.
+    bool LoadSharedLevel(const std::vector<std::vector<int>>& grid);
+
+private:
+    struct StepSnapshot {
+        POINT position;
+        int level, lives, timeLeft, score;
+        int targetCell;
+    };
+    StepSnapshot Snapshot(int dx, int dy) const;
+    bool RecordStep(const StepSnapshot& before, int dx, int dy);
+    void SetCell(int level, POINT cell, int value);
+    UndoDelta lastStep = {};
+    bool lastStepKept = false;
+    StepResult ApplyMove(int dx, int dy);
+    StepResult ApplyTick();
+    StepResult ApplyHit();
+};
@@ -0,0 +1,358 @@
+#include "HighScores.h"
+#include "SaveFile.h"
+#include "InputRecording.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+// Levels a node can have; with one node in four promoted per level this
+// covers far more entries than the table will ever hold.
+#define SKIP_MAX_LEVEL 24
+
+//-----------------------------------------------------------------------------
+// Skip List Functions
+//-----------------------------------------------------------------------------
+
+static uint64_t HighScoreKey(uint32_t seed, const char* name) {
+    return HashCombine(HashCombine(HASH_SEED, &seed, sizeof(seed)), name, strlen(name));
+}
+
+HighScoreTable::HighScoreTable() {
+    Clear();
+}
+
+void HighScoreTable::Clear() {
+    nodes.assign(1, Node());
+    memset(&nodes[0], 0, sizeof(Node));
+    nodes[0].level = SKIP_MAX_LEVEL;
+    links.assign(SKIP_MAX_LEVEL, { 0, 0, 0, 0 });
+    index.clear();
+    count = 0;
+    level = 1;
+    nextSequence = 0;
+}
+
+// True if the link's target ranks ahead of node.
+bool HighScoreTable::Ahead(const Link& link, uint32_t node) const {
+    int score = nodes[node].score;
+    return link.nextScore > score || (link.nextScore == score && nodes[link.next].sequence < nodes[node].sequence);
+}
+
+// The index is keyed by a 64-bit hash of (seed, name); on the rare collision
+// the next key value is tried.
+uint32_t HighScoreTable::Find(uint32_t seed, const char* name) const {
+    for (uint64_t key = HighScoreKey(seed, name);; key++) {
+        auto it = index.find(key);
+        if (it == index.end())
+            return 0;
+        const Node& node = nodes[it->second];
+        if (node.seed == seed && strcmp(node.name, name) == 0)
+            return it->second;
+    }
+}
+
+uint32_t HighScoreTable::NodeAt(size_t rank) const {
+    size_t target = rank + 1, traversed = 0;
+    uint32_t at = 0;
+    for (int i = level - 1; i >= 0; i--) {
+        while (links[at + i].next && traversed + links[at + i].span <= target) {
+            traversed += links[at + i].span;
+            if (traversed == target)
+                return links[at + i].next;
+            at = links[at + i].nextLinks;
+        }
+    }
+    return 0;
+}
+
+void HighScoreTable::Insert(uint32_t node) {
+    uint32_t update[SKIP_MAX_LEVEL];
+    size_t rank[SKIP_MAX_LEVEL];
+    uint32_t at = 0;
+    for (int i = level - 1; i >= 0; i--) {
+        rank[i] = i == level - 1 ? 0 : rank[i + 1];
+        while (links[at + i].next && Ahead(links[at + i], node)) {
+            rank[i] += links[at + i].span;
+            at = links[at + i].nextLinks;
+        }
+        update[i] = at;
+    }
+    const Node& entry = nodes[node];
+    for (; level < entry.level; level++) {
+        rank[level] = 0;
+        update[level] = 0;
+        links[level].span = (uint32_t)count;
+    }
+    for (int i = 0; i < entry.level; i++) {
+        Link& prev = links[update[i] + i];
+        uint32_t skipped = (uint32_t)(rank[0] - rank[i]);
+        links[entry.links + i] = { prev.next, prev.nextLinks, prev.span - skipped, prev.nextScore };
+        prev = { node, entry.links, skipped + 1, entry.score };
+    }
+    for (int i = entry.level; i < level; i++)
+        links[update[i] + i].span++;
+    count++;
+}
+
+void HighScoreTable::Remove(uint32_t node) {
+    uint32_t update[SKIP_MAX_LEVEL];
+    uint32_t at = 0;
+    for (int i = level - 1; i >= 0; i--) {
+        while (links[at + i].next && Ahead(links[at + i], node))
+            at = links[at + i].nextLinks;
+        update[i] = at;
+    }
+    const Node& entry = nodes[node];
+    for (int i = 0; i < level; i++) {
+        Link& prev = links[update[i] + i];
+        if (prev.next == node) {
+            const Link& removed = links[entry.links + i];
+            prev = { removed.next, removed.nextLinks, prev.span + removed.span - 1, removed.nextScore };
+        }
+        else {
+            prev.span--;
+        }
+    }
+    while (level > 1 && links[level - 1].next == 0)
+        level--;
+    count--;
+}
+
+//-----------------------------------------------------------------------------
+// HighScoreTable Functions
+//-----------------------------------------------------------------------------
+
+bool HighScoreTable::Submit(uint32_t seed, const std::string& name, int score) {
+    char key[HIGHSCORE_NAME_SIZE] = {};
+    memcpy(key, name.c_str(), (std::min)(name.size(), (size_t)HIGHSCORE_NAME_SIZE - 1));
+    uint32_t node = Find(seed, key);
+    if (node) {
+        // A better score moves the existing entry; its links are reused.
+        if (score <= nodes[node].score)
+            return false;
+        Remove(node);
+        nodes[node].score = score;
+        nodes[node].sequence = nextSequence++;
+        Insert(node);
+        return true;
+    }
+    Insert(AddNode(seed, key, score));
+    return true;
+}
+
+// Create an unlinked node and index it.
+uint32_t HighScoreTable::AddNode(uint32_t seed, const char* name, int score) {
+    Node entry = {};
+    entry.score = score;
+    entry.seed = seed;
+    entry.sequence = nextSequence++;
+    entry.links = (uint32_t)links.size();
+    entry.level = 1;
+    while (entry.level < SKIP_MAX_LEVEL && (rng.Next() & 3) == 0)
+        entry.level++;
+    memcpy(entry.name, name, HIGHSCORE_NAME_SIZE);
+    uint32_t node = (uint32_t)nodes.size();
+    nodes.push_back(entry);
+    links.resize(links.size() + entry.level, { 0, 0, 0, 0 });
+    uint64_t hash = HighScoreKey(seed, name);
+    while (index.count(hash))
+        hash++;
+    index[hash] = node;
+    return node;
+}
+
+void HighScoreTable::Load(const std::vector<HighScore>& results) {
+    Clear();
+    for (const HighScore& result : results) {
+        char key[HIGHSCORE_NAME_SIZE] = {};
+        memcpy(key, result.name.c_str(), (std::min)(result.name.size(), (size_t)HIGHSCORE_NAME_SIZE - 1));
+        uint32_t node = Find(result.seed, key);
+        if (!node) {
+            AddNode(result.seed, key, result.score);
+        }
+        else if (result.score > nodes[node].score) {
+            nodes[node].score = result.score;
+            nodes[node].sequence = nextSequence++;
+        }
+    }
+    std::vector<uint32_t> order;
+    order.reserve(nodes.size() - 1);
+    for (uint32_t i = 1; i < nodes.size(); i++)
+        order.push_back(i);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return nodes[a].score > nodes[b].score || (nodes[a].score == nodes[b].score && nodes[a].sequence < nodes[b].sequence);
+    });
+    // Link every level left to right; a link at the end of a level spans the
+    // rest of the list, as Insert() keeps it.
+    count = order.size();
+    uint32_t last[SKIP_MAX_LEVEL] = {};     // link offset of the last node per level
+    size_t lastRank[SKIP_MAX_LEVEL] = {};
+    for (size_t rank = 1; rank <= count; rank++) {
+        uint32_t node = order[rank - 1];
+        const Node& entry = nodes[node];
+        for (int i = 0; i < entry.level; i++) {
+            links[last[i] + i] = { node, entry.links, (uint32_t)(rank - lastRank[i]), entry.score };
+            last[i] = entry.links;
+            lastRank[i] = rank;
+        }
+        level = (std::max)(level, (int)entry.level);
+    }
+    for (int i = 0; i < level; i++)
+        links[last[i] + i] = { 0, 0, (uint32_t)(count - lastRank[i]), 0 };
+}
+
+long long HighScoreTable::Rank(uint32_t seed, const std::string& name) const {
+    char key[HIGHSCORE_NAME_SIZE] = {};
+    memcpy(key, name.c_str(), (std::min)(name.size(), (size_t)HIGHSCORE_NAME_SIZE - 1));
+    uint32_t node = Find(seed, key);
+    if (!node)
+        return -1;
+    size_t rank = 0;
+    uint32_t at = 0;
+    for (int i = level - 1; i >= 0; i--) {
+        while (links[at + i].next && (links[at + i].next == node || Ahead(links[at + i], node))) {
+            rank += links[at + i].span;
+            if (links[at + i].next == node)
+                return (long long)rank - 1;
+            at = links[at + i].nextLinks;
+        }
+    }
+    return -1;
+}
+
+size_t HighScoreTable::RankOfScore(int score) const {
+    size_t rank = 0;
+    uint32_t at = 0;
+    for (int i = level - 1; i >= 0; i--) {
+        while (links[at + i].next && links[at + i].nextScore >= score) {
+            rank += links[at + i].span;
+            at = links[at + i].nextLinks;
+        }
+    }
+    return rank;
+}
+
+std::vector<HighScore> HighScoreTable::Top(size_t n, size_t first) const {
+    std::vector<HighScore> result;
+    if (first >= count)
+        return result;
+    for (uint32_t cur = NodeAt(first); cur && result.size() < n; cur = links[nodes[cur].links].next)
+        result.push_back({ nodes[cur].seed, nodes[cur].name, nodes[cur].score });
+    return result;
+}
+
+std::vector<HighScore> HighScoreTable::InSubmitOrder() const {
+    std::vector<uint32_t> order;
+    order.reserve(count);
+    for (uint32_t i = 1; i < nodes.size(); i++)
+        order.push_back(i);
+    std::sort(order.begin(), order.end(),
+        [&](uint32_t a, uint32_t b) { return nodes[a].sequence < nodes[b].sequence; });
+    std::vector<HighScore> result;
+    result.reserve(order.size());
+    for (uint32_t i : order)
+        result.push_back({ nodes[i].seed, nodes[i].name, nodes[i].score });
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+// HighScoreStore Functions
+//-----------------------------------------------------------------------------
+
+static HighScoreRecord MakeRecord(uint32_t seed, const std::string& name, int score) {
+    HighScoreRecord record = {};
+    record.seed = seed;
+    record.score = score;
+    memcpy(record.name, name.c_str(), (std::min)(name.size(), (size_t)HIGHSCORE_NAME_SIZE - 1));
+    record.checksum = SaveChecksum((const unsigned char*)&record, offsetof(HighScoreRecord, checksum));
+    return record;
+}
+
+bool HighScoreStore::Open(const std::string& logPath) {
+    Close();
+    path = logPath;
+    table.Clear();
+    logRecords = 0;
+    bool rewrite = false;
+    bool exists = false;
+    {
+        MappedFile file;
+        if (file.Open(path)) {
+            exists = true;
+            const HighScoreHeader* header = (const HighScoreHeader*)file.Data();
+            if (file.Size() < sizeof(HighScoreHeader) || header->magic != HIGHSCORE_MAGIC
+                || header->version != HIGHSCORE_VERSION)
+                return false;
+            size_t available = (file.Size() - sizeof(HighScoreHeader)) / sizeof(HighScoreRecord);
+            const HighScoreRecord* records = (const HighScoreRecord*)(file.Data() + sizeof(HighScoreHeader));
+            std::vector<HighScore> results;
+            results.reserve(available);
+            for (; logRecords < available; logRecords++) {
+                const HighScoreRecord& record = records[logRecords];
+                if (SaveChecksum((const unsigned char*)&record, offsetof(HighScoreRecord, checksum)) != record.checksum
+                    || record.name[HIGHSCORE_NAME_SIZE - 1] != 0)
+                    break;
+                results.push_back({ record.seed, record.name, record.score });
+            }
+            table.Load(results);
+            // A torn last record (crash while appending) is dropped.
+            rewrite = logRecords != available
+                || file.Size() != sizeof(HighScoreHeader) + available * sizeof(HighScoreRecord)
+                || logRecords > 2 * table.Count() + 1024;
+        }
+    }
+    if (!exists || rewrite)
+        return Compact();
+    log.open(path, std::ios::binary | std::ios::app);
+    return (bool)log;
+}
+
+void HighScoreStore::Close() {
+    if (log.is_open())
+        log.close();
+}
+
+bool HighScoreStore::Submit(uint32_t seed, const std::string& name, int score) {
+    if (!table.Submit(seed, name, score))
+        return false;
+    if (log.is_open()) {
+        HighScoreRecord record = MakeRecord(seed, name, score);
+        log.write((const char*)&record, sizeof(record));
+        log.flush();
+        logRecords++;
+    }
+    return true;
+}
+
+// Write the new log next to the old one and move it over, so a crash never
+// leaves a half-written table behind.
+bool HighScoreStore::Compact() {
+    Close();
+    std::string tempPath = path + ".tmp";
+    std::vector<HighScore> entries = table.InSubmitOrder();
+    {
+        std::ofstream ofs(tempPath, std::ios::binary | std::ios::trunc);
+        if (!ofs)
+            return false;
+        HighScoreHeader header = { HIGHSCORE_MAGIC, HIGHSCORE_VERSION, 0 };
+        ofs.write((const char*)&header, sizeof(header));
+        std::vector<HighScoreRecord> records;
+        records.reserve(entries.size());
+        for (const HighScore& entry : entries)
+            records.push_back(MakeRecord(entry.seed, entry.name, entry.score));
+        ofs.write((const char*)records.data(), records.size() * sizeof(HighScoreRecord));
+        if (!ofs)
+            return false;
+    }
+#ifdef _WIN32
+    if (!MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+        return false;
+#else
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0)
+        return false;
+#endif
+    logRecords = entries.size();
+    log.open(path, std::ios::binary | std::ios::app);
+    return (bool)log;
+}
@@ -0,0 +1,122 @@
+// HighScores.h : local leaderboard with rank and top-k queries
+//
+// There is one entry per (level seed, player name), holding that player's
+// best score. Entries are kept in an indexable skip list: every link also
+// stores how many entries it skips, so insert, rank and the k-th entry are
+// all O(log n). Equal scores rank in the order they were reached.
+//
+// On disk the table is an append-only log (little-endian):
+//   HighScoreHeader
+//   HighScoreRecord[...]          one per result that changed the table
+// Loading replays the log; a log that is mostly superseded records, or ends
+// in a torn record, is rewritten with one record per entry.
+
+#pragma once
+
+#include "MazeGame.h"
+#include <fstream>
+#include <string>
+#include <unordered_map>
+
+#define HIGHSCORE_MAGIC 0x53485A4Du   // "MZHS"
+#define HIGHSCORE_VERSION 1
+#define HIGHSCORE_NAME_SIZE 16        // including the terminating zero
+
+#pragma pack(push, 1)
+struct HighScoreHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+};
+
+struct HighScoreRecord {
+    uint32_t seed;
+    int32_t score;
+    char name[HIGHSCORE_NAME_SIZE];   // zero padded
+    uint32_t checksum;                // SaveChecksum of the fields above
+};
+#pragma pack(pop)
+
+struct HighScore {
+    uint32_t seed;
+    std::string name;
+    int score;
+};
+
+class HighScoreTable {
+public:
+    HighScoreTable();
+
+    // Keep the best score per (seed, name); longer names are cut to 15
+    // characters. Returns true if the table changed.
+    bool Submit(uint32_t seed, const std::string& name, int score);
+    // 0-based rank of the entry for (seed, name), or -1 if there is none.
+    long long Rank(uint32_t seed, const std::string& name) const;
+    // Rank a new result with this score would get.
+    size_t RankOfScore(int score) const;
+    // Up to count entries from rank first on, best first.
+    std::vector<HighScore> Top(size_t count, size_t first = 0) const;
+    // Every entry in the order it was last changed, for rewriting the log.
+    std::vector<HighScore> InSubmitOrder() const;
+    // Replace the table with the outcome of submitting these results in
+    // order. Builds the list in one sorted pass instead of n inserts.
+    void Load(const std::vector<HighScore>& results);
+
+    size_t Count() const { return count; }
+    void Clear();
+
+private:
+    // Links refer to the next node both by index and by the offset of its
+    // links, so walking the list only ever reads the link pool.
+    struct Link {
+        uint32_t next;      // node index, 0 at the end of the list
+        uint32_t nextLinks; // next's first link in the pool
+        uint32_t span;      // entries from this node to next, including next
+        int32_t nextScore;  // next's score
+    };
+    struct Node {
+        int32_t score;
+        uint32_t seed;
+        uint64_t sequence;  // submit order; earlier wins ties
+        uint32_t links;     // first of this node's links in the pool
+        uint8_t level;
+        char name[HIGHSCORE_NAME_SIZE];
+    };
+
+    bool Ahead(const Link& link, uint32_t node) const;
+    uint32_t Find(uint32_t seed, const char* name) const;
+    uint32_t NodeAt(size_t rank) const;
+    uint32_t AddNode(uint32_t seed, const char* name, int score);
+    void Insert(uint32_t node);
+    void Remove(uint32_t node);
+
+    std::vector<Node> nodes;            // node 0 is the list head, its links at 0
+    std::vector<Link> links;
+    std::unordered_map<uint64_t, uint32_t> index;   // key hash -> node
+    size_t count = 0;
+    int level = 1;                      // levels in use
+    uint64_t nextSequence = 0;
+    MazeRng rng;
+};
+
+class HighScoreStore {
+public:
+    // Load the log, a missing file being an empty table, and keep it open
+    // for appending. Returns false if the file cannot be written.
+    bool Open(const std::string& path);
+    void Close();
+
+    // Submit a result and append it to the log if it changed the table.
+    bool Submit(uint32_t seed, const std::string& name, int score);
+    // Rewrite the log with one record per entry.
+    bool Compact();
+
+    const HighScoreTable& Table() const { return table; }
+    size_t LogRecords() const { return logRecords; }
+
+private:
+    HighScoreTable table;
+    std::string path;
+    std::ofstream log;
+    size_t logRecords = 0;
+};
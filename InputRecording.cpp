@@ -0,0 +1,66 @@
+#include "InputRecording.h"
+#include "GameSession.h"
+#include <chrono>
+
+bool InputRecorder::Start(const std::string& path, uint32_t seed) {
+    if (out.is_open())
+        out.close();
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+        return false;
+    ReplayHeader header = { REPLAY_MAGIC, REPLAY_VERSION, 0, seed };
+    out.write((const char*)&header, sizeof(header));
+    return true;
+}
+
+void InputRecorder::Record(InputCode code) {
+    if (out.is_open())
+        out.put((char)code);
+}
+
+void InputRecorder::Finish(uint64_t finalHash) {
+    if (!out.is_open())
+        return;
+    out.put((char)INPUT_END);
+    out.write((const char*)&finalHash, sizeof(finalHash));
+    out.close();
+}
+
+bool LoadInputRecording(const std::string& path, InputRecording& recording) {
+    std::ifstream ifs(path, std::ios::binary);
+    ReplayHeader header;
+    if (!ifs.read((char*)&header, sizeof(header)) ||
+        header.magic != REPLAY_MAGIC || header.version != REPLAY_VERSION)
+        return false;
+    recording.seed = header.seed;
+    recording.inputs.clear();
+    recording.hasFinalHash = false;
+    int code;
+    while ((code = ifs.get()) != EOF) {
+        if (code == INPUT_END) {
+            recording.hasFinalHash = (bool)ifs.read((char*)&recording.finalHash, sizeof(recording.finalHash));
+            break;
+        }
+        if (code > INPUT_HIT)
+            return false;
+        recording.inputs.push_back((uint8_t)code);
+    }
+    return true;
+}
+
+ReplayResult ReplayRecording(const InputRecording& recording, int repeat) {
+    ReplayResult result;
+    GameSession session;
+    auto begin = std::chrono::steady_clock::now();
+    for (int run = 0; run < repeat; run++) {
+        session.NewGame(recording.seed);
+        // Every recorded input is applied, including any the window handled
+        // after game over and before the message loop quit.
+        for (uint8_t input : recording.inputs)
+            session.Step((GameAction)input);
+        result.steps += recording.inputs.size();
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    result.finalHash = session.StateHash();
+    return result;
+}
@@ -0,0 +1,88 @@
+// InputRecording.h : compact recording of a session's input stream
+//
+// A new game is fully determined by its level seed plus the sequence of
+// moves, timer ticks, undos and redos, so that is all a recording holds:
+//   ReplayHeader
+//   one byte per input (INPUT_UP .. INPUT_HIT)
+//   INPUT_END followed by the 64-bit state hash at the end of the session
+
+#pragma once
+
+#include "MazeGame.h"
+#include <string>
+#include <fstream>
+
+#define REPLAY_MAGIC 0x43525A4Du   // "MZRC"
+#define REPLAY_VERSION 5           // 2: levels carry teleporter pads, 3: sealed-off islands are filled,
+                                   // 4: so are regions only reachable across a hazard,
+                                   // 5: undo skips ticks and hits
+
+// Input codes; the four moves use the MoveDirectionIndex values.
+enum InputCode {
+    INPUT_UP = 0,
+    INPUT_RIGHT = 1,
+    INPUT_DOWN = 2,
+    INPUT_LEFT = 3,
+    INPUT_TICK = 4,
+    INPUT_UNDO = 5,
+    INPUT_REDO = 6,
+    INPUT_HIT = 7,
+    INPUT_END = 0xFF
+};
+
+#pragma pack(push, 1)
+struct ReplayHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t seed;
+};
+#pragma pack(pop)
+
+// A recording read back into memory.
+struct InputRecording {
+    uint32_t seed = 0;
+    std::vector<uint8_t> inputs;
+    bool hasFinalHash = false;   // false if the session never finished cleanly
+    uint64_t finalHash = 0;
+};
+
+// Writes inputs as they happen. The stream is buffered; Finish() appends the
+// end marker and closes the file.
+class InputRecorder {
+public:
+    bool Start(const std::string& path, uint32_t seed);
+    void Record(InputCode code);
+    void Finish(uint64_t finalHash);
+    bool IsRecording() const { return out.is_open(); }
+
+private:
+    std::ofstream out;
+};
+
+bool LoadInputRecording(const std::string& path, InputRecording& recording);
+
+// Result of replaying a recording headlessly.
+struct ReplayResult {
+    uint64_t finalHash = 0;
+    uint64_t steps = 0;      // inputs applied over all runs
+    double seconds = 0;
+
+    double MovesPerSecond() const { return seconds > 0 ? steps / seconds : 0; }
+};
+
+// Re-run a recording through a GameSession as fast as possible, `repeat`
+// times for a stable moves/second figure.
+ReplayResult ReplayRecording(const InputRecording& recording, int repeat);
+
+// FNV-1a, 64-bit; used to build the state hash a replay must reproduce.
+#define HASH_SEED 14695981039346656037ull
+
+inline uint64_t HashCombine(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
@@ -0,0 +1,446 @@
+#include "LevelCodec.h"
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <utility>
+
+// Cell values per 100000 over the levels of 20000 new games (pads placed).
+// The built-in code treats the cells of a group as independent, weighting
+// each group by the product of these plus one, so every group has a code.
+static const uint32_t DEFAULT_CELL_COUNTS[LEVEL_CODEC_VALUES] = {
+    2000,       // PASSAGE
+    0,          // WALL
+    4045,       // COLLECTIBLE
+    8092,       // HAZARD
+    16206,      // OBSTACLE
+    66055,      // MINIDOT
+    3600,       // TELEPORTER
+    0,
+};
+
+#define CODE_TABLE_BYTES (LEVEL_CODEC_SYMBOLS / 2)
+#define FLAG_OWN_CODE 0x1
+
+//-----------------------------------------------------------------------------
+// Code Functions
+//-----------------------------------------------------------------------------
+
+// Huffman code lengths for the symbol counts. While the longest code is
+// over LEVEL_CODEC_MAX_BITS the counts are halved (keeping used symbols at
+// one or more) and the tree rebuilt, which flattens it.
+static void BuildCodeLengths(const uint64_t* counts, uint8_t* lengths) {
+    uint64_t weight[LEVEL_CODEC_SYMBOLS];
+    for (int s = 0; s < LEVEL_CODEC_SYMBOLS; s++)
+        weight[s] = counts[s];
+    while (true) {
+        memset(lengths, 0, LEVEL_CODEC_SYMBOLS);
+        std::priority_queue<std::pair<uint64_t, int>, std::vector<std::pair<uint64_t, int>>,
+            std::greater<std::pair<uint64_t, int>>> open;
+        for (int s = 0; s < LEVEL_CODEC_SYMBOLS; s++) {
+            if (weight[s])
+                open.push({ weight[s], s });
+        }
+        if (open.empty())
+            return;
+        if (open.size() == 1) {
+            lengths[open.top().second] = 1;
+            return;
+        }
+        int parent[2 * LEVEL_CODEC_SYMBOLS];
+        int next = LEVEL_CODEC_SYMBOLS;
+        while (open.size() > 1) {
+            std::pair<uint64_t, int> a = open.top();
+            open.pop();
+            std::pair<uint64_t, int> b = open.top();
+            open.pop();
+            parent[a.second] = next;
+            parent[b.second] = next;
+            open.push({ a.first + b.first, next++ });
+        }
+        int root = next - 1;
+        int longest = 0;
+        for (int s = 0; s < LEVEL_CODEC_SYMBOLS; s++) {
+            if (!weight[s])
+                continue;
+            int depth = 0;
+            for (int node = s; node != root; node = parent[node])
+                depth++;
+            lengths[s] = (uint8_t)depth;
+            longest = (std::max)(longest, depth);
+        }
+        if (longest <= LEVEL_CODEC_MAX_BITS)
+            return;
+        for (int s = 0; s < LEVEL_CODEC_SYMBOLS; s++) {
+            if (weight[s])
+                weight[s] = (weight[s] + 1) / 2;
+        }
+    }
+}
+
+bool BuildLevelCode(const uint8_t* lengths, LevelCode& code) {
+    int perLength[LEVEL_CODEC_MAX_BITS + 1] = {};
+    uint32_t space = 0;     // Kraft sum in units of 2^-LEVEL_CODEC_MAX_BITS
+    for (int s = 0; s < LEVEL_CODEC_SYMBOLS; s++) {
+        if (lengths[s] > LEVEL_CODEC_MAX_BITS)
+            return false;
+        if (lengths[s]) {
+            perLength[lengths[s]]++;
+            space += 1u << (LEVEL_CODEC_MAX_BITS - lengths[s]);
+        }
+    }
+    if (space == 0 || space > (1u << LEVEL_CODEC_MAX_BITS))
+        return false;
+
+    // Canonical codes: shorter codes first, by symbol within a length.
+    int nextCode[LEVEL_CODEC_MAX_BITS + 1] = {};
+    int value = 0;
+    for (int length = 1; length <= LEVEL_CODEC_MAX_BITS; length++) {
+        value = (value + perLength[length - 1]) << 1;
+        nextCode[length] = value;
+    }
+    memcpy(code.lengths, lengths, LEVEL_CODEC_SYMBOLS);
+    memset(code.codes, 0, sizeof(code.codes));
+    memset(code.decode, 0, sizeof(code.decode));
+    for (int s = 0; s < LEVEL_CODEC_SYMBOLS; s++) {
+        int length = lengths[s];
+        if (!length)
+            continue;
+        int canonical = nextCode[length]++;
+        int reversed = 0;
+        for (int bit = 0; bit < length; bit++)
+            reversed |= ((canonical >> bit) & 1) << (length - 1 - bit);
+        code.codes[s] = (uint16_t)reversed;
+        int first = s >> 6, second = (s >> 3) & 7, third = s & 7;
+        uint16_t entry = (uint16_t)(length | first << 4 | second << 7 | third << 10);
+        for (int index = reversed; index < (1 << LEVEL_CODEC_MAX_BITS); index += 1 << length)
+            code.decode[index] = entry;
+    }
+    return true;
+}
+
+static LevelCode MakeDefaultCode() {
+    uint64_t counts[LEVEL_CODEC_SYMBOLS];
+    for (int s = 0; s < LEVEL_CODEC_SYMBOLS; s++) {
+        counts[s] = (uint64_t)(DEFAULT_CELL_COUNTS[s >> 6] + 1) * (DEFAULT_CELL_COUNTS[(s >> 3) & 7] + 1)
+            * (DEFAULT_CELL_COUNTS[s & 7] + 1);
+    }
+    uint8_t lengths[LEVEL_CODEC_SYMBOLS];
+    BuildCodeLengths(counts, lengths);
+    LevelCode code;
+    BuildLevelCode(lengths, code);
+    return code;
+}
+
+const LevelCode& DefaultLevelCode() {
+    static const LevelCode code = MakeDefaultCode();
+    return code;
+}
+
+//-----------------------------------------------------------------------------
+// Encoding Functions
+//-----------------------------------------------------------------------------
+
+static void PutVarint(std::vector<unsigned char>& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back((unsigned char)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((unsigned char)value);
+}
+
+static bool GetVarint(const unsigned char* data, size_t size, size_t& pos, uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 32; shift += 7) {
+        if (pos >= size)
+            return false;
+        unsigned char byte = data[pos++];
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+// Call visit(symbol) for every group of one block's cells [begin, end),
+// the last one padded with MINIDOT, the cheapest cell to code.
+template <typename Visit>
+static void ForEachGroup(const uint8_t* cells, size_t begin, size_t end, Visit visit) {
+    size_t i = begin;
+    for (; i + LEVEL_CODEC_GROUP <= end; i += LEVEL_CODEC_GROUP)
+        visit(cells[i] << 6 | cells[i + 1] << 3 | cells[i + 2]);
+    if (i < end)
+        visit(cells[i] << 6 | (i + 1 < end ? cells[i + 1] : (int)MINIDOT) << 3 | MINIDOT);
+}
+
+bool EncodeLevelCells(const uint8_t* cells, int rows, int cols, std::vector<unsigned char>& out) {
+    out.clear();
+    if (rows <= 0 || cols <= 0)
+        return false;
+    size_t total = (size_t)rows * cols;
+    size_t blockCells = (size_t)LEVEL_CODEC_BLOCK_ROWS * cols;
+    uint8_t outOfRange = 0;
+    for (size_t i = 0; i < total; i++)
+        outOfRange |= cells[i];
+    if (outOfRange >= LEVEL_CODEC_VALUES)
+        return false;
+
+    // A large level takes its own code if that pays for the table.
+    const LevelCode& standard = DefaultLevelCode();
+    LevelCode own;
+    bool useOwn = false;
+    if (total >= LEVEL_CODEC_OWN_CODE_CELLS) {
+        uint64_t counts[LEVEL_CODEC_SYMBOLS] = {};
+        for (size_t begin = 0; begin < total; begin += blockCells)
+            ForEachGroup(cells, begin, (std::min)(total, begin + blockCells), [&](int symbol) { counts[symbol]++; });
+        uint8_t ownLengths[LEVEL_CODEC_SYMBOLS];
+        BuildCodeLengths(counts, ownLengths);
+        uint64_t standardBits = 0, ownBits = CODE_TABLE_BYTES * 8;
+        for (int s = 0; s < LEVEL_CODEC_SYMBOLS; s++) {
+            standardBits += counts[s] * standard.lengths[s];
+            ownBits += counts[s] * ownLengths[s];
+        }
+        useOwn = ownBits < standardBits && BuildLevelCode(ownLengths, own);
+    }
+    const LevelCode& code = useOwn ? own : standard;
+
+    PutVarint(out, (uint32_t)rows << 1 | (useOwn ? FLAG_OWN_CODE : 0));
+    PutVarint(out, cols);
+    if (useOwn) {
+        for (int s = 0; s < LEVEL_CODEC_SYMBOLS; s += 2)
+            out.push_back((unsigned char)(own.lengths[s] | own.lengths[s + 1] << 4));
+    }
+    // Blocks go to their own buffer first; the header needs their sizes.
+    // No group takes more than LEVEL_CODEC_MAX_BITS bits.
+    std::vector<unsigned char> body((total / LEVEL_CODEC_GROUP + 1) * LEVEL_CODEC_MAX_BITS / 8 + 8
+        * ((total + blockCells - 1) / blockCells) + 8);
+    size_t used = 0;
+    for (size_t begin = 0; begin < total; begin += blockCells) {
+        size_t start = used;
+        uint64_t bits = 0;
+        int count = 0;
+        ForEachGroup(cells, begin, (std::min)(total, begin + blockCells), [&](int symbol) {
+            bits |= (uint64_t)code.codes[symbol] << count;
+            count += code.lengths[symbol];
+            if (count >= 32) {
+                memcpy(&body[used], &bits, 4);
+                used += 4;
+                bits >>= 32;
+                count -= 32;
+            }
+        });
+        for (; count > 0; count -= 8, bits >>= 8)
+            body[used++] = (unsigned char)bits;
+        if (begin + blockCells < total)
+            PutVarint(out, (uint32_t)(used - start));
+    }
+    out.insert(out.end(), body.begin(), body.begin() + used);
+    return true;
+}
+
+bool EncodeLevel(const std::vector<std::vector<int>>& grid, std::vector<unsigned char>& out) {
+    out.clear();
+    if (grid.empty() || grid[0].empty())
+        return false;
+    int rows = grid.size(), cols = grid[0].size();
+    std::vector<uint8_t> cells((size_t)rows * cols);
+    for (int r = 0; r < rows; r++) {
+        if ((int)grid[r].size() != cols)
+            return false;
+        for (int c = 0; c < cols; c++) {
+            int value = grid[r][c];
+            if (value < 0 || value >= LEVEL_CODEC_VALUES)
+                return false;
+            cells[(size_t)r * cols + c] = (uint8_t)value;
+        }
+    }
+    return EncodeLevelCells(cells.data(), rows, cols, out);
+}
+
+//-----------------------------------------------------------------------------
+// EncodedLevelView
+//-----------------------------------------------------------------------------
+
+bool EncodedLevelView::Open(const unsigned char* bytes, size_t size) {
+    data = nullptr;
+    rows = cols = 0;
+    hasOwnCode = false;
+    blockStart.clear();
+    size_t pos = 0;
+    uint32_t rowsAndFlag, colCount;
+    if (!GetVarint(bytes, size, pos, rowsAndFlag) || !GetVarint(bytes, size, pos, colCount))
+        return false;
+    uint32_t rowCount = rowsAndFlag >> 1;
+    if (rowCount == 0 || colCount == 0 || rowCount > 0xFFFF || colCount > 0xFFFF)
+        return false;
+    if (rowsAndFlag & FLAG_OWN_CODE) {
+        if (size - pos < CODE_TABLE_BYTES)
+            return false;
+        uint8_t lengths[LEVEL_CODEC_SYMBOLS];
+        for (int i = 0; i < CODE_TABLE_BYTES; i++) {
+            lengths[2 * i] = bytes[pos + i] & 0xF;
+            lengths[2 * i + 1] = bytes[pos + i] >> 4;
+        }
+        pos += CODE_TABLE_BYTES;
+        if (!BuildLevelCode(lengths, ownCode))
+            return false;
+        hasOwnCode = true;
+    }
+    // Block sizes first, relative to the end of the header.
+    int blocks = (rowCount + LEVEL_CODEC_BLOCK_ROWS - 1) / LEVEL_CODEC_BLOCK_ROWS;
+    blockStart.assign(blocks + 1, 0);
+    for (int b = 0; b + 1 < blocks; b++) {
+        uint32_t length;
+        if (!GetVarint(bytes, size, pos, length))
+            return false;
+        blockStart[b + 1] = blockStart[b] + length;
+    }
+    for (int b = 0; b < blocks; b++)
+        blockStart[b] += pos;
+    if (blockStart[blocks - 1] > size)
+        return false;
+    blockStart[blocks] = size;
+    // Every group takes at least one bit, so a block too short for its cells
+    // is corrupt. Checked here so a forged header cannot make DecodeLevel()
+    // allocate cells the data could never hold.
+    for (int b = 0; b < blocks; b++) {
+        uint64_t blockRows = (std::min)((uint32_t)LEVEL_CODEC_BLOCK_ROWS, rowCount - b * LEVEL_CODEC_BLOCK_ROWS);
+        uint64_t groups = (blockRows * colCount + LEVEL_CODEC_GROUP - 1) / LEVEL_CODEC_GROUP;
+        if (groups > (uint64_t)(blockStart[b + 1] - blockStart[b]) * 8)
+            return false;
+    }
+    data = bytes;
+    rows = rowCount;
+    cols = colCount;
+    return true;
+}
+
+// Top the bit buffer up to at least 56 bits.
+static inline void RefillBits(const unsigned char* bytes, size_t size, size_t& pos, uint64_t& bits, int& count) {
+    if (pos + 8 <= size) {
+        // Load a whole word; the bytes past the 56 bits counted are loaded
+        // again, unchanged, by the next refill.
+        uint64_t word;
+        memcpy(&word, bytes + pos, sizeof(word));
+        bits |= word << count;
+        pos += (63 - count) >> 3;
+        count |= 56;
+    }
+    else {
+        // Near the end; bytes past the block read as zeros.
+        for (; count <= 56; count += 8, pos++)
+            bits |= (uint64_t)(pos < size ? bytes[pos] : 0) << count;
+    }
+}
+
+bool EncodedLevelView::DecodeBlock(int block, uint8_t* cells) const {
+    const unsigned char* bytes = data + blockStart[block];
+    size_t size = blockStart[block + 1] - blockStart[block];
+    size_t need = (size_t)BlockRows(block) * cols;
+    const uint16_t* decode = Code().decode;
+    const uint64_t mask = (1u << LEVEL_CODEC_MAX_BITS) - 1;
+    uint64_t bits = 0;
+    int count = 0;
+    size_t pos = 0, done = 0;
+    // A missing code has length 0; decoding carries on over it and the
+    // block is rejected at the end, which keeps the loop free of branches.
+    int missing = 0;
+    auto next = [&]() {
+        uint16_t entry = decode[bits & mask];
+        int length = entry & 0xF;
+        missing |= length == 0;
+        bits >>= length;
+        count -= length;
+        return entry;
+    };
+    // Four groups per refill: 56 bits cover four of the longest codes.
+    const size_t quad = 4 * LEVEL_CODEC_GROUP;
+    for (; done + quad <= need; done += quad) {
+        RefillBits(bytes, size, pos, bits, count);
+        for (int g = 0; g < 4; g++) {
+            uint16_t entry = next();
+            uint8_t* out = cells + done + g * LEVEL_CODEC_GROUP;
+            out[0] = (entry >> 4) & 7;
+            out[1] = (entry >> 7) & 7;
+            out[2] = (entry >> 10) & 7;
+        }
+    }
+    for (; done < need; done += LEVEL_CODEC_GROUP) {
+        RefillBits(bytes, size, pos, bits, count);
+        uint16_t entry = next();
+        for (size_t k = 0; k < LEVEL_CODEC_GROUP && done + k < need; k++)
+            cells[done + k] = (entry >> (4 + 3 * k)) & 7;
+    }
+    // The codes must have come from the block, not the zeros after it.
+    return !missing && pos * 8 - count <= size * 8;
+}
+
+bool EncodedLevelView::DecodeAll(uint8_t* cells) const {
+    for (int b = 0; b < BlockCount(); b++) {
+        if (!DecodeBlock(b, cells + (size_t)b * LEVEL_CODEC_BLOCK_ROWS * cols))
+            return false;
+    }
+    return true;
+}
+
+bool DecodeLevel(const unsigned char* data, size_t size, std::vector<std::vector<int>>& grid) {
+    EncodedLevelView view;
+    if (!view.Open(data, size))
+        return false;
+    std::vector<uint8_t> cells((size_t)view.Rows() * view.Cols());
+    if (!view.DecodeAll(cells.data()))
+        return false;
+    grid.assign(view.Rows(), std::vector<int>(view.Cols()));
+    for (int r = 0; r < view.Rows(); r++)
+        for (int c = 0; c < view.Cols(); c++)
+            grid[r][c] = cells[(size_t)r * view.Cols() + c];
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Share Code Functions
+//-----------------------------------------------------------------------------
+
+static const char SHARE_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+std::string LevelToShareCode(const std::vector<std::vector<int>>& grid) {
+    std::vector<unsigned char> bytes;
+    if (!EncodeLevel(grid, bytes))
+        return std::string();
+    std::string text;
+    uint32_t bits = 0;
+    int count = 0;
+    for (unsigned char byte : bytes) {
+        bits = bits << 8 | byte;
+        count += 8;
+        while (count >= 6) {
+            count -= 6;
+            text += SHARE_ALPHABET[(bits >> count) & 0x3F];
+        }
+    }
+    if (count > 0)
+        text += SHARE_ALPHABET[(bits << (6 - count)) & 0x3F];
+    return text;
+}
+
+bool LevelFromShareCode(const std::string& text, std::vector<std::vector<int>>& grid, int rows, int cols) {
+    std::vector<unsigned char> bytes;
+    uint32_t bits = 0;
+    int count = 0;
+    for (char ch : text) {
+        const char* found = ch ? strchr(SHARE_ALPHABET, ch) : nullptr;
+        if (!found)
+            return false;
+        bits = bits << 6 | (uint32_t)(found - SHARE_ALPHABET);
+        count += 6;
+        if (count >= 8) {
+            count -= 8;
+            bytes.push_back((unsigned char)(bits >> count));
+        }
+    }
+    EncodedLevelView view;
+    if (bytes.empty() || !view.Open(bytes.data(), bytes.size()))
+        return false;
+    if ((rows && view.Rows() != rows) || (cols && view.Cols() != cols))
+        return false;
+    return DecodeLevel(bytes.data(), bytes.size(), grid);
+}
@@ -0,0 +1,107 @@
+// LevelCodec.h : compact level encoding for level packs and sharing
+//
+// Cells are coded three at a time in reading order, each group of three one
+// symbol of a canonical prefix code. Generated levels are close to
+// independent cells drawn from the decoration mix, so a built-in code
+// derived from the measured cell frequencies takes them to within a few
+// percent of their order-0 entropy with no table stored; a level of at least
+// LEVEL_CODEC_OWN_CODE_CELLS cells carries its own code when that comes out
+// smaller. A generated 10x10 level takes about 23 bytes.
+//
+// Rows are coded in blocks of LEVEL_CODEC_BLOCK_ROWS. Every block starts on
+// a byte and the header lists their sizes, so any row block can be decoded
+// without touching the others. A block whose cell count is not a multiple of
+// three pads its last group with MINIDOT cells.
+//
+// Layout:
+//   rows * 2 + own code, cols   varints; own code is 1 if the level carries its code
+//   code lengths                256 bytes, 4 bits per symbol, only with bit 0
+//   block sizes                 varint byte count of every block but the last
+//   blocks                      LSB-first bit streams
+//
+// Cell values must be 0 to 7; every CellType fits.
+
+#pragma once
+
+#include "MazeGame.h"
+#include <algorithm>
+#include <cstddef>
+#include <string>
+
+#define LEVEL_CODEC_BLOCK_ROWS 16
+#define LEVEL_CODEC_VALUES 8                // cell values 0 .. 7
+#define LEVEL_CODEC_GROUP 3                 // cells per symbol
+#define LEVEL_CODEC_SYMBOLS 512             // LEVEL_CODEC_VALUES ^ LEVEL_CODEC_GROUP
+#define LEVEL_CODEC_MAX_BITS 12             // longest code, and the decode table's index width
+#define LEVEL_CODEC_OWN_CODE_CELLS 65536    // smaller levels always use the built-in code
+
+// A canonical prefix code over the symbols (first cell * 64 + second * 8 +
+// third) with its decode table.
+struct LevelCode {
+    uint8_t lengths[LEVEL_CODEC_SYMBOLS];   // 0 for symbols without a code
+    uint16_t codes[LEVEL_CODEC_SYMBOLS];    // bit-reversed, for LSB-first streams
+    // Indexed by the next LEVEL_CODEC_MAX_BITS bits of the stream: code
+    // length in bits 0-3 (0 = no such code), then the three cells, 3 bits
+    // each, first cell lowest.
+    uint16_t decode[1 << LEVEL_CODEC_MAX_BITS];
+};
+
+// Build a code from code lengths; returns false if they do not form a
+// prefix code.
+bool BuildLevelCode(const uint8_t* lengths, LevelCode& code);
+
+// The built-in code for generated levels; it has a code for every symbol.
+const LevelCode& DefaultLevelCode();
+
+// Encode rows * cols row-major cells. Returns false if a value is out of
+// range or the level is empty.
+bool EncodeLevelCells(const uint8_t* cells, int rows, int cols, std::vector<unsigned char>& out);
+
+// The same for a level as the game stores it.
+bool EncodeLevel(const std::vector<std::vector<int>>& grid, std::vector<unsigned char>& out);
+
+// Decode a whole level; returns false if the data is malformed.
+bool DecodeLevel(const unsigned char* data, size_t size, std::vector<std::vector<int>>& grid);
+
+// Validated view over one encoded level for decoding row blocks on their
+// own. The data is referenced, not copied, and must outlive the view.
+class EncodedLevelView {
+public:
+    // Returns false if the header or block index is malformed, or a block is
+    // too short to hold its cells.
+    bool Open(const unsigned char* data, size_t size);
+
+    int Rows() const { return rows; }
+    int Cols() const { return cols; }
+    int BlockCount() const { return (int)blockStart.size() - 1; }
+
+    // Rows block covers: LEVEL_CODEC_BLOCK_ROWS, fewer for the last block.
+    int BlockRows(int block) const {
+        return (std::min)(LEVEL_CODEC_BLOCK_ROWS, rows - block * LEVEL_CODEC_BLOCK_ROWS);
+    }
+
+    // Decode row block `block` into cells (BlockRows(block) * Cols() bytes,
+    // row-major). Returns false if its bits are malformed.
+    bool DecodeBlock(int block, uint8_t* cells) const;
+
+    // Decode every block into rows * cols bytes.
+    bool DecodeAll(uint8_t* cells) const;
+
+private:
+    const LevelCode& Code() const { return hasOwnCode ? ownCode : DefaultLevelCode(); }
+
+    const unsigned char* data = nullptr;
+    int rows = 0;
+    int cols = 0;
+    bool hasOwnCode = false;
+    LevelCode ownCode;
+    std::vector<size_t> blockStart;     // byte offset of each block, then the end
+};
+
+// A level as a short URL-safe text (base64url of the encoding, unpadded),
+// for sharing; empty if the level cannot be encoded.
+std::string LevelToShareCode(const std::vector<std::vector<int>>& grid);
+
+// Parse a share code; returns false if it is not a valid level. With rows
+// and cols given, a code for any other size is rejected before decoding.
+bool LevelFromShareCode(const std::string& text, std::vector<std::vector<int>>& grid, int rows = 0, int cols = 0);
@@ -0,0 +1,375 @@
+#include "LevelPack.h"
+#include "BoundedQueue.h"
+#include "MazeGenerator.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+typedef std::chrono::steady_clock PipelineClock;
+
+// Seconds since mark; moves mark to now.
+static double Lap(PipelineClock::time_point& mark) {
+    PipelineClock::time_point now = PipelineClock::now();
+    double seconds = std::chrono::duration<double>(now - mark).count();
+    mark = now;
+    return seconds;
+}
+
+// Cells on the shortest route from the start to the exit that avoids walls,
+// obstacles and hazards, or 0 if there is none.
+static int SolutionLength(const std::vector<std::vector<int>>& grid, std::vector<int>& steps,
+                          std::vector<int>& queue) {
+    int rows = grid.size(), cols = grid[0].size();
+    steps.assign(rows * cols, 0);
+    queue.resize(rows * cols);
+    int exit = rows * cols - 1;
+    int head = 0, tail = 0;
+    steps[0] = 1;
+    queue[tail++] = 0;
+    while (head < tail && !steps[exit]) {
+        int cell = queue[head++];
+        int r = cell / cols, c = cell % cols;
+        for (int dir = 0; dir < 4; dir++) {
+            int dx, dy;
+            MoveDirectionStep(dir, dx, dy);
+            int nr = r + dy, nc = c + dx;
+            if (nr < 0 || nr >= rows || nc < 0 || nc >= cols)
+                continue;
+            int next = nr * cols + nc, value = grid[nr][nc];
+            if (steps[next] || value == WALL || value == OBSTACLE || value == HAZARD)
+                continue;
+            steps[next] = steps[cell] + 1;
+            queue[tail++] = next;
+        }
+    }
+    return steps[exit];
+}
+
+//-----------------------------------------------------------------------------
+// Pipeline Functions
+//-----------------------------------------------------------------------------
+
+// Generation to validation.
+struct GeneratedLevel {
+    uint32_t index = 0;     // level number, also the seed offset
+    std::vector<std::vector<int>> grid;
+};
+
+// Validation to the writer.
+struct ValidatedLevel {
+    uint32_t index = 0;
+    bool valid = false;
+    LevelPackEntry entry = {};
+    std::vector<unsigned char> bytes;
+};
+
+static void AddStageStats(PipelineStageStats& total, const PipelineStageStats& part) {
+    total.threads += part.threads;
+    total.busySeconds += part.busySeconds;
+    total.starvedSeconds += part.starvedSeconds;
+    total.blockedSeconds += part.blockedSeconds;
+}
+
+// Chunk assembly and the file, on the writer thread.
+class LevelPackWriter {
+public:
+    LevelPackWriter(std::ofstream& out, const LevelPackOptions& options, LevelPackStats& stats)
+        : out(out), options(options), stats(stats) {
+        LevelPackHeader placeholder = {};
+        Write(&placeholder, sizeof(placeholder));
+    }
+
+    void Add(const ValidatedLevel& level) {
+        LevelPackEntry entry = level.entry;
+        entry.offset = (uint32_t)data.size();
+        entries.push_back(entry);
+        data.insert(data.end(), level.bytes.begin(), level.bytes.end());
+        stats.encodedBytes += level.bytes.size();
+        if (entries.size() == options.chunkLevels)
+            FlushChunk();
+    }
+
+    // Write the last chunk, the directory and the real header.
+    void Finish() {
+        FlushChunk();
+        LevelPackHeader header = {};
+        header.magic = LEVEL_PACK_MAGIC;
+        header.version = LEVEL_PACK_VERSION;
+        header.rows = options.rows;
+        header.cols = options.cols;
+        header.firstSeed = options.firstSeed;
+        header.chunkLevels = options.chunkLevels;
+        header.levelCount = (uint32_t)stats.levels;
+        header.chunkCount = (uint32_t)chunkOffsets.size();
+        header.directoryOffset = stats.fileBytes;
+        Write(chunkOffsets.data(), chunkOffsets.size() * sizeof(uint64_t));
+        out.seekp(0);
+        out.write((const char*)&header, sizeof(header));
+        out.flush();
+    }
+
+private:
+    void FlushChunk() {
+        if (entries.empty())
+            return;
+        LevelPackChunkHeader header = {};
+        header.magic = LEVEL_PACK_CHUNK_MAGIC;
+        header.firstLevel = (uint32_t)stats.levels;
+        header.levelCount = (uint32_t)entries.size();
+        header.dataBytes = (uint32_t)data.size();
+        size_t entryBytes = entries.size() * sizeof(LevelPackEntry);
+        chunk.resize(sizeof(header) + entryBytes + data.size());
+        memcpy(&chunk[sizeof(header)], entries.data(), entryBytes);
+        memcpy(&chunk[sizeof(header) + entryBytes], data.data(), data.size());
+        header.checksum = SaveChecksum(&chunk[sizeof(header)], chunk.size() - sizeof(header));
+        memcpy(chunk.data(), &header, sizeof(header));
+        chunkOffsets.push_back(stats.fileBytes);
+        Write(chunk.data(), chunk.size());
+        stats.levels += entries.size();
+        stats.chunks++;
+        entries.clear();
+        data.clear();
+    }
+
+    void Write(const void* bytes, size_t size) {
+        out.write((const char*)bytes, size);
+        stats.fileBytes += size;
+    }
+
+    std::ofstream& out;
+    const LevelPackOptions& options;
+    LevelPackStats& stats;
+    std::vector<LevelPackEntry> entries;    // of the chunk being filled
+    std::vector<unsigned char> data;
+    std::vector<unsigned char> chunk;       // the assembled chunk, reused
+    std::vector<uint64_t> chunkOffsets;
+};
+
+bool GenerateLevelPack(const LevelPackOptions& options, LevelPackStats& stats) {
+    stats = LevelPackStats();
+    if (options.rows < 2 || options.cols < 2 || options.chunkLevels == 0)
+        return false;
+    std::ofstream out(options.path, std::ios::binary | std::ios::trunc);
+    if (!out)
+        return false;
+    int generators = options.threads > 0 ? options.threads
+        : (int)(std::max)(1u, std::thread::hardware_concurrency());
+    int validators = options.validateThreads > 0 ? options.validateThreads : (std::max)(1, generators / 4);
+
+    BoundedQueue<GeneratedLevel> generated(options.queueCapacity);
+    BoundedQueue<ValidatedLevel> validated(options.queueCapacity);
+
+    // Level numbers are handed out only while fewer than `window` levels
+    // are between generation and the file. That bounds the writer's reorder
+    // buffer too: the level it waits for is always inside the window.
+    size_t window = 2 * options.queueCapacity + generators + validators;
+    std::mutex ticketLock;
+    std::condition_variable ticketFreed;
+    uint32_t nextTicket = 0, retired = 0;    // guarded by ticketLock
+    stats.window = window;
+
+    std::mutex mergeLock;
+    std::atomic<int> generatorsLeft(generators), validatorsLeft(validators);
+
+    auto generate = [&]() {
+        PipelineStageStats local;
+        local.threads = 1;
+        PipelineClock::time_point mark = PipelineClock::now();
+        for (;;) {
+            uint32_t index;
+            {
+                std::unique_lock<std::mutex> guard(ticketLock);
+                ticketFreed.wait(guard, [&] { return nextTicket >= options.levels || nextTicket - retired < window; });
+                if (nextTicket >= options.levels)
+                    break;
+                index = nextTicket++;
+                stats.peakInFlight = (std::max)(stats.peakInFlight, (size_t)(nextTicket - retired));
+            }
+            local.blockedSeconds += Lap(mark);
+            GeneratedLevel level;
+            level.index = index;
+            MazeRng rng(options.firstSeed + index);
+            level.grid = GenerateRandomMazeLevel(rng, options.rows, options.cols);
+            local.busySeconds += Lap(mark);
+            bool pushed = generated.Push(std::move(level));
+            local.blockedSeconds += Lap(mark);
+            if (!pushed)
+                break;
+        }
+        local.blockedSeconds += Lap(mark);
+        if (--generatorsLeft == 0)
+            generated.Close();
+        std::lock_guard<std::mutex> guard(mergeLock);
+        AddStageStats(stats.stages[STAGE_GENERATE], local);
+    };
+
+    auto validate = [&]() {
+        PipelineStageStats local;
+        local.threads = 1;
+        uint64_t cellCounts[LEVEL_CODEC_VALUES] = {};
+        uint64_t solutionCells = 0;
+        std::vector<int> steps, queue;
+        PipelineClock::time_point mark = PipelineClock::now();
+        GeneratedLevel level;
+        for (;;) {
+            bool popped = generated.Pop(level);
+            local.starvedSeconds += Lap(mark);
+            if (!popped)
+                break;
+            ValidatedLevel result;
+            result.index = level.index;
+            result.entry.seed = options.firstSeed + level.index;
+            int solution = SolutionLength(level.grid, steps, queue);
+            result.valid = solution > 0 && EncodeLevel(level.grid, result.bytes);
+            if (result.valid) {
+                int collectibles = 0, hazards = 0;
+                for (const auto& row : level.grid) {
+                    for (int value : row) {
+                        cellCounts[value]++;
+                        collectibles += value == COLLECTIBLE;
+                        hazards += value == HAZARD;
+                    }
+                }
+                solutionCells += solution;
+                result.entry.solutionLength = (uint16_t)(std::min)(solution, 0xFFFF);
+                result.entry.collectibles = (uint8_t)(std::min)(collectibles, 0xFF);
+                result.entry.hazards = (uint8_t)(std::min)(hazards, 0xFF);
+            }
+            local.busySeconds += Lap(mark);
+            bool pushed = validated.Push(std::move(result));
+            local.blockedSeconds += Lap(mark);
+            if (!pushed)
+                break;
+        }
+        if (--validatorsLeft == 0)
+            validated.Close();
+        std::lock_guard<std::mutex> guard(mergeLock);
+        AddStageStats(stats.stages[STAGE_VALIDATE], local);
+        for (int v = 0; v < LEVEL_CODEC_VALUES; v++)
+            stats.cellCounts[v] += cellCounts[v];
+        stats.solutionCells += solutionCells;
+    };
+
+    PipelineClock::time_point start = PipelineClock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < generators; t++)
+        threads.emplace_back(generate);
+    for (int t = 0; t < validators; t++)
+        threads.emplace_back(validate);
+
+    // This thread is the writer.
+    LevelPackWriter writer(out, options, stats);
+    PipelineStageStats& writeStage = stats.stages[STAGE_WRITE];
+    writeStage.threads = 1;
+    std::map<uint32_t, ValidatedLevel> waiting;     // arrived ahead of their turn
+    uint32_t nextIndex = 0;
+    PipelineClock::time_point mark = PipelineClock::now();
+    ValidatedLevel level;
+    while (validated.Pop(level)) {
+        writeStage.starvedSeconds += Lap(mark);
+        uint32_t index = level.index;
+        waiting.emplace(index, std::move(level));
+        uint32_t before = nextIndex;
+        for (auto next = waiting.begin(); next != waiting.end() && next->first == nextIndex;
+             next = waiting.erase(next), nextIndex++) {
+            if (next->second.valid)
+                writer.Add(next->second);
+            else
+                stats.rejected++;
+        }
+        if (nextIndex != before) {
+            {
+                std::lock_guard<std::mutex> guard(ticketLock);
+                retired = nextIndex;
+            }
+            ticketFreed.notify_all();
+        }
+        writeStage.busySeconds += Lap(mark);
+    }
+    writeStage.starvedSeconds += Lap(mark);
+    for (auto& thread : threads)
+        thread.join();
+    writer.Finish();
+    writeStage.busySeconds += Lap(mark);
+    stats.seconds = std::chrono::duration<double>(PipelineClock::now() - start).count();
+    return (bool)out;
+}
+
+//-----------------------------------------------------------------------------
+// LevelPackView
+//-----------------------------------------------------------------------------
+
+bool LevelPackView::Open(const std::string& path) {
+    header = nullptr;
+    directory = nullptr;
+    if (!file.Open(path))
+        return false;
+    const unsigned char* base = file.Data();
+    size_t size = file.Size();
+    if (size < sizeof(LevelPackHeader))
+        return false;
+    const LevelPackHeader* h = (const LevelPackHeader*)base;
+    if (h->magic != LEVEL_PACK_MAGIC || h->version != LEVEL_PACK_VERSION || h->chunkLevels == 0)
+        return false;
+    uint64_t directoryEnd = h->directoryOffset + (uint64_t)h->chunkCount * sizeof(uint64_t);
+    if (h->directoryOffset < sizeof(LevelPackHeader) || directoryEnd > size)
+        return false;
+    const uint64_t* chunks = (const uint64_t*)(base + h->directoryOffset);
+    uint64_t levels = 0;
+    for (uint32_t c = 0; c < h->chunkCount; c++) {
+        if (chunks[c] < sizeof(LevelPackHeader) || chunks[c] + sizeof(LevelPackChunkHeader) > size)
+            return false;
+        const LevelPackChunkHeader* chunk = (const LevelPackChunkHeader*)(base + chunks[c]);
+        uint64_t end = chunks[c] + sizeof(LevelPackChunkHeader)
+            + (uint64_t)chunk->levelCount * sizeof(LevelPackEntry) + chunk->dataBytes;
+        if (chunk->magic != LEVEL_PACK_CHUNK_MAGIC || chunk->firstLevel != levels || end > size
+            || chunk->levelCount == 0 || chunk->levelCount > h->chunkLevels
+            || (c + 1 < h->chunkCount && chunk->levelCount != h->chunkLevels))
+            return false;
+        levels += chunk->levelCount;
+    }
+    if (levels != h->levelCount)
+        return false;
+    header = h;
+    directory = chunks;
+    return true;
+}
+
+const LevelPackChunkHeader& LevelPackView::Chunk(uint32_t chunk) const {
+    return *(const LevelPackChunkHeader*)(file.Data() + directory[chunk]);
+}
+
+const LevelPackEntry& LevelPackView::Entry(uint32_t level) const {
+    const LevelPackEntry* entries = (const LevelPackEntry*)(&Chunk(level / header->chunkLevels) + 1);
+    return entries[level % header->chunkLevels];
+}
+
+bool LevelPackView::VerifyChunk(uint32_t chunk) const {
+    const LevelPackChunkHeader& h = Chunk(chunk);
+    size_t bytes = h.levelCount * sizeof(LevelPackEntry) + h.dataBytes;
+    return SaveChecksum((const unsigned char*)(&h + 1), bytes) == h.checksum;
+}
+
+const unsigned char* LevelPackView::LevelData(uint32_t level, size_t& size) const {
+    const LevelPackChunkHeader& chunk = Chunk(level / header->chunkLevels);
+    const LevelPackEntry* entries = (const LevelPackEntry*)(&chunk + 1);
+    const unsigned char* data = (const unsigned char*)(entries + chunk.levelCount);
+    uint32_t i = level % header->chunkLevels;
+    uint32_t begin = entries[i].offset;
+    uint32_t end = i + 1 < chunk.levelCount ? entries[i + 1].offset : chunk.dataBytes;
+    if (begin > end || end > chunk.dataBytes)
+        return nullptr;
+    size = end - begin;
+    return data + begin;
+}
+
+bool LevelPackView::LevelGrid(uint32_t level, std::vector<std::vector<int>>& grid) const {
+    size_t size = 0;
+    const unsigned char* data = level < header->levelCount ? LevelData(level, size) : nullptr;
+    return data && DecodeLevel(data, size, grid);
+}
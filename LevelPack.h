@@ -0,0 +1,145 @@
+// LevelPack.h : chunked level archives and the pipeline that generates them
+//
+// A level pack holds many generated levels, each encoded with LevelCodec.h,
+// for QA runs and seeded daily challenges. Levels are grouped into chunks;
+// every chunk has its own index and checksum, and a directory at the end
+// of the file points at every chunk, so one level is found without reading
+// the rest.
+//
+// Layout (little-endian):
+//   LevelPackHeader                 counts and directory offset, written last
+//   chunks, each:
+//     LevelPackChunkHeader
+//     LevelPackEntry[levelCount]    seed, data offset and stats per level
+//     encoded levels
+//   uint64_t[chunkCount]            chunk directory: file offset of each chunk
+//
+// GenerateLevelPack() fills a pack with a three-stage pipeline: generation
+// workers, validation workers (path check, statistics, encoding) and one
+// writer. Bounded queues between the stages make a stage that runs ahead
+// wait for the next one, and the generators only take a level number while
+// fewer than a fixed window of levels are in flight, so memory stays the
+// same however many levels are generated. The writer puts levels back into
+// seed order, so the file does not depend on the thread counts.
+
+#pragma once
+
+#include "SaveFile.h"
+#include "LevelCodec.h"
+#include <cstddef>
+#include <string>
+
+#define LEVEL_PACK_MAGIC 0x504C5A4Du         // "MZLP"
+#define LEVEL_PACK_CHUNK_MAGIC 0x434C5A4Du   // "MZLC"
+#define LEVEL_PACK_VERSION 1
+
+#pragma pack(push, 1)
+struct LevelPackHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t firstSeed;
+    uint32_t chunkLevels;       // levels per chunk, fewer in the last one
+    uint32_t levelCount;
+    uint32_t chunkCount;
+    uint64_t directoryOffset;
+};
+
+struct LevelPackChunkHeader {
+    uint32_t magic;
+    uint32_t firstLevel;        // pack index of the chunk's first level
+    uint32_t levelCount;
+    uint32_t dataBytes;         // encoded levels after the entries
+    uint32_t checksum;          // SaveChecksum() of the entries and the data
+};
+
+// Stats saturate at the field's maximum.
+struct LevelPackEntry {
+    uint32_t seed;              // MazeRng seed the level was generated from
+    uint32_t offset;            // into the chunk's encoded levels
+    uint16_t solutionLength;    // cells on the shortest start-to-exit path
+    uint8_t collectibles;
+    uint8_t hazards;
+};
+#pragma pack(pop)
+
+struct LevelPackOptions {
+    std::string path;
+    uint32_t levels = 100000;
+    uint32_t firstSeed = 1;         // level i is generated from seed firstSeed + i
+    int rows = GRID_ROWS;
+    int cols = GRID_COLS;
+    int threads = 0;                // generation workers, 0 = one per hardware core
+    int validateThreads = 0;        // 0 = one per four generation workers
+    uint32_t chunkLevels = 4096;
+    size_t queueCapacity = 256;     // levels per queue between two stages
+};
+
+// Time the threads of one stage spent working, waiting for input and
+// waiting for room in the next stage's queue, summed over the threads.
+struct PipelineStageStats {
+    int threads = 0;
+    double busySeconds = 0;
+    double starvedSeconds = 0;
+    double blockedSeconds = 0;
+
+    double Utilization(double wallSeconds) const {
+        return wallSeconds > 0 && threads > 0 ? busySeconds / (wallSeconds * threads) : 0;
+    }
+};
+
+enum PipelineStage {
+    STAGE_GENERATE,
+    STAGE_VALIDATE,
+    STAGE_WRITE,
+    STAGE_COUNT
+};
+
+struct LevelPackStats {
+    uint64_t levels = 0;            // written to the pack
+    uint64_t rejected = 0;          // generated without a path to the exit
+    uint64_t chunks = 0;
+    uint64_t encodedBytes = 0;
+    uint64_t fileBytes = 0;
+    uint64_t solutionCells = 0;     // summed over the written levels
+    uint64_t cellCounts[LEVEL_CODEC_VALUES] = {};
+    size_t peakInFlight = 0;        // most levels between generation and the file at once
+    size_t window = 0;              // the limit on that
+    double seconds = 0;
+    PipelineStageStats stages[STAGE_COUNT];
+
+    double LevelsPerSecond() const { return seconds > 0 ? levels / seconds : 0; }
+};
+
+// Generate options.levels levels into a new pack at options.path. Returns
+// false if the file could not be written.
+bool GenerateLevelPack(const LevelPackOptions& options, LevelPackStats& stats);
+
+// Validated view over a mapped level pack. The header, directory and chunk
+// headers are checked on open; chunk checksums only by VerifyChunk().
+class LevelPackView {
+public:
+    bool Open(const std::string& path);
+
+    const LevelPackHeader& Header() const { return *header; }
+    uint32_t LevelCount() const { return header->levelCount; }
+    uint32_t ChunkCount() const { return header->chunkCount; }
+    const LevelPackChunkHeader& Chunk(uint32_t chunk) const;
+    const LevelPackEntry& Entry(uint32_t level) const;
+
+    // Check one chunk's checksum.
+    bool VerifyChunk(uint32_t chunk) const;
+
+    // Decode one level; returns false if its data is malformed.
+    bool LevelGrid(uint32_t level, std::vector<std::vector<int>>& grid) const;
+
+private:
+    // Encoded bytes of a level.
+    const unsigned char* LevelData(uint32_t level, size_t& size) const;
+
+    MappedFile file;
+    const LevelPackHeader* header = nullptr;
+    const uint64_t* directory = nullptr;
+};
@@ -0,0 +1,517 @@
+#include "LevelSearch.h"
+#include "Chokepoints.h"
+#include "Tracing.h"
+#include <algorithm>
+#include <bitset>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+//-----------------------------------------------------------------------------
+// Candidate Functions
+//-----------------------------------------------------------------------------
+
+// Roll values in a SearchField that are not DecorateMaze rolls.
+#define ROLL_BLOCKED 255    // wall: never walkable
+#define ROLL_OPEN    254    // path, start or exit: never decorated
+
+// Rolls are below 100, so 7 bit planes hold them. Undecorated cells are
+// stored as 127, above every mix's blocked band.
+#define ROLL_PLANES 7
+#define ROLL_PLANE_OPEN 127
+
+// Everything about the carved maze that does not change between candidates.
+// Cells are stored flat with a one-cell border, so neighbour checks need no
+// bounds tests. The reachability pass works on bitsets instead: each row is
+// words 64-bit words, bit c of a row is column c, and an empty row above and
+// below plays the border.
+struct SearchMaze {
+    int rows = 0, cols = 0, stride = 0;
+    int start = 0, end = 0;
+    int solutionLength = 0;
+    int words = 0;
+    std::vector<uint8_t> base;      // ROLL_BLOCKED or ROLL_OPEN per cell
+    std::vector<uint64_t> passable; // bitset rows: cells that are not walls
+    std::vector<uint64_t> ends;     // bitset rows: the start and exit cells
+    std::vector<int> decorated;     // cells DecorateMaze rolls for, in its order
+    std::vector<uint8_t> nearPath;  // 1 for decorated cells next to the path
+    int nearPathCount = 0;
+    std::vector<int> path;          // protected path cells, exit first
+    int ring[8] = {};               // offsets of the 8 cells around a cell, in turn
+    uint8_t ringBypass[256] = {};   // see RingBypasses()
+    bool routeCuts = false;         // LevelSearchOptions::routeCuts
+};
+
+// One seeded sequence of DecorateMaze rolls. Every candidate of a field uses
+// the same rolls with a different DecorationMix, so its counts come from the
+// roll histograms and only the reachability pass touches every bitset word.
+struct SearchField {
+    uint32_t seed = 0;
+    std::vector<uint64_t> planes;   // ROLL_PLANES per bitset word: bit b of each cell's roll
+    std::vector<uint8_t> ringRolls; // the rolls around each path cell, 8 per cell
+    int below[101] = {};            // decorated cells with roll < r
+    int nearBelow[101] = {};        // the same, next to the path only
+};
+
+struct SearchCandidate {
+    int field = 0;
+    DecorationMix mix;
+    DecorationScore score;
+    double lowerBound = 0;          // no full score can be closer to the target
+    int routeCutBound = 0;          // no more route cuts than this
+};
+
+// Per-thread buffers, kept so candidates do not allocate.
+struct SearchScratch {
+    std::vector<uint64_t> walkable; // bitset rows
+    std::vector<uint64_t> reached;
+    std::vector<uint64_t> fill;     // one row
+    std::vector<uint8_t> pending;   // rows whose neighbours grew since they were filled
+    std::vector<uint8_t> open;      // reached cells, laid out for AnalyzeChokepoints()
+    ChokepointMap map;
+};
+
+// Candidates draw their own mix, so the search covers easy and hard
+// decorations rather than many samples of the same chances.
+static DecorationMix DrawDecorationMix(MazeRng& rng) {
+    DecorationMix mix;
+    mix.collectible = rng.Below(11);
+    mix.hazard = rng.Below(26);
+    mix.obstacle = 10 + rng.Below(21);
+    return mix;
+}
+
+// Whether a cell's walkable orthogonal neighbours are joined by walkable cells
+// of the ring around it. Bit k of mask is ring cell k, starting above and
+// going clockwise, so the orthogonal neighbours are the even bits. If they
+// are joined, every route through the cell can go around it, so it is no
+// route cut. Consecutive ring cells are orthogonal neighbours of each other.
+static bool RingBypasses(int mask) {
+    int run[8], runs = 0;
+    for (int k = 0; k < 8; k++) {
+        bool open = (mask >> k) & 1;
+        run[k] = !open ? -1 : (k > 0 && run[k - 1] >= 0) ? run[k - 1] : runs++;
+    }
+    if ((mask & 0x81) == 0x81) {
+        for (int k = 7; k >= 0 && run[k] >= 0; k--)
+            run[k] = run[0];
+    }
+    int joined = -1;
+    for (int k = 0; k < 8; k += 2) {
+        if (run[k] < 0)
+            continue;
+        if (joined >= 0 && run[k] != joined)
+            return false;
+        joined = run[k];
+    }
+    return true;
+}
+
+static SearchMaze PrepareSearchMaze(const std::vector<std::vector<int>>& grid) {
+    SearchMaze maze;
+    maze.rows = grid.size();
+    maze.cols = grid[0].size();
+    maze.stride = maze.cols + 2;
+    maze.base.assign((maze.rows + 2) * maze.stride, ROLL_BLOCKED);
+    maze.nearPath.assign(maze.base.size(), 0);
+    maze.start = maze.stride + 1;
+    maze.end = maze.rows * maze.stride + maze.cols;
+    maze.words = (maze.cols + 63) / 64;
+    maze.passable.assign((maze.rows + 2) * maze.words, 0);
+    maze.ends.assign(maze.passable.size(), 0);
+    maze.ends[maze.words] |= 1;
+    maze.ends[maze.rows * maze.words + (maze.cols - 1) / 64] |= 1ull << ((maze.cols - 1) & 63);
+
+    std::vector<POINT> path = GetValidPath(grid);
+    maze.solutionLength = (int)path.size() - 1;
+    std::vector<uint8_t> onPath(maze.base.size(), 0);
+    for (auto p : path) {
+        int i = (p.y + 1) * maze.stride + p.x + 1;
+        onPath[i] = 1;
+        maze.path.push_back(i);
+    }
+    const int ring[8] = { -maze.stride, 1 - maze.stride, 1, 1 + maze.stride,
+        maze.stride, maze.stride - 1, -1, -1 - maze.stride };
+    for (int k = 0; k < 8; k++)
+        maze.ring[k] = ring[k];
+    for (int mask = 0; mask < 256; mask++)
+        maze.ringBypass[mask] = RingBypasses(mask);
+    const int offsets[4] = { -maze.stride, 1, maze.stride, -1 };
+    for (int r = 0; r < maze.rows; r++) {
+        for (int c = 0; c < maze.cols; c++) {
+            int i = (r + 1) * maze.stride + c + 1;
+            if (grid[r][c] != PASSAGE)
+                continue;
+            maze.base[i] = ROLL_OPEN;
+            maze.passable[(r + 1) * maze.words + c / 64] |= 1ull << (c & 63);
+            if (onPath[i] || i == maze.start || i == maze.end)
+                continue;
+            maze.decorated.push_back(i);
+            for (int d = 0; d < 4; d++) {
+                if (onPath[i + offsets[d]]) {
+                    maze.nearPath[i] = 1;
+                    maze.nearPathCount++;
+                    break;
+                }
+            }
+        }
+    }
+    return maze;
+}
+
+// Roll the field exactly as DecorateMaze would with this seed.
+static void RollSearchField(const SearchMaze& maze, SearchField& field) {
+    MazeRng rng(field.seed);
+    std::vector<uint8_t> rolls = maze.base;
+    int counts[100] = {}, nearCounts[100] = {};
+    for (int i : maze.decorated) {
+        int roll = rng.Below(100);
+        rolls[i] = (uint8_t)roll;
+        counts[roll]++;
+        nearCounts[roll] += maze.nearPath[i];
+    }
+    for (int r = 0; r < 100; r++) {
+        field.below[r + 1] = field.below[r] + counts[r];
+        field.nearBelow[r + 1] = field.nearBelow[r] + nearCounts[r];
+    }
+    // Eight cells go into the planes at a time: masking bit b of eight roll
+    // bytes, read little-endian, and multiplying gathers the eight bits into
+    // the top byte.
+    field.planes.assign(maze.passable.size() * ROLL_PLANES, 0);
+    uint8_t cells[64];
+    for (int r = 0; r < maze.rows; r++) {
+        for (int w = 0; w < maze.words; w++) {
+            const uint8_t* row = &rolls[(r + 1) * maze.stride + 1 + w * 64];
+            int count = (std::min)(64, maze.cols - w * 64);
+            for (int k = 0; k < 64; k++)
+                cells[k] = (uint8_t)(k < count && row[k] < 100 ? row[k] : ROLL_PLANE_OPEN);
+            uint64_t* planes = &field.planes[((r + 1) * maze.words + w) * ROLL_PLANES];
+            for (int k = 0; k < 64; k += 8) {
+                uint64_t eight;
+                memcpy(&eight, cells + k, 8);
+                for (int b = 0; b < ROLL_PLANES; b++)
+                    planes[b] |= ((((eight >> b) & 0x0101010101010101ull) * 0x0102040810204080ull) >> 56) << k;
+            }
+        }
+    }
+    if (!maze.routeCuts)
+        return;
+    field.ringRolls.resize(maze.path.size() * 8);
+    for (size_t position = 0; position < maze.path.size(); position++)
+        for (int k = 0; k < 8; k++)
+            field.ringRolls[position * 8 + k] = rolls[maze.path[position] + maze.ring[k]];
+}
+
+// Hazards along the route are the main danger; dead ends waste time and
+// reachable collectibles give lives and time back. Chokepoints on the route,
+// if counted, leave no way around whatever waits there and take a tenth of
+// the weight from hazards.
+static double DifficultyFromTerms(const SearchMaze& maze, int hazardsNearPath, int deadEnds,
+    int reachableCells, int reachableCollectibles, int routeChokepoints) {
+    double hazardPressure = maze.nearPathCount ? (double)hazardsNearPath / maze.nearPathCount : 0;
+    double deadEndRate = (double)deadEnds / (std::max)(1, reachableCells);
+    double relief = (double)reachableCollectibles / (1.0 + maze.solutionLength / 10.0);
+    double length = (double)maze.solutionLength / (2.0 * (maze.rows + maze.cols));
+    double forced = (double)routeChokepoints / (std::max)(1, maze.solutionLength - 1);
+    double forcedWeight = maze.routeCuts ? 0.1 : 0.0;
+    return (0.5 - forcedWeight) * (std::min)(1.0, 2.0 * hazardPressure)
+        + 0.2 * (std::min)(1.0, 4.0 * deadEndRate)
+        + 0.2 * (1.0 - (std::min)(1.0, relief))
+        + 0.1 * (std::min)(1.0, length)
+        + forcedWeight * (std::min)(1.0, forced);
+}
+
+// The protected path is hazard-free, so every route cut lies on it, and a
+// path cell whose ring lets routes around it is none: the path cells left
+// bound the count from above.
+static int RouteCutBound(const SearchMaze& maze, const SearchField& field, const DecorationMix& mix) {
+    int collectibleEnd = mix.collectible;
+    int blockedEnd = collectibleEnd + mix.hazard + mix.obstacle;
+    const uint8_t* ring = field.ringRolls.data();
+    int bound = 0;
+    for (size_t position = 1; position + 1 < maze.path.size(); position++) {
+        int mask = 0;
+        for (int k = 0; k < 8; k++) {
+            int roll = ring[position * 8 + k];
+            int walkable = (roll != ROLL_BLOCKED) & ((roll < collectibleEnd) | (roll >= blockedEnd));
+            mask |= walkable << k;
+        }
+        bound += !maze.ringBypass[mask];
+    }
+    return bound;
+}
+
+// Fill in the counts that come straight from the histograms, and bound how
+// close the full score could get to the target.
+static void ScoreCandidateCounts(const SearchMaze& maze, const SearchField& field, double target,
+    SearchCandidate& candidate) {
+    const DecorationMix& mix = candidate.mix;
+    int hazardEnd = mix.collectible + mix.hazard;
+    DecorationScore& score = candidate.score;
+    score.solutionLength = maze.solutionLength;
+    score.collectibles = field.below[mix.collectible];
+    score.hazardsNearPath = field.nearBelow[hazardEnd] - field.nearBelow[mix.collectible];
+    // Dead ends, reachability and chokepoints are unknown yet: take their
+    // extremes. The route cut bound only matters for a candidate that may be
+    // too easy.
+    double lowest = DifficultyFromTerms(maze, score.hazardsNearPath, 0, 1, score.collectibles, 0);
+    candidate.routeCutBound = maze.routeCuts ? maze.solutionLength - 1 : 0;
+    if (lowest >= target) {
+        candidate.lowerBound = lowest - target;
+        return;
+    }
+    if (maze.routeCuts)
+        candidate.routeCutBound = RouteCutBound(maze, field, mix);
+    double highest = DifficultyFromTerms(maze, score.hazardsNearPath, 1, 1, 0, candidate.routeCutBound);
+    candidate.lowerBound = (std::max)(0.0, target - highest);
+}
+
+static int BitCount(uint64_t bits) {
+    return (int)std::bitset<64>(bits).count();
+}
+
+// The cells of one bitset word whose roll is below bound (at most 128),
+// compared a bit plane at a time from the top.
+static uint64_t RollsBelow(const uint64_t* planes, int bound) {
+    uint64_t below = 0, equal = ~0ull;
+    for (int b = ROLL_PLANES - 1; b >= 0; b--) {
+        bool set = (bound >> b) & 1;
+        if (set)
+            below |= equal & ~planes[b];
+        equal &= set ? planes[b] : ~planes[b];
+    }
+    return below;
+}
+
+// Spread the bits of a bitset row along the runs of open cells they lie in.
+// Upwards an add carries each run's lowest bit to its top; downwards the
+// bits are doubled along the run, 1, 2, 4... cells at a time.
+static void FillRuns(uint64_t* row, const uint64_t* open, int words) {
+    for (int w = 0; w < words; w++) {
+        uint64_t bits = row[w] | (w > 0 ? open[w] & (row[w - 1] >> 63) : 0);
+        row[w] = bits | (open[w] & ((open[w] + bits) ^ open[w]));
+    }
+    for (int w = words - 1; w >= 0; w--) {
+        uint64_t bits = row[w] | (w + 1 < words ? open[w] & (row[w + 1] << 63) : 0);
+        uint64_t run = open[w];
+        for (int shift = 1; run && shift < 64; shift *= 2) {
+            bits |= run & (bits >> shift);
+            run &= run >> shift;
+        }
+        row[w] = bits;
+    }
+}
+
+// Reachability from the start by flooding bitset rows: a row takes the
+// reached cells above and below it and fills its runs, sweeping down and
+// then up the level until a round changes nothing. Only rows next to one
+// that grew are filled again. Dead ends are reached cells with one walkable
+// neighbour, counted a word at a time.
+static void ScoreCandidateReach(const SearchMaze& maze, const SearchField& field, SearchCandidate& candidate,
+    SearchScratch& scratch) {
+    int collectibleEnd = candidate.mix.collectible;
+    int blockedEnd = collectibleEnd + candidate.mix.hazard + candidate.mix.obstacle;
+    const int words = maze.words;
+    const size_t first = words, last = (size_t)(maze.rows + 1) * words;
+    scratch.walkable.assign(maze.passable.size(), 0);
+    scratch.reached.assign(maze.passable.size(), 0);
+    uint64_t* walkable = scratch.walkable.data();
+    uint64_t* reached = scratch.reached.data();
+    for (size_t i = first; i < last; i++) {
+        const uint64_t* planes = &field.planes[i * ROLL_PLANES];
+        walkable[i] = maze.passable[i] & (RollsBelow(planes, collectibleEnd) | ~RollsBelow(planes, blockedEnd));
+    }
+
+    scratch.fill.resize(words);
+    scratch.pending.assign(maze.rows + 2, 0);
+    uint64_t* fill = scratch.fill.data();
+    uint8_t* pending = scratch.pending.data();
+    reached[first] = walkable[first] & 1;
+    pending[1] = 1;
+    auto spreadRow = [&](int r) {
+        pending[r] = 0;
+        uint64_t* row = reached + r * words;
+        const uint64_t* open = walkable + r * words;
+        for (int w = 0; w < words; w++)
+            fill[w] = row[w] | (open[w] & (row[w - words] | row[w + words]));
+        FillRuns(fill, open, words);
+        uint64_t grown = 0;
+        for (int w = 0; w < words; w++) {
+            grown |= fill[w] ^ row[w];
+            row[w] = fill[w];
+        }
+        if (!grown)
+            return false;
+        pending[r - 1] = pending[r + 1] = 1;
+        return true;
+    };
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int r = 1; r <= maze.rows; r++)
+            if (pending[r])
+                changed |= spreadRow(r);
+        for (int r = maze.rows; r >= 1; r--)
+            if (pending[r])
+                changed |= spreadRow(r);
+    }
+
+    DecorationScore& score = candidate.score;
+    for (size_t i = first; i < last; i++) {
+        uint64_t bits = reached[i];
+        if (!bits)
+            continue;
+        int w = (int)(i % words);
+        uint64_t up = walkable[i - words], down = walkable[i + words];
+        uint64_t left = (walkable[i] << 1) | (w > 0 ? walkable[i - 1] >> 63 : 0);
+        uint64_t right = (walkable[i] >> 1) | (w + 1 < words ? walkable[i + 1] << 63 : 0);
+        uint64_t odd = up ^ down ^ left ^ right;
+        uint64_t twoOrMore = (up & down) | (left & right) | ((up ^ down) & (left ^ right));
+        score.reachableCells += BitCount(bits);
+        score.reachableCollectibles += BitCount(bits & RollsBelow(&field.planes[i * ROLL_PLANES], collectibleEnd));
+        score.deadEnds += BitCount(bits & odd & ~twoOrMore & ~maze.ends[i]);
+    }
+}
+
+// Count route cuts with AnalyzeChokepoints() on the cells ScoreCandidateReach
+// reached, the start's region with hazards blocked.
+static void ScoreCandidateCuts(const SearchMaze& maze, SearchCandidate& candidate, SearchScratch& scratch) {
+    scratch.open.assign(maze.base.size(), 0);
+    for (int r = 0; r < maze.rows; r++)
+        for (int c = 0; c < maze.cols; c++)
+            scratch.open[(r + 1) * maze.stride + c + 1] =
+                (uint8_t)((scratch.reached[(r + 1) * maze.words + c / 64] >> (c & 63)) & 1);
+    AnalyzeChokepoints(scratch.map, scratch.open, maze.rows, maze.cols);
+    candidate.score.routeChokepoints = scratch.map.routeCuts;
+}
+
+//-----------------------------------------------------------------------------
+// Search Functions
+//-----------------------------------------------------------------------------
+
+double TargetDifficulty(int levelIndex, int levelCount) {
+    if (levelCount <= 1)
+        return 0.5;
+    return 0.25 + 0.5 * levelIndex / (levelCount - 1);
+}
+
+std::vector<std::vector<int>> GenerateTargetedMazeLevel(MazeRng& rng, double targetDifficulty,
+    const LevelSearchOptions& options, int rows, int cols, LevelSearchResult* result) {
+    TRACE_SCOPE("GenerateTargetedMazeLevel");
+    std::vector<std::vector<int>> grid;
+    while (true) {
+        auto mazeCells = InitializeMazeCells(rows, cols);
+        GenerateMazeDFS(mazeCells, 0, 0, rng);
+        grid = ConvertMazeToGrid(mazeCells);
+        if (IsPathValid(grid))
+            break;
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    SearchMaze maze = PrepareSearchMaze(grid);
+    maze.routeCuts = options.routeCuts;
+    int candidateCount = (std::max)(1, options.candidates);
+    int fieldCount = (std::min)(candidateCount, (std::max)(1, options.fields));
+    std::vector<SearchField> fields(fieldCount);
+    for (auto& field : fields)
+        field.seed = rng.Next();
+    std::vector<SearchCandidate> candidates(candidateCount);
+    for (int i = 0; i < candidateCount; i++) {
+        candidates[i].field = i % fieldCount;
+        candidates[i].mix = DrawDecorationMix(rng);
+    }
+
+    int threadCount = options.threads > 0 ? options.threads
+        : (int)(std::max)(1u, std::thread::hardware_concurrency());
+    // Run fn(worker, index) for index in [0, count) on up to threadCount threads.
+    auto parallelFor = [&](int count, auto fn) {
+        int workers = (std::min)(threadCount, count);
+        if (workers <= 1) {
+            for (int i = 0; i < count; i++)
+                fn(0, i);
+            return;
+        }
+        std::vector<std::thread> threads;
+        for (int t = 0; t < workers; t++) {
+            threads.emplace_back([&, t]() {
+                for (int i = t; i < count; i += workers)
+                    fn(t, i);
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+    };
+
+    parallelFor(fieldCount, [&](int, int f) { RollSearchField(maze, fields[f]); });
+    for (auto& candidate : candidates)
+        ScoreCandidateCounts(maze, fields[candidate.field], targetDifficulty, candidate);
+
+    // Fully score candidates in order of their bound, a batch per pass, until
+    // no remaining bound can beat the best score. Once reachability is known
+    // only the route cuts are left, so if they are weighed in they are counted
+    // only if the bound that leaves can still beat the best score of earlier
+    // batches. Pruned candidates are strictly worse, so the pick is the same as
+    // scoring all of them.
+    std::vector<int> order(candidateCount);
+    for (int i = 0; i < candidateCount; i++)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return candidates[a].lowerBound < candidates[b].lowerBound
+            || (candidates[a].lowerBound == candidates[b].lowerBound && a < b);
+    });
+    std::vector<SearchScratch> scratch(threadCount);
+    std::vector<uint8_t> scored(candidateCount, 0);
+    int chosen = -1;
+    double chosenDistance = 1e9;
+    for (size_t next = 0; next < order.size();) {
+        if (candidates[order[next]].lowerBound > chosenDistance)
+            break;
+        size_t batch = (std::min)(order.size() - next, (size_t)threadCount);
+        parallelFor((int)batch, [&](int worker, int i) {
+            int index = order[next + i];
+            SearchCandidate& candidate = candidates[index];
+            DecorationScore& score = candidate.score;
+            ScoreCandidateReach(maze, fields[candidate.field], candidate, scratch[worker]);
+            double difficulty = DifficultyFromTerms(maze, score.hazardsNearPath, score.deadEnds,
+                score.reachableCells, score.reachableCollectibles, 0);
+            if (maze.routeCuts) {
+                double highest = DifficultyFromTerms(maze, score.hazardsNearPath, score.deadEnds,
+                    score.reachableCells, score.reachableCollectibles, candidate.routeCutBound);
+                if ((std::max)(difficulty - targetDifficulty, targetDifficulty - highest) > chosenDistance)
+                    return;
+                ScoreCandidateCuts(maze, candidate, scratch[worker]);
+                difficulty = DifficultyFromTerms(maze, score.hazardsNearPath, score.deadEnds,
+                    score.reachableCells, score.reachableCollectibles, score.routeChokepoints);
+            }
+            score.difficulty = difficulty;
+            scored[index] = 1;
+        });
+        for (size_t i = next; i < next + batch; i++) {
+            int index = order[i];
+            if (!scored[index])
+                continue;
+            double distance = std::fabs(candidates[index].score.difficulty - targetDifficulty);
+            if (distance < chosenDistance || (distance == chosenDistance && index < chosen)) {
+                chosenDistance = distance;
+                chosen = index;
+            }
+        }
+        next += batch;
+    }
+
+    // Replay the winning candidate on the real grid.
+    const SearchCandidate& winner = candidates[chosen];
+    MazeRng fieldRng(fields[winner.field].seed);
+    DecorateMaze(grid, fieldRng, winner.mix);
+    grid[0][0] = PASSAGE;
+    grid[rows - 1][cols - 1] = PASSAGE;
+    SealUnreachableIslands(grid);
+
+    if (result) {
+        result->score = winner.score;
+        result->candidate = chosen;
+        result->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    }
+    return grid;
+}
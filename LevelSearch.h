@@ -0,0 +1,55 @@
+// LevelSearch.h : search-based decoration aimed at a target difficulty
+//
+// Instead of one DecorateMaze pass with fixed chances, the search draws many
+// candidate decorations for the same carved maze, scores them and keeps the
+// one closest to the target difficulty. A candidate is a roll field (the
+// seeded DecorateMaze rolls) plus its own DecorationMix; counts come from
+// roll histograms, and the reachability pass (a bitset flood, 64 cells per
+// word), then the route cut pass if options.routeCuts asks for it, only run
+// for candidates whose bound can still beat the best score so far.
+
+#pragma once
+
+#include "MazeGenerator.h"
+
+// Which generator GameSession::NewGame uses.
+enum LevelGenerator {
+    LEVELGEN_CLASSIC,    // GenerateRandomMazeLevel, fixed chances
+    LEVELGEN_TARGETED    // GenerateTargetedMazeLevel, difficulty ramps up per level
+};
+
+// Measurements of one decoration.
+struct DecorationScore {
+    int solutionLength = 0;         // moves on the protected start-to-exit path
+    int hazardsNearPath = 0;        // hazards next to that path
+    int collectibles = 0;
+    int reachableCollectibles = 0;  // reachable from the start without touching a hazard
+    int reachableCells = 0;
+    int deadEnds = 0;               // reachable cells with a single way out
+    int routeChokepoints = 0;       // cells every hazard-free route passes, if counted (Chokepoints.h)
+    double difficulty = 0;          // weighted mix of the above, roughly 0..1
+};
+
+struct LevelSearchOptions {
+    int candidates = 256;
+    int fields = 8;         // roll fields shared by the candidates
+    int threads = 1;        // 0 = one per hardware core
+    bool routeCuts = false; // weigh route chokepoints into the difficulty; slower
+};
+
+struct LevelSearchResult {
+    DecorationScore score;  // score of the chosen candidate
+    int candidate = -1;
+    double seconds = 0;     // time spent decorating and scoring candidates
+};
+
+// Target for level levelIndex of levelCount: 0.25 on the first level rising to
+// 0.75 on the last.
+double TargetDifficulty(int levelIndex, int levelCount);
+
+// Carve a maze like GenerateRandomMazeLevel, then decorate it with the best of
+// options.candidates candidates. The result depends on rng and the candidate
+// and field counts, never on the thread count.
+std::vector<std::vector<int>> GenerateTargetedMazeLevel(MazeRng& rng, double targetDifficulty,
+    const LevelSearchOptions& options = LevelSearchOptions(), int rows = GRID_ROWS, int cols = GRID_COLS,
+    LevelSearchResult* result = nullptr);
@@ -0,0 +1,72 @@
+// MazeGame.h : definitions shared by the game and its helper modules
+//
+
+#pragma once
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+// Minimal stand-in so the platform independent modules also build off Windows.
+struct POINT {
+    long x;
+    long y;
+};
+#endif
+#include <vector>
+#include <cstdint>
+
+// Constants for maze dimensions
+#define GRID_ROWS 10
+#define GRID_COLS 10
+
+// Total levels
+#define TOTAL_LEVELS 5
+
+// --- Cell values ---
+// For better readability, define symbolic names for cell values.
+enum CellType {
+    PASSAGE = 0,    // empty (used for start/end)
+    WALL = 1,
+    COLLECTIBLE = 2, // collectible: adds one life
+    HAZARD = 3,      // harmful hurdle: subtracts life and time
+    OBSTACLE = 4,    // blocks movement
+    MINIDOT = 5,     // safe passage with a mini-dot (score available)
+    TELEPORTER = 6   // pad linked to another pad, see Teleporters.h
+};
+
+// Direction indices shared by the move journal and input recordings:
+// 0 up, 1 right, 2 down, 3 left.
+inline int MoveDirectionIndex(int dx, int dy) {
+    if (dy < 0) return 0;
+    if (dx > 0) return 1;
+    if (dy > 0) return 2;
+    return 3;
+}
+
+inline void MoveDirectionStep(int dir, int& dx, int& dy) {
+    static const int stepX[4] = { 0, 1, 0, -1 };
+    static const int stepY[4] = { -1, 0, 1, 0 };
+    dx = stepX[dir];
+    dy = stepY[dir];
+}
+
+// Small deterministic generator (xorshift32) used for level generation, so the
+// same seed always produces the same set of levels. It is constexpr so levels
+// can also be generated at compile time (BakedLevels.h).
+struct MazeRng {
+    uint32_t state;
+
+    explicit constexpr MazeRng(uint32_t seed = 1) : state(seed ? seed : 0x9E3779B9u) {}
+
+    constexpr uint32_t Next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // Uniform-ish value in [0, n).
+    constexpr int Below(int n) {
+        return (int)(Next() % (uint32_t)n);
+    }
+};
@@ -0,0 +1,269 @@
+#include "MazeGenerator.h"
+#include "FixedGrid.h"
+#include "Tracing.h"
+#include <algorithm>
+#include <stack>
+#include <queue>
+
+// Initialize a 2D vector of MazeCell objects.
+std::vector<std::vector<MazeCell>> InitializeMazeCells(int rows, int cols) {
+    return std::vector<std::vector<MazeCell>>(rows, std::vector<MazeCell>(cols));
+}
+
+// Remove wall between two adjacent cells.
+void RemoveWall(MazeCell& current, MazeCell& next, int dx, int dy) {
+    if (dx == 1) {
+        current.right = false;
+        next.left = false;
+    }
+    else if (dx == -1) {
+        current.left = false;
+        next.right = false;
+    }
+    else if (dy == 1) {
+        current.bottom = false;
+        next.top = false;
+    }
+    else if (dy == -1) {
+        current.top = false;
+        next.bottom = false;
+    }
+}
+
+// Maze generation using DFS (iterative with a stack).
+void GenerateMazeDFS(std::vector<std::vector<MazeCell>>& maze, int startRow, int startCol, MazeRng& rng) {
+    int rows = maze.size(), cols = maze[0].size();
+    std::stack<POINT> cellStack;
+    maze[startRow][startCol].visited = true;
+    cellStack.push({ startCol, startRow });
+    std::vector<POINT> directions = { {0, -1}, {1, 0}, {0, 1}, {-1, 0} };
+    while (!cellStack.empty()) {
+        POINT current = cellStack.top();
+        int curRow = current.y, curCol = current.x;
+        std::vector<POINT> neighbors;
+        for (auto dir : directions) {
+            int newRow = curRow + dir.y, newCol = curCol + dir.x;
+            if (newRow >= 0 && newRow < rows && newCol >= 0 && newCol < cols &&
+                !maze[newRow][newCol].visited) {
+                neighbors.push_back(dir);
+            }
+        }
+        if (!neighbors.empty()) {
+            int index = rng.Below(neighbors.size());
+            POINT chosen = neighbors[index];
+            int newRow = curRow + chosen.y, newCol = curCol + chosen.x;
+            RemoveWall(maze[curRow][curCol], maze[newRow][newCol], chosen.x, chosen.y);
+            maze[newRow][newCol].visited = true;
+            cellStack.push({ newCol, newRow });
+        }
+        else {
+            cellStack.pop();
+        }
+    }
+}
+
+// Convert the MazeCell grid to a grid of integers.
+// Initially mark passages as PASSAGE.
+std::vector<std::vector<int>> ConvertMazeToGrid(const std::vector<std::vector<MazeCell>>& maze) {
+    int rows = maze.size(), cols = maze[0].size();
+    std::vector<std::vector<int>> grid(rows, std::vector<int>(cols, WALL));
+    for (int r = 0; r < rows; r++)
+        for (int c = 0; c < cols; c++)
+            if (!maze[r][c].top || !maze[r][c].bottom || !maze[r][c].left || !maze[r][c].right || maze[r][c].visited)
+                grid[r][c] = PASSAGE;
+    grid[0][0] = PASSAGE;
+    grid[rows - 1][cols - 1] = PASSAGE;
+    return grid;
+}
+
+// Check if there is a valid path from start to end using BFS.
+bool IsPathValid(const std::vector<std::vector<int>>& grid) {
+    int rows = grid.size(), cols = grid[0].size();
+    std::vector<std::vector<bool>> visited(rows, std::vector<bool>(cols, false));
+    std::queue<POINT> q;
+    POINT start = { 0, 0 }, end = { cols - 1, rows - 1 };
+    q.push(start);
+    visited[start.y][start.x] = true;
+    std::vector<POINT> directions = { {0, -1}, {1, 0}, {0, 1}, {-1, 0} };
+    while (!q.empty()) {
+        POINT cur = q.front();
+        q.pop();
+        if (cur.x == end.x && cur.y == end.y)
+            return true;
+        for (auto d : directions) {
+            int nx = cur.x + d.x, ny = cur.y + d.y;
+            if (nx >= 0 && nx < cols && ny >= 0 && ny < rows &&
+                !visited[ny][nx] && grid[ny][nx] == PASSAGE) {
+                visited[ny][nx] = true;
+                q.push({ nx, ny });
+            }
+        }
+    }
+    return false;
+}
+
+// Get one valid path from start to end using BFS with predecessor tracking.
+std::vector<POINT> GetValidPath(const std::vector<std::vector<int>>& grid) {
+    int rows = grid.size(), cols = grid[0].size();
+    std::vector<std::vector<bool>> visited(rows, std::vector<bool>(cols, false));
+    std::vector<std::vector<POINT>> parent(rows, std::vector<POINT>(cols, { -1, -1 }));
+    std::queue<POINT> q;
+    POINT start = { 0, 0 }, end = { cols - 1, rows - 1 };
+    q.push(start);
+    visited[start.y][start.x] = true;
+    std::vector<POINT> directions = { {0, -1}, {1, 0}, {0, 1}, {-1, 0} };
+    bool found = false;
+    while (!q.empty() && !found) {
+        POINT cur = q.front();
+        q.pop();
+        if (cur.x == end.x && cur.y == end.y) {
+            found = true;
+            break;
+        }
+        for (auto d : directions) {
+            int nx = cur.x + d.x, ny = cur.y + d.y;
+            if (nx >= 0 && nx < cols && ny >= 0 && ny < rows &&
+                !visited[ny][nx] && grid[ny][nx] == PASSAGE) {
+                visited[ny][nx] = true;
+                parent[ny][nx] = cur;
+                q.push({ nx, ny });
+            }
+        }
+    }
+    std::vector<POINT> path;
+    if (found) {
+        POINT cur = end;
+        while (!(cur.x == start.x && cur.y == start.y)) {
+            path.push_back(cur);
+            cur = parent[cur.y][cur.x];
+        }
+        path.push_back(start);
+    }
+    return path;
+}
+
+// Decorate the maze: for every PASSAGE cell not on the valid path,
+// randomly change it to COLLECTIBLE, HAZARD, or OBSTACLE. Then convert remaining PASSAGE cells to MINIDOT.
+void DecorateMaze(std::vector<std::vector<int>>& grid, MazeRng& rng, const DecorationMix& mix) {
+    int rows = grid.size(), cols = grid[0].size();
+    std::vector<POINT> validPath = GetValidPath(grid);
+    std::vector<std::vector<bool>> isValidPath(rows, std::vector<bool>(cols, false));
+    for (auto p : validPath)
+        isValidPath[p.y][p.x] = true;
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            if (grid[r][c] == PASSAGE && !isValidPath[r][c]) {
+                if ((r == 0 && c == 0) || (r == rows - 1 && c == cols - 1))
+                    continue;
+                grid[r][c] = mix.CellForRoll(rng.Below(100));
+            }
+        }
+    }
+    for (int r = 0; r < rows; r++)
+        for (int c = 0; c < cols; c++)
+            if (grid[r][c] == PASSAGE)
+                grid[r][c] = MINIDOT;
+}
+
+// Root of a provisional label, halving the path on the way.
+static int FindLabel(std::vector<int>& parent, int label) {
+    while (parent[label] != label) {
+        parent[label] = parent[parent[label]];
+        label = parent[label];
+    }
+    return label;
+}
+
+LevelReach SealUnreachableIslands(std::vector<std::vector<int>>& grid) {
+    LevelReach reach;
+    int rows = grid.size(), cols = grid[0].size();
+    auto walkable = [](int value) { return value != WALL && value != OBSTACLE && value != HAZARD; };
+    if (!walkable(grid[0][0]))
+        return reach;
+
+    // First pass: each walkable cell takes the label of its upper or left
+    // neighbour, a new label if it has neither, and joins the two if they differ.
+    std::vector<int> label(rows * cols, -1);
+    std::vector<int> parent;
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            if (!walkable(grid[r][c]))
+                continue;
+            int i = r * cols + c;
+            int up = r > 0 ? label[i - cols] : -1;
+            int left = c > 0 ? label[i - 1] : -1;
+            if (up < 0 && left < 0) {
+                label[i] = parent.size();
+                parent.push_back(label[i]);
+            }
+            else if (up < 0 || left < 0) {
+                label[i] = (std::max)(up, left);
+            }
+            else {
+                int a = FindLabel(parent, up), b = FindLabel(parent, left);
+                parent[(std::max)(a, b)] = (std::min)(a, b);
+                label[i] = (std::min)(a, b);
+            }
+        }
+    }
+
+    // Second pass: cells outside the start's region become obstacles; hazards
+    // are left as they are.
+    int startRoot = FindLabel(parent, label[0]);
+    std::vector<bool> counted(parent.size(), false);
+    const int rowSteps[4] = { -1, 0, 1, 0 }, colSteps[4] = { 0, 1, 0, -1 };
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            int i = r * cols + c;
+            int& cell = grid[r][c];
+            if (label[i] < 0) {
+                // Hazards are not walked through; count those the player can run into.
+                bool touched = false;
+                for (int d = 0; d < 4 && cell == HAZARD && !touched; d++) {
+                    int nr = r + rowSteps[d], nc = c + colSteps[d];
+                    if (nr >= 0 && nr < rows && nc >= 0 && nc < cols && label[nr * cols + nc] >= 0)
+                        touched = FindLabel(parent, label[nr * cols + nc]) == startRoot;
+                }
+                reach.hazards += touched;
+                continue;
+            }
+            int root = FindLabel(parent, label[i]);
+            if (root == startRoot) {
+                reach.collectibles += cell == COLLECTIBLE;
+                reach.minidots += cell == MINIDOT;
+                continue;
+            }
+            if (!counted[root]) {
+                counted[root] = true;
+                reach.islands++;
+            }
+            reach.sealedItems += cell == COLLECTIBLE || cell == MINIDOT;
+            reach.sealedCells++;
+            cell = OBSTACLE;
+        }
+    }
+    return reach;
+}
+
+// Generate one valid maze level and decorate it. The shipped size takes the
+// fixed-size code from FixedGrid.h, which gives the same level.
+std::vector<std::vector<int>> GenerateRandomMazeLevel(MazeRng& rng, int rows, int cols) {
+    TRACE_SCOPE("GenerateRandomMazeLevel");
+    if (rows == GRID_ROWS && cols == GRID_COLS) {
+        FixedGrid<GRID_ROWS, GRID_COLS> level;
+        GenerateRandomMazeLevel(rng, level);
+        return level.ToVector();
+    }
+    while (true) {
+        auto mazeCells = InitializeMazeCells(rows, cols);
+        GenerateMazeDFS(mazeCells, 0, 0, rng);
+        auto grid = ConvertMazeToGrid(mazeCells);
+        if (IsPathValid(grid)) {
+            DecorateMaze(grid, rng);
+            grid[0][0] = PASSAGE;
+            grid[rows - 1][cols - 1] = PASSAGE;
+            SealUnreachableIslands(grid);
+            return grid;
+        }
+    }
+}
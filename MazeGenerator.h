@@ -0,0 +1,71 @@
+// MazeGenerator.h : random maze carving, path checks and decoration
+//
+
+#pragma once
+
+#include "MazeGame.h"
+
+// Maze cell structure for generating the maze.
+struct MazeCell {
+    bool visited = false;
+    bool top = true, bottom = true, left = true, right = true;
+};
+
+// Initialize a 2D vector of MazeCell objects.
+std::vector<std::vector<MazeCell>> InitializeMazeCells(int rows, int cols);
+
+// Remove wall between two adjacent cells.
+void RemoveWall(MazeCell& current, MazeCell& next, int dx, int dy);
+
+// Maze generation using DFS (iterative with a stack).
+void GenerateMazeDFS(std::vector<std::vector<MazeCell>>& maze, int startRow, int startCol, MazeRng& rng);
+
+// Convert the MazeCell grid to a grid of integers.
+std::vector<std::vector<int>> ConvertMazeToGrid(const std::vector<std::vector<MazeCell>>& maze);
+
+// Check if there is a valid path from start to end using BFS.
+bool IsPathValid(const std::vector<std::vector<int>>& grid);
+
+// Get one valid path from start to end using BFS with predecessor tracking.
+std::vector<POINT> GetValidPath(const std::vector<std::vector<int>>& grid);
+
+// Percent chances that a decorated cell becomes each item; the rest stay
+// passages and get a mini-dot.
+struct DecorationMix {
+    int collectible = 5;
+    int hazard = 10;
+    int obstacle = 20;
+
+    // Cell value for one roll in [0, 100).
+    constexpr int CellForRoll(int roll) const {
+        if (roll < collectible) return COLLECTIBLE;
+        if (roll < collectible + hazard) return HAZARD;
+        if (roll < collectible + hazard + obstacle) return OBSTACLE;
+        return PASSAGE;
+    }
+};
+
+// Decorate the maze with collectibles, hazards, obstacles and mini-dots.
+void DecorateMaze(std::vector<std::vector<int>>& grid, MazeRng& rng, const DecorationMix& mix = DecorationMix());
+
+// What SealUnreachableIslands() found and left. The item counts are of the
+// cells the start can still reach.
+struct LevelReach {
+    int islands = 0;        // regions the start could not reach
+    int sealedCells = 0;    // their cells, now obstacles
+    int sealedItems = 0;    // collectibles and mini-dots among those
+    int collectibles = 0;
+    int minidots = 0;
+    int hazards = 0;        // next to the start's region
+};
+
+// Label the regions of cells the player can walk (anything but WALL, OBSTACLE
+// and HAZARD; stepping on a hazard costs a life and sends the player back to
+// the start) with a two-pass union-find, then turn every region the start
+// cannot reach into obstacles, so no item is left that can only be taken
+// across a hazard or not at all. Linear in the cell count and draws no random
+// numbers.
+LevelReach SealUnreachableIslands(std::vector<std::vector<int>>& grid);
+
+// Generate one valid maze level and decorate it.
+std::vector<std::vector<int>> GenerateRandomMazeLevel(MazeRng& rng, int rows = GRID_ROWS, int cols = GRID_COLS);
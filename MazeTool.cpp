@@ -0,0 +1,1447 @@
+// MazeTool.cpp : command-line tools built on the headless game core
+//
+// Usage:
+//   MazeTool replay <file.rec> [repeat]
+//   MazeTool bench-sessions [sessions] [steps] [threads]
+//   MazeTool bots [shortest|greedy|random|all] [games] [threads] [firstSeed] [classic|targeted]
+//   MazeTool search-levels [size] [candidates] [threads] [levels] [cuts]
+//   MazeTool mix <out.wav> <in.wav>...
+//   MazeTool bench-mixer [maxVoices] [seconds]
+//   MazeTool bench-audio [commands] [burst]
+//   MazeTool pack <out.pak> <file>...
+//   MazeTool pack-list <file.pak> [verify]
+//   MazeTool bench-scores [entries] [queries]
+//   MazeTool bench-nearest [size] [levels] [queries]
+//   MazeTool bench-fov [size] [radius] [moves]
+//   MazeTool bench-entities [size] [maxEntities] [ticks]
+//   MazeTool bench-portals [size] [levels] [queries]
+//   MazeTool bench-grids [levels]
+//   MazeTool verify-baked [repeat]
+//   MazeTool bench-codec [size] [levels]
+//   MazeTool generate-levels <out.lvp> [levels] [size] [threads] [firstSeed]
+//   MazeTool bench-chokepoints [size] [levels] [bigSize]
+//   MazeTool bench-reach [seed] [size] [levels]
+//   MazeTool bench-trace [spans] [out.json]
+
+#include "GameSession.h"
+#include "SessionHost.h"
+#include "InputRecording.h"
+#include "BotAgents.h"
+#include "AudioEngine.h"
+#include "AssetArchive.h"
+#include "HighScores.h"
+#include "NearestItem.h"
+#include "FieldOfView.h"
+#include "EntitySystem.h"
+#include "Teleporters.h"
+#include "MazeGenerator.h"
+#include "FixedGrid.h"
+#include "BakedLevels.h"
+#include "LevelCodec.h"
+#include "LevelPack.h"
+#include "Chokepoints.h"
+#include "Tracing.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <thread>
+
+static int ArgInt(int argc, char** argv, int index, int fallback) {
+    return index < argc ? atoi(argv[index]) : fallback;
+}
+
+static double SecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Replay a recording and compare its final state hash.
+static int CommandReplay(int argc, char** argv) {
+    if (argc < 3) {
+        printf("usage: MazeTool replay <file.rec> [repeat]\n");
+        return 2;
+    }
+    InputRecording recording;
+    if (!LoadInputRecording(argv[2], recording)) {
+        printf("replay: cannot read %s\n", argv[2]);
+        return 2;
+    }
+    int repeat = ArgInt(argc, argv, 3, 1);
+    ReplayResult result = ReplayRecording(recording, repeat);
+    printf("replay: seed %u, %zu inputs, %d run(s)\n", recording.seed, recording.inputs.size(), repeat);
+    printf("replay: %.0f moves/s (%.3f ms total)\n", result.MovesPerSecond(), result.seconds * 1000.0);
+    printf("replay: final state hash %016llx\n", (unsigned long long)result.finalHash);
+    if (!recording.hasFinalHash)
+        return 0;
+    bool match = result.finalHash == recording.finalHash;
+    printf("replay: %s (recorded %016llx)\n", match ? "MATCH" : "MISMATCH", (unsigned long long)recording.finalHash);
+    return match ? 0 : 1;
+}
+
+// Step many sessions on worker threads, once per thread count from 1 up to
+// the requested number, and report steps per second per core.
+static int CommandBenchSessions(int argc, char** argv) {
+    int sessionCount = ArgInt(argc, argv, 2, 4096);
+    int steps = ArgInt(argc, argv, 3, 2000);
+    int maxThreads = ArgInt(argc, argv, 4, (int)std::thread::hardware_concurrency());
+    if (maxThreads <= 0)
+        maxThreads = 1;
+    printf("bench-sessions: %d sessions x %d steps\n", sessionCount, steps);
+    printf("%8s %16s %16s %14s\n", "threads", "steps/s", "steps/s/core", "sessions/s");
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        SessionHost host(sessionCount, threads);
+        host.NewGames(1);
+        SessionRunStats stats = host.RunRandomSteps(steps, 12345);
+        printf("%8d %16.0f %16.0f %14.0f\n", threads, stats.StepsPerSecond(),
+            stats.StepsPerSecondPerCore(), sessionCount / stats.seconds);
+        if (threads < maxThreads && threads * 2 > maxThreads)
+            threads = maxThreads / 2;
+    }
+    return 0;
+}
+
+// Play many games with one or all bot agents and print per-level results.
+static int CommandBots(int argc, char** argv) {
+    std::string which = argc > 2 ? argv[2] : "all";
+    BatchOptions options;
+    options.games = (uint64_t)ArgInt(argc, argv, 3, 100000);
+    options.threads = ArgInt(argc, argv, 4, 0);
+    options.firstSeed = (uint32_t)ArgInt(argc, argv, 5, 1);
+    if (argc > 6 && strcmp(argv[6], "targeted") == 0)
+        options.generator = LEVELGEN_TARGETED;
+    for (int k = 0; k < BOT_KIND_COUNT; k++) {
+        BotKind kind = (BotKind)k;
+        if (which != "all") {
+            if (!ParseBotKind(which, kind)) {
+                printf("bots: unknown agent '%s'\n", which.c_str());
+                return 2;
+            }
+            k = BOT_KIND_COUNT;
+        }
+        options.kind = kind;
+        BatchStats stats = RunBotBatch(options);
+        printf("bots: %s, %llu games, win rate %.1f%%, %.0f games/s, %.0f steps/s\n", BotKindName(kind),
+            (unsigned long long)stats.games, stats.WinRate() * 100.0, stats.GamesPerSecond(),
+            stats.seconds > 0 ? stats.steps / stats.seconds : 0.0);
+        printf("%6s %10s %8s %12s %12s %10s %10s\n", "level", "entered", "cleared", "hazard/game", "timer/game",
+            "score", "timeLeft");
+        for (size_t i = 0; i < stats.levels.size(); i++) {
+            const LevelStats& level = stats.levels[i];
+            double entered = level.entered ? (double)level.entered : 1.0;
+            double cleared = level.cleared ? (double)level.cleared : 1.0;
+            printf("%6zu %10llu %7.1f%% %12.3f %12.3f %10.2f %10.2f\n", i + 1, (unsigned long long)level.entered,
+                100.0 * level.cleared / entered, level.hazardLivesLost / entered, level.timeLivesLost / entered,
+                level.score / entered, level.timeLeftAtClear / cleared);
+        }
+    }
+    return 0;
+}
+
+// Generate square levels with the difficulty search and report how close
+// each one got to its target and how long the candidate search took. With
+// "cuts" the search weighs route cuts in, and the ones it counted are checked
+// against AnalyzeChokepoints() on the finished level.
+static int CommandSearchLevels(int argc, char** argv) {
+    int size = ArgInt(argc, argv, 2, 100);
+    LevelSearchOptions options;
+    options.candidates = ArgInt(argc, argv, 3, 256);
+    options.threads = ArgInt(argc, argv, 4, 0);
+    int levels = ArgInt(argc, argv, 5, TOTAL_LEVELS);
+    options.routeCuts = argc > 6 && strcmp(argv[6], "cuts") == 0;
+    printf("search-levels: %dx%d, %d candidates, %d level(s)%s\n", size, size, options.candidates, levels,
+        options.routeCuts ? ", route cuts" : "");
+    printf("%6s %8s %10s %8s %8s %6s %10s %10s %10s\n", "level", "target", "difficulty", "hazards", "deadEnds",
+        "cuts", "items", "candidate", "search ms");
+    MazeRng rng(12345);
+    double totalSeconds = 0;
+    int mismatches = 0;
+    for (int i = 0; i < levels; i++) {
+        LevelSearchResult result;
+        double target = TargetDifficulty(i, levels);
+        auto grid = GenerateTargetedMazeLevel(rng, target, options, size, size, &result);
+        totalSeconds += result.seconds;
+        if (options.routeCuts) {
+            ChokepointMap hazardFree = AnalyzeChokepoints(grid, CHOKE_BLOCKING_CELLS | (1u << HAZARD));
+            mismatches += hazardFree.routeCuts != result.score.routeChokepoints;
+        }
+        printf("%6d %8.3f %10.3f %8d %8d %6d %4d/%-5d %10d %10.2f\n", i + 1, target, result.score.difficulty,
+            result.score.hazardsNearPath, result.score.deadEnds, result.score.routeChokepoints,
+            result.score.reachableCollectibles,
+            result.score.collectibles, result.candidate, result.seconds * 1000.0);
+    }
+    printf("search-levels: %.2f ms per level\n", totalSeconds * 1000.0 / (std::max)(1, levels));
+    if (mismatches) {
+        printf("search-levels: %d level(s) with route cuts that differ from AnalyzeChokepoints\n", mismatches);
+        return 1;
+    }
+    return 0;
+}
+
+// Play every input WAV at once through the mixer into one output file.
+static int CommandMix(int argc, char** argv) {
+    if (argc < 4) {
+        printf("usage: MazeTool mix <out.wav> <in.wav>...\n");
+        return 2;
+    }
+    SoundBank bank;
+    SoundMixer mixer;
+    for (int i = 3; i < argc; i++) {
+        if (!bank.LoadFile(argv[i], argv[i])) {
+            printf("mix: cannot decode %s\n", argv[i]);
+            return 2;
+        }
+        mixer.Play(bank.Find(argv[i]));
+    }
+    WavFileSink sink;
+    if (!sink.Open(argv[2])) {
+        printf("mix: cannot write %s\n", argv[2]);
+        return 2;
+    }
+    uint64_t frames = 0;
+    while (mixer.ActiveVoices() > 0) {
+        mixer.Render(sink);
+        frames += sink.FramesWanted();
+    }
+    sink.Close();
+    printf("mix: %d clip(s), %.2f s written to %s\n", argc - 3, (double)frames / MIXER_SAMPLE_RATE, argv[2]);
+    return 0;
+}
+
+// Mix 1, 2, 4 ... maxVoices looping voices into a null sink and report the
+// cost per voice. Uses the game's WAV files from the working directory, or a
+// generated tone if they are missing.
+static int CommandBenchMixer(int argc, char** argv) {
+    int maxVoices = ArgInt(argc, argv, 2, 64);
+    int seconds = ArgInt(argc, argv, 3, 10);
+    SoundBank bank;
+    const char* files[] = { "hazard01.wav", "lvl.wav", "mov.wav", "powerup.wav", "thrill01.wav", "win01.wav" };
+    std::vector<const SoundClip*> clips;
+    for (const char* file : files)
+        if (bank.LoadFile(file, file))
+            clips.push_back(bank.Find(file));
+    SoundClip tone;
+    if (clips.empty()) {
+        std::vector<int16_t> samples(MIXER_SAMPLE_RATE * MIXER_CHANNELS);
+        for (size_t i = 0; i < samples.size(); i++)
+            samples[i] = (int16_t)(8000 * sin((i / MIXER_CHANNELS) * 440.0 * 6.283185 / MIXER_SAMPLE_RATE));
+        tone.SetSamples(std::move(samples));
+        clips.push_back(&tone);
+    }
+    printf("bench-mixer: %zu clip(s), %.1f MB of PCM, %d s of audio per run\n", clips.size(),
+        bank.BytesUsed() / 1048576.0, seconds);
+    printf("%8s %14s %18s %14s\n", "voices", "ns/frame", "ns/frame/voice", "x realtime");
+    for (int voices = 1; voices <= maxVoices; voices *= 2) {
+        SoundMixer mixer;
+        for (int v = 0; v < voices; v++)
+            mixer.Play(clips[v % clips.size()], 0.5f, true);
+        NullSink sink(512);
+        uint64_t frames = (uint64_t)seconds * MIXER_SAMPLE_RATE;
+        auto start = std::chrono::steady_clock::now();
+        while (sink.FramesWritten() < frames)
+            mixer.Render(sink);
+        double elapsed = SecondsSince(start);
+        double nsPerFrame = elapsed * 1e9 / sink.FramesWritten();
+        printf("%8d %14.2f %18.3f %14.0f\n", voices, nsPerFrame, nsPerFrame / voices, seconds / elapsed);
+    }
+    return 0;
+}
+
+// Post effect commands to a running audio engine (null sink) in bursts and
+// report what the game thread pays per enqueue, including the worst case.
+static int CommandBenchAudio(int argc, char** argv) {
+    int commands = ArgInt(argc, argv, 2, 200000);
+    int burst = (std::max)(1, ArgInt(argc, argv, 3, 16));
+    SoundClip blip;
+    blip.SetSamples(std::vector<int16_t>(MIXER_SAMPLE_RATE / 50 * MIXER_CHANNELS, 1000));
+    NullSink sink(441);
+    AudioEngine engine;
+    engine.Start(&sink, nullptr);
+    std::vector<double> costs;
+    costs.reserve(commands);
+    for (int i = 0; i < commands; i++) {
+        auto start = std::chrono::steady_clock::now();
+        if (i % 4 == 3)
+            engine.SetEffectsVolume(0.5f + (i & 7) / 16.0f);
+        else
+            engine.PlayEffect(&blip, 0.25f);
+        costs.push_back(SecondsSince(start) * 1e9);
+        if (i % burst == burst - 1)
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    engine.Stop();
+    AudioLatencyStats stats = engine.Stats();
+    std::sort(costs.begin(), costs.end());
+    printf("bench-audio: %llu commands in bursts of %d, %llu dropped (queue full)\n",
+        (unsigned long long)stats.commands, burst, (unsigned long long)stats.dropped);
+    printf("bench-audio: enqueue avg %.0f ns, p50 %.0f ns, p99 %.0f ns, p99.99 %.0f ns, max %.0f ns\n",
+        stats.enqueueAvgNs, costs[costs.size() / 2], costs[costs.size() * 99 / 100],
+        costs[(size_t)(costs.size() * 0.9999)], costs.back());
+    printf("bench-audio: dispatch delay max %.2f ms, %llu frames mixed\n", stats.dispatchMaxMs,
+        (unsigned long long)sink.FramesWritten());
+    return 0;
+}
+
+// Pack asset files into one archive; run by the PackAssets build target.
+static int CommandPack(int argc, char** argv) {
+    if (argc < 4) {
+        printf("usage: MazeTool pack <out.pak> <file>...\n");
+        return 2;
+    }
+    std::vector<std::string> files(argv + 3, argv + argc);
+    std::string error;
+    if (!BuildAssetArchive(argv[2], files, error)) {
+        printf("pack: %s\n", error.c_str());
+        return 1;
+    }
+    AssetArchive archive;
+    if (!archive.Open(argv[2])) {
+        printf("pack: %s does not read back\n", argv[2]);
+        return 1;
+    }
+    uint64_t bytes = 0;
+    for (size_t i = 0; i < archive.Count(); i++)
+        bytes += archive.Entry(i).length;
+    printf("pack: %zu file(s), %.2f MB written to %s\n", archive.Count(), bytes / 1048576.0, argv[2]);
+    return 0;
+}
+
+// List an archive's index and optionally re-hash every asset.
+static int CommandPackList(int argc, char** argv) {
+    if (argc < 3) {
+        printf("usage: MazeTool pack-list <file.pak> [verify]\n");
+        return 2;
+    }
+    bool verify = argc >= 4 && strcmp(argv[3], "verify") == 0;
+    auto start = std::chrono::steady_clock::now();
+    AssetArchive archive;
+    if (!archive.Open(argv[2])) {
+        printf("pack-list: %s is missing or not a valid archive\n", argv[2]);
+        return 1;
+    }
+    double openMs = SecondsSince(start) * 1e3;
+    int failures = 0;
+    printf("%-32s %12s %12s %18s%s\n", "name", "offset", "length", "hash", verify ? "  check" : "");
+    for (size_t i = 0; i < archive.Count(); i++) {
+        const PackEntry& entry = archive.Entry(i);
+        printf("%-32s %12llu %12llu  %016llx", archive.EntryName(i).c_str(), (unsigned long long)entry.offset,
+            (unsigned long long)entry.length, (unsigned long long)entry.hash);
+        if (verify) {
+            bool ok = archive.Verify(i);
+            failures += ok ? 0 : 1;
+            printf("  %s", ok ? "ok" : "BAD");
+        }
+        printf("\n");
+    }
+    printf("pack-list: %zu asset(s), opened in %.3f ms\n", archive.Count(), openMs);
+    return failures == 0 ? 0 : 1;
+}
+
+// Fill a high-score table with random results and time inserts, rank
+// lookups, top-10 pages and the on-disk log (append, then reload).
+static int CommandBenchScores(int argc, char** argv) {
+    int entries = (std::max)(1, ArgInt(argc, argv, 2, 1000000));
+    int queries = (std::max)(1, ArgInt(argc, argv, 3, 1000000));
+    MazeRng rng(12345);
+    std::vector<HighScore> results(entries);
+    for (HighScore& result : results) {
+        result.seed = rng.Next();
+        result.name = "player" + std::to_string(rng.Below(10000));
+        result.score = rng.Below(100000);
+    }
+    auto rate = [](double count, std::chrono::steady_clock::time_point start) {
+        return count / SecondsSince(start);
+    };
+
+    HighScoreTable table;
+    auto start = std::chrono::steady_clock::now();
+    for (const HighScore& result : results)
+        table.Submit(result.seed, result.name, result.score);
+    printf("bench-scores: %zu entries\n", table.Count());
+    printf("%-24s %14.0f /s\n", "insert", rate(entries, start));
+
+    uint64_t checksum = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < queries; i++) {
+        const HighScore& result = results[rng.Below(entries)];
+        checksum += (uint64_t)table.Rank(result.seed, result.name);
+    }
+    printf("%-24s %14.0f /s\n", "rank of entry", rate(queries, start));
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < queries; i++)
+        checksum += table.RankOfScore(rng.Below(100000));
+    printf("%-24s %14.0f /s\n", "rank of score", rate(queries, start));
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < queries; i++)
+        checksum += table.Top(10, rng.Below(entries)).size();
+    printf("%-24s %14.0f /s\n", "top 10 at any rank", rate(queries, start));
+
+    const char* path = "bench-scores.dat";
+    std::remove(path);
+    HighScoreStore store;
+    if (!store.Open(path)) {
+        printf("bench-scores: cannot write %s\n", path);
+        return 1;
+    }
+    start = std::chrono::steady_clock::now();
+    for (const HighScore& result : results)
+        store.Submit(result.seed, result.name, result.score);
+    store.Close();
+    printf("%-24s %14.0f /s\n", "append to log", rate(entries, start));
+    start = std::chrono::steady_clock::now();
+    store.Open(path);
+    double loadMs = SecondsSince(start) * 1e3;
+    printf("%-24s %14.1f ms (%zu records)\n", "load log", loadMs, store.LogRecords());
+    store.Close();
+    std::remove(path);
+    printf("bench-scores: checksum %llu\n", (unsigned long long)checksum);
+    return 0;
+}
+
+// Walking distance from (row, col) to the nearest cell holding itemType by a
+// fresh BFS, or -1; what every query would cost without the index.
+static int SearchNearestItem(const std::vector<std::vector<int>>& grid, int row, int col, int itemType,
+                             std::vector<int>& distance, std::vector<int>& queue) {
+    int rows = grid.size(), cols = grid[0].size();
+    distance.assign(rows * cols, -1);
+    queue.resize(rows * cols);
+    int head = 0, tail = 0;
+    distance[row * cols + col] = 0;
+    queue[tail++] = row * cols + col;
+    while (head < tail) {
+        int cell = queue[head++];
+        int r = cell / cols, c = cell % cols;
+        if (grid[r][c] == itemType)
+            return distance[cell];
+        for (int dir = 0; dir < 4; dir++) {
+            int dx, dy;
+            MoveDirectionStep(dir, dx, dy);
+            int nr = r + dy, nc = c + dx;
+            if (nr < 0 || nr >= rows || nc < 0 || nc >= cols || distance[nr * cols + nc] >= 0)
+                continue;
+            int value = grid[nr][nc];
+            if (value == WALL || value == OBSTACLE || value == HAZARD)
+                continue;
+            distance[nr * cols + nc] = distance[cell] + 1;
+            queue[tail++] = nr * cols + nc;
+        }
+    }
+    return -1;
+}
+
+// Time nearest-item lookups on square levels, the index against one BFS per
+// query, then patching the index as every item is eaten against rebuilding it.
+static int CommandBenchNearest(int argc, char** argv) {
+    int size = (std::max)(2, ArgInt(argc, argv, 2, GRID_ROWS));
+    int levelCount = (std::max)(1, ArgInt(argc, argv, 3, 1000));
+    int queries = (std::max)(1, ArgInt(argc, argv, 4, 1000000));
+    MazeRng rng(12345);
+    std::vector<std::vector<std::vector<int>>> levels;
+    std::vector<POINT> cells;   // x = level, y = row * size + col of a passable cell
+    for (int i = 0; i < levelCount; i++) {
+        levels.push_back(GenerateRandomMazeLevel(rng, size, size));
+        for (int r = 0; r < size; r++) {
+            for (int c = 0; c < size; c++) {
+                int value = levels[i][r][c];
+                if (value == PASSAGE || value == MINIDOT || value == COLLECTIBLE)
+                    cells.push_back({ (long)i, (long)(r * size + c) });
+            }
+        }
+    }
+    printf("bench-nearest: %d level(s) of %dx%d\n", levelCount, size, size);
+
+    std::vector<LevelItemIndex> indexes;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& grid : levels)
+        indexes.push_back(BuildLevelItemIndex(grid));
+    printf("%-24s %14.2f us per level\n", "build index", SecondsSince(start) * 1e6 / levelCount);
+
+    std::vector<POINT> picks(queries);
+    for (POINT& pick : picks)
+        pick = cells[rng.Below((uint32_t)cells.size())];
+    int itemTypes[2] = { MINIDOT, COLLECTIBLE };
+    long long indexSum = 0, searchSum = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < queries; i++) {
+        const LevelItemIndex& index = indexes[picks[i].x];
+        POINT item;
+        int distance = -1;
+        if (!QueryNearestItem(i % 2 ? index.collectibles : index.dots, picks[i].y / size, picks[i].y % size, item, distance))
+            distance = -1;
+        indexSum += distance;
+    }
+    double indexSeconds = SecondsSince(start);
+    std::vector<int> distance, queue;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < queries; i++) {
+        searchSum += SearchNearestItem(levels[picks[i].x], picks[i].y / size, picks[i].y % size, itemTypes[i % 2],
+            distance, queue);
+    }
+    double searchSeconds = SecondsSince(start);
+    printf("%-24s %14.1f ns per query\n", "query index", indexSeconds * 1e9 / queries);
+    printf("%-24s %14.1f ns per query\n", "query by BFS", searchSeconds * 1e9 / queries);
+
+    // Eat every item of every level in random order.
+    std::vector<std::vector<POINT>> eaten(levelCount);
+    size_t updates = 0;
+    for (int i = 0; i < levelCount; i++) {
+        for (int r = 0; r < size; r++)
+            for (int c = 0; c < size; c++)
+                if (levels[i][r][c] == MINIDOT || levels[i][r][c] == COLLECTIBLE)
+                    eaten[i].push_back({ (long)c, (long)r });
+        for (size_t k = eaten[i].size(); k > 1; k--)
+            std::swap(eaten[i][k - 1], eaten[i][rng.Below((uint32_t)k)]);
+        updates += eaten[i].size();
+    }
+    std::vector<std::vector<std::vector<int>>> grids = levels;
+    size_t patched = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < levelCount; i++) {
+        for (POINT cell : eaten[i]) {
+            int value = grids[i][cell.y][cell.x];
+            grids[i][cell.y][cell.x] = PASSAGE;
+            patched += UpdateLevelItemIndex(indexes[i], grids[i], cell.y, cell.x, value, PASSAGE);
+        }
+    }
+    double patchSeconds = SecondsSince(start);
+    // A rebuild costs the same whichever item went, so a few per level will do.
+    grids = levels;
+    size_t rebuilds = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < levelCount; i++) {
+        for (size_t k = 0; k < eaten[i].size() && k < 16; k++, rebuilds++) {
+            grids[i][eaten[i][k].y][eaten[i][k].x] = PASSAGE;
+            indexes[i] = BuildLevelItemIndex(grids[i]);
+        }
+    }
+    double rebuildSeconds = SecondsSince(start);
+    updates = (std::max)(updates, (size_t)1);
+    rebuilds = (std::max)(rebuilds, (size_t)1);
+    printf("%-24s %14.1f ns per item (%.1f cells)\n", "patch index", patchSeconds * 1e9 / updates,
+        (double)patched / updates);
+    printf("%-24s %14.1f ns per item (%d cells)\n", "rebuild index", rebuildSeconds * 1e9 / rebuilds, size * size);
+    if (indexSum != searchSum) {
+        printf("bench-nearest: index and BFS disagree (%lld vs %lld)\n", indexSum, searchSum);
+        return 1;
+    }
+    return 0;
+}
+
+// Line of sight the naive way: forget everything, then walk a Bresenham ray
+// from the viewer to every cell in range. Returns the cells visible.
+static int NaiveFieldOfView(const std::vector<std::vector<int>>& grid, POINT viewer, int radius,
+                            std::vector<char>& visible) {
+    int rows = grid.size(), cols = grid[0].size();
+    visible.assign(rows * cols, 0);
+    int count = 0;
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            int dx = c - viewer.x, dy = r - viewer.y;
+            if (dx * dx + dy * dy > radius * radius + radius)
+                continue;
+            // Step from the viewer towards the cell; any blocker before it hides it.
+            int x = viewer.x, y = viewer.y;
+            int sx = dx > 0 ? 1 : -1, sy = dy > 0 ? 1 : -1;
+            int ax = abs(dx), ay = abs(dy), error = ax - ay;
+            bool clear = true;
+            while (x != c || y != r) {
+                int value = grid[y][x];
+                if ((x != viewer.x || y != viewer.y) && (value == WALL || value == OBSTACLE)) {
+                    clear = false;
+                    break;
+                }
+                int twice = 2 * error;
+                if (twice > -ay) {
+                    error -= ay;
+                    x += sx;
+                }
+                if (twice < ax) {
+                    error += ax;
+                    y += sy;
+                }
+            }
+            if (clear) {
+                visible[r * cols + c] = 1;
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+// Walk a random player through one square level and time recomputing the
+// line of sight after every move: a ray per cell against shadowcasting.
+static int CommandBenchFov(int argc, char** argv) {
+    int size = (std::max)(2, ArgInt(argc, argv, 2, 256));
+    int radius = (std::max)(1, ArgInt(argc, argv, 3, FOV_RADIUS));
+    int moves = (std::max)(1, ArgInt(argc, argv, 4, 10000));
+    MazeRng rng(12345);
+    std::vector<std::vector<int>> grid = GenerateRandomMazeLevel(rng, size, size);
+    std::vector<POINT> path;
+    POINT player = { 0, 0 };
+    while ((int)path.size() < moves) {
+        int dx, dy;
+        MoveDirectionStep(rng.Below(4), dx, dy);
+        POINT next = { player.x + dx, player.y + dy };
+        if (next.x < 0 || next.x >= size || next.y < 0 || next.y >= size)
+            continue;
+        int value = grid[next.y][next.x];
+        if (value == WALL || value == OBSTACLE)
+            continue;
+        player = next;
+        path.push_back(player);
+    }
+    printf("bench-fov: %dx%d, radius %d, %d moves\n", size, size, radius, moves);
+
+    std::vector<char> visible;
+    long long naiveLit = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (POINT viewer : path)
+        naiveLit += NaiveFieldOfView(grid, viewer, radius, visible);
+    double naiveSeconds = SecondsSince(start);
+
+    FogOfWar fog = CreateFogOfWar(size, size, radius);
+    long long shadowLit = 0;
+    start = std::chrono::steady_clock::now();
+    for (POINT viewer : path)
+        shadowLit += (std::max)(0, UpdateFogOfWar(fog, grid, viewer));
+    double shadowSeconds = SecondsSince(start);
+    size_t explored = 0;
+    for (int r = 0; r < size; r++)
+        for (int c = 0; c < size; c++)
+            explored += fog.Explored(r, c);
+
+    printf("%-24s %14.1f us per move (%.1f cells lit)\n", "ray per cell", naiveSeconds * 1e6 / moves,
+        (double)naiveLit / moves);
+    printf("%-24s %14.1f us per move (%.1f cells lit)\n", "shadowcasting", shadowSeconds * 1e6 / moves,
+        (double)shadowLit / moves);
+    printf("bench-fov: %zu cells explored\n", explored);
+    return 0;
+}
+
+// First step of a shortest path from (row, col) to the player by a fresh
+// BFS, or -1; what each chaser would run without the shared flow field.
+static int SearchPlayer(const std::vector<std::vector<int>>& grid, int row, int col, POINT player,
+                        std::vector<int>& firstStep, std::vector<int>& queue) {
+    int rows = grid.size(), cols = grid[0].size();
+    firstStep.assign(rows * cols, -1);
+    queue.resize(rows * cols);
+    int head = 0, tail = 0;
+    int start = row * cols + col;
+    firstStep[start] = 4;
+    queue[tail++] = start;
+    while (head < tail) {
+        int cell = queue[head++];
+        int r = cell / cols, c = cell % cols;
+        if (r == player.y && c == player.x)
+            return firstStep[cell];
+        for (int dir = 0; dir < 4; dir++) {
+            int dx, dy;
+            MoveDirectionStep(dir, dx, dy);
+            int nr = r + dy, nc = c + dx;
+            if (nr < 0 || nr >= rows || nc < 0 || nc >= cols || firstStep[nr * cols + nc] >= 0)
+                continue;
+            if (grid[nr][nc] == WALL || grid[nr][nc] == OBSTACLE)
+                continue;
+            firstStep[nr * cols + nc] = cell == start ? dir : firstStep[cell];
+            queue[tail++] = nr * cols + nc;
+        }
+    }
+    return -1;
+}
+
+// Time entity ticks on one square level for growing entity counts, half of
+// them chasers: the shared flow field and the array passes, against one
+// path search per chaser (timed for one tick while that stays affordable).
+static int CommandBenchEntities(int argc, char** argv) {
+    int size = (std::max)(2, ArgInt(argc, argv, 2, 512));
+    int maxEntities = (std::max)(1, ArgInt(argc, argv, 3, 65536));
+    int ticks = (std::max)(1, ArgInt(argc, argv, 4, 200));
+    MazeRng rng(12345);
+    std::vector<std::vector<int>> grid = GenerateRandomMazeLevel(rng, size, size);
+    FlowField field;
+    BuildFlowField(field, grid);
+    printf("bench-entities: %dx%d, %d ticks per count, half chasers\n", size, size, ticks);
+    printf("%10s %12s %12s %12s %12s %16s\n", "entities", "flow us", "step us", "ns/entity", "hits/tick",
+        "per-chaser us");
+    std::vector<int> distance, queue;
+    for (int count = (std::min)(16, maxEntities);; count = (std::min)(count * 4, maxEntities)) {
+        EntityStore store;
+        MazeRng spawn(count);
+        SpawnEntities(store, field, count - count / 2, count / 2, 4, spawn);
+        POINT player = { 0, 0 };
+        double flowSeconds = 0, stepSeconds = 0;
+        size_t hits = 0;
+        for (int t = 0; t < ticks; t++) {
+            // The player wanders, so the flow has to follow it every tick.
+            for (int attempt = 0; attempt < 8; attempt++) {
+                int dx, dy;
+                MoveDirectionStep(rng.Below(4), dx, dy);
+                POINT next = { player.x + dx, player.y + dy };
+                if (next.x >= 0 && next.x < size && next.y >= 0 && next.y < size
+                    && grid[next.y][next.x] != WALL && grid[next.y][next.x] != OBSTACLE) {
+                    player = next;
+                    break;
+                }
+            }
+            auto start = std::chrono::steady_clock::now();
+            UpdateFlowField(field, player);
+            flowSeconds += SecondsSince(start);
+            start = std::chrono::steady_clock::now();
+            StepEntities(store, field);
+            hits += CountEntitiesAt(store, player);
+            stepSeconds += SecondsSince(start);
+        }
+        char perChaser[32] = "-";
+        if (count / 2 <= 1024) {
+            // What the chasers would cost each searching for the player.
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < store.Count(); i++) {
+                if (store.behavior[i] == ENTITY_CHASER)
+                    SearchPlayer(grid, store.y[i], store.x[i], player, distance, queue);
+            }
+            snprintf(perChaser, sizeof(perChaser), "%.1f", SecondsSince(start) * 1e6);
+        }
+        printf("%10d %12.1f %12.1f %12.2f %12.2f %16s\n", count, flowSeconds * 1e6 / ticks,
+            stepSeconds * 1e6 / ticks, stepSeconds * 1e9 / ticks / count, (double)hits / ticks, perChaser);
+        if (count == maxEntities)
+            break;
+    }
+    return 0;
+}
+
+// Fewest moves from (level, cell) to the exit of the last level by one BFS
+// over every cell of every level, following exits and teleporters; what a
+// route query would cost without the portal tables.
+static int SearchRoute(const std::vector<std::vector<std::vector<int>>>& levels, const TeleportNetwork& network,
+                       int level, POINT cell, std::vector<int>& distance, std::vector<int>& queue) {
+    int rows = network.rows, cols = network.cols, cells = rows * cols;
+    int levelCount = levels.size();
+    distance.assign((size_t)levelCount * cells, -1);
+    queue.resize((size_t)levelCount * cells);
+    int head = 0, tail = 0;
+    int first = level * cells + cell.y * cols + cell.x;
+    distance[first] = 0;
+    queue[tail++] = first;
+    while (head < tail) {
+        int state = queue[head++];
+        int l = state / cells, r = state % cells / cols, c = state % cols;
+        for (int dir = 0; dir < 4; dir++) {
+            int dx, dy;
+            MoveDirectionStep(dir, dx, dy);
+            int nr = r + dy, nc = c + dx;
+            if (nr < 0 || nr >= rows || nc < 0 || nc >= cols)
+                continue;
+            int value = levels[l][nr][nc];
+            if (value == WALL || value == OBSTACLE || value == HAZARD)
+                continue;
+            int next = l * cells + nr * cols + nc;
+            int toLevel;
+            POINT to;
+            if (nr == rows - 1 && nc == cols - 1) {
+                if (l == levelCount - 1)
+                    return distance[state] + 1;
+                next = (l + 1) * cells;
+            }
+            else if (value == TELEPORTER && TeleportDestination(network, l, { nc, nr }, toLevel, to)) {
+                next = toLevel * cells + to.y * cols + to.x;
+            }
+            if (distance[next] >= 0)
+                continue;
+            distance[next] = distance[state] + 1;
+            queue[tail++] = next;
+        }
+    }
+    return -1;
+}
+
+// Time route queries through a chain of square levels with teleporters: a
+// Dijkstra over the portal tables against one BFS over every cell of every
+// level, then the cost of building the tables and of rebuilding one level's.
+static int CommandBenchPortals(int argc, char** argv) {
+    int size = (std::max)(4, ArgInt(argc, argv, 2, 64));
+    int levelCount = (std::max)(1, ArgInt(argc, argv, 3, 16));
+    int queries = (std::max)(1, ArgInt(argc, argv, 4, 2000));
+    MazeRng rng(12345);
+    std::vector<std::vector<std::vector<int>>> levels;
+    for (int i = 0; i < levelCount; i++)
+        levels.push_back(GenerateRandomMazeLevel(rng, size, size));
+    PlaceTeleporters(levels, rng);
+    std::vector<POINT> cells;   // x = level, y = row * size + col of a cell the player can stand on
+    for (int i = 0; i < levelCount; i++) {
+        for (int r = 0; r < size; r++) {
+            for (int c = 0; c < size; c++) {
+                int value = levels[i][r][c];
+                if (value != WALL && value != OBSTACLE && value != HAZARD && !(r == size - 1 && c == size - 1))
+                    cells.push_back({ (long)i, (long)(r * size + c) });
+            }
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    TeleportNetwork network = BuildTeleportNetwork(levels);
+    double buildSeconds = SecondsSince(start);
+    printf("bench-portals: %d level(s) of %dx%d, %zu pads\n", levelCount, size, size, network.pads.size());
+    printf("%-24s %14.2f us per level\n", "build tables", buildSeconds * 1e6 / levelCount);
+
+    std::vector<POINT> picks(queries);
+    for (POINT& pick : picks)
+        pick = cells[rng.Below((uint32_t)cells.size())];
+    long long tableSum = 0, searchSum = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < queries; i++) {
+        POINT cell = { picks[i].y % size, picks[i].y / size };
+        tableSum += ShortestRouteSteps(network, levels, picks[i].x, cell);
+    }
+    double tableSeconds = SecondsSince(start);
+    std::vector<int> distance, queue;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < queries; i++) {
+        POINT cell = { picks[i].y % size, picks[i].y / size };
+        searchSum += SearchRoute(levels, network, picks[i].x, cell, distance, queue);
+    }
+    double searchSeconds = SecondsSince(start);
+    printf("%-24s %14.1f ns per query\n", "route by tables", tableSeconds * 1e9 / queries);
+    printf("%-24s %14.1f ns per query\n", "route by BFS", searchSeconds * 1e9 / queries);
+
+    // What a change to one level costs: its table alone, against all of them.
+    int rounds = (std::max)(levelCount, 64);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++)
+        UpdatePortalTable(network, levels, i % levelCount);
+    printf("%-24s %14.2f us per change\n", "rebuild one table", SecondsSince(start) * 1e6 / rounds);
+    printf("%-24s %14.2f us per change\n", "rebuild every table", buildSeconds * 1e6);
+    if (tableSum != searchSum) {
+        printf("bench-portals: tables and BFS disagree (%lld vs %lld)\n", tableSum, searchSum);
+        return 1;
+    }
+    return 0;
+}
+
+// One level carved and decorated through the vector code, before islands
+// are sealed.
+static std::vector<std::vector<int>> DecorateDynamicLevel(MazeRng& rng, int rows, int cols) {
+    while (true) {
+        auto mazeCells = InitializeMazeCells(rows, cols);
+        GenerateMazeDFS(mazeCells, 0, 0, rng);
+        auto grid = ConvertMazeToGrid(mazeCells);
+        if (IsPathValid(grid)) {
+            DecorateMaze(grid, rng);
+            grid[0][0] = PASSAGE;
+            grid[rows - 1][cols - 1] = PASSAGE;
+            return grid;
+        }
+    }
+}
+
+// One level through the vector code at any size, as GenerateRandomMazeLevel()
+// builds it for sizes without a FixedGrid.
+static std::vector<std::vector<int>> GenerateDynamicLevel(MazeRng& rng, int rows, int cols) {
+    auto grid = DecorateDynamicLevel(rng, rows, cols);
+    SealUnreachableIslands(grid);
+    return grid;
+}
+
+// Generate the same seeds through the vector code and a FixedGrid<Size, Size>
+// and check both give identical levels. Returns false on a mismatch.
+template <int Size>
+static bool BenchGridSize(int levelCount) {
+    uint64_t dynamicHash = HASH_SEED, fixedHash = HASH_SEED;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < levelCount; i++) {
+        MazeRng rng(i + 1);
+        std::vector<std::vector<int>> grid = GenerateDynamicLevel(rng, Size, Size);
+        for (const auto& row : grid)
+            for (int value : row)
+                dynamicHash = HashCombine(dynamicHash, &value, sizeof(value));
+    }
+    double dynamicSeconds = SecondsSince(start);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < levelCount; i++) {
+        MazeRng rng(i + 1);
+        FixedGrid<Size, Size> grid;
+        GenerateRandomMazeLevel(rng, grid);
+        for (uint8_t cell : grid.cells.items) {
+            int value = cell;
+            fixedHash = HashCombine(fixedHash, &value, sizeof(value));
+        }
+    }
+    double fixedSeconds = SecondsSince(start);
+    char label[32];
+    snprintf(label, sizeof(label), "%dx%d vector", Size, Size);
+    printf("%-24s %14.1f ns per level\n", label, dynamicSeconds * 1e9 / levelCount);
+    snprintf(label, sizeof(label), "%dx%d fixed", Size, Size);
+    printf("%-24s %14.1f ns per level\n", label, fixedSeconds * 1e9 / levelCount);
+    if (dynamicHash != fixedHash) {
+        printf("bench-grids: %dx%d levels differ\n", Size, Size);
+        return false;
+    }
+    return true;
+}
+
+// Time level generation on nested vectors against the fixed-size grids, at
+// the shipped 10x10 and at 32x32.
+static int CommandBenchGrids(int argc, char** argv) {
+    int levelCount = (std::max)(1, ArgInt(argc, argv, 2, 20000));
+    printf("bench-grids: %d level(s) per size, same seeds both ways\n", levelCount);
+    bool same = BenchGridSize<10>(levelCount);
+    same = BenchGridSize<32>((std::max)(1, levelCount / 10)) && same;
+    return same ? 0 : 1;
+}
+
+// Check every baked campaign against the vector generator, level by level
+// and cell by cell, and time a baked load against generating the levels.
+static int CommandVerifyBaked(int argc, char** argv) {
+    int repeat = (std::max)(1, ArgInt(argc, argv, 2, 2000));
+    int mismatches = 0;
+    for (int i = 0; i < BAKED_CAMPAIGN_COUNT; i++) {
+        const BakedCampaign& campaign = GetBakedCampaign(i);
+        MazeRng rng(campaign.seed);
+        int differing = 0;
+        for (int level = 0; level < TOTAL_LEVELS; level++) {
+            if (BakedLevelGrid(campaign, level) != GenerateDynamicLevel(rng, GRID_ROWS, GRID_COLS))
+                differing++;
+        }
+        printf("verify-baked: campaign %d (seed %u): %s\n", i, campaign.seed,
+            differing ? "MISMATCH" : "all levels match");
+        mismatches += differing;
+    }
+
+    // What NewGame() spends on the levels of a campaign seed either way.
+    size_t cells = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int n = 0; n < repeat; n++) {
+        const BakedCampaign* campaign = FindBakedCampaign(GetBakedCampaign(n % BAKED_CAMPAIGN_COUNT).seed);
+        for (int level = 0; level < TOTAL_LEVELS; level++)
+            cells += BakedLevelGrid(*campaign, level).size();
+    }
+    double bakedSeconds = SecondsSince(start);
+    start = std::chrono::steady_clock::now();
+    for (int n = 0; n < repeat; n++) {
+        MazeRng rng(GetBakedCampaign(n % BAKED_CAMPAIGN_COUNT).seed);
+        for (int level = 0; level < TOTAL_LEVELS; level++)
+            cells += GenerateRandomMazeLevel(rng).size();
+    }
+    double generateSeconds = SecondsSince(start);
+    printf("%-24s %14.1f ns per campaign\n", "load baked", bakedSeconds * 1e9 / repeat);
+    printf("%-24s %14.1f ns per campaign\n", "generate", generateSeconds * 1e9 / repeat);
+    return mismatches || !cells ? 1 : 0;
+}
+
+// Encode generated levels (pads placed, as saves hold them), check they
+// decode to the same cells, and time whole-level encode and decode and
+// single row-block decodes.
+static int CommandBenchCodec(int argc, char** argv) {
+    int size = (std::max)(2, ArgInt(argc, argv, 2, GRID_ROWS));
+    int levelCount = (std::max)(1, ArgInt(argc, argv, 3, 20000));
+
+    MazeRng rng(1);
+    std::vector<std::vector<std::vector<int>>> levels;
+    for (int i = 0; i < levelCount; i++)
+        levels.push_back(GenerateRandomMazeLevel(rng, size, size));
+    PlaceTeleporters(levels, rng);
+    size_t levelCells = (size_t)size * size;
+    std::vector<uint8_t> cells(levelCells * levelCount);
+    uint64_t valueCounts[LEVEL_CODEC_VALUES] = {};
+    for (int i = 0; i < levelCount; i++) {
+        for (int r = 0; r < size; r++) {
+            for (int c = 0; c < size; c++) {
+                cells[i * levelCells + r * size + c] = (uint8_t)levels[i][r][c];
+                valueCounts[levels[i][r][c]]++;
+            }
+        }
+    }
+    // Order-0 entropy of the cell values, for comparison.
+    double entropy = 0;
+    for (uint64_t count : valueCounts) {
+        if (count) {
+            double p = (double)count / cells.size();
+            entropy -= p * std::log2(p);
+        }
+    }
+
+    std::vector<std::vector<unsigned char>> encoded(levelCount);
+    size_t encodedBytes = 0;
+    for (int i = 0; i < levelCount; i++) {
+        EncodeLevelCells(&cells[i * levelCells], size, size, encoded[i]);
+        encodedBytes += encoded[i].size();
+    }
+    std::vector<uint8_t> decoded(levelCells);
+    int mismatches = 0;
+    for (int i = 0; i < levelCount; i++) {
+        EncodedLevelView view;
+        if (!view.Open(encoded[i].data(), encoded[i].size()) || !view.DecodeAll(decoded.data())
+            || memcmp(decoded.data(), &cells[i * levelCells], levelCells) != 0)
+            mismatches++;
+    }
+    std::vector<std::vector<int>> shared;
+    std::string shareCode = LevelToShareCode(levels[0]);
+    if (!LevelFromShareCode(shareCode, shared) || shared != levels[0])
+        mismatches++;
+
+    // Enough passes for at least 64M cells each way.
+    int passes = (int)(std::max)((size_t)1, ((size_t)64 << 20) / cells.size());
+    std::vector<unsigned char> scratch;
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; pass++)
+        for (int i = 0; i < levelCount; i++)
+            EncodeLevelCells(&cells[i * levelCells], size, size, scratch);
+    double encodeSeconds = SecondsSince(start);
+    start = std::chrono::steady_clock::now();
+    uint64_t checksum = 0;
+    for (int pass = 0; pass < passes; pass++) {
+        for (int i = 0; i < levelCount; i++) {
+            EncodedLevelView view;
+            view.Open(encoded[i].data(), encoded[i].size());
+            view.DecodeAll(decoded.data());
+            checksum += decoded[levelCells - 2];
+        }
+    }
+    double decodeSeconds = SecondsSince(start);
+
+    // One random row block of a random level per query.
+    int queries = 200000;
+    start = std::chrono::steady_clock::now();
+    for (int q = 0; q < queries; q++) {
+        const std::vector<unsigned char>& level = encoded[rng.Below(levelCount)];
+        EncodedLevelView view;
+        view.Open(level.data(), level.size());
+        view.DecodeBlock(rng.Below(view.BlockCount()), decoded.data());
+        checksum += decoded[0];
+    }
+    double blockSeconds = SecondsSince(start);
+
+    double megaCells = (double)cells.size() * passes / 1e6;
+    printf("bench-codec: %d level(s) of %dx%d, %s, checksum %llu\n", levelCount, size, size,
+        mismatches ? "MISMATCH" : "all decode to the same cells", (unsigned long long)checksum);
+    printf("%-24s %14.1f bytes per level\n", "encoded", (double)encodedBytes / levelCount);
+    printf("%-24s %14.3f bits per cell\n", "encoded", encodedBytes * 8.0 / cells.size());
+    printf("%-24s %14.3f bits per cell\n", "order-0 entropy", entropy);
+    printf("%-24s %14.1f M cells per second\n", "encode", megaCells / encodeSeconds);
+    printf("%-24s %14.1f M cells per second\n", "decode", megaCells / decodeSeconds);
+    printf("%-24s %14.1f ns per block\n", "decode one row block", blockSeconds * 1e9 / queries);
+    if (shareCode.size() <= 80)
+        printf("share code of level 0:  %s\n", shareCode.c_str());
+    return mismatches ? 1 : 0;
+}
+
+// Generate a level pack with the pipeline, report throughput and how busy
+// each stage was, then read the pack back: chunk checksums, every level
+// decodes, and a sample of levels regenerated from their seeds match.
+static int CommandGenerateLevels(int argc, char** argv) {
+    if (argc < 3) {
+        printf("usage: MazeTool generate-levels <out.lvp> [levels] [size] [threads] [firstSeed]\n");
+        return 1;
+    }
+    LevelPackOptions options;
+    options.path = argv[2];
+    options.levels = (uint32_t)(std::max)(1, ArgInt(argc, argv, 3, 100000));
+    options.rows = options.cols = (std::max)(2, ArgInt(argc, argv, 4, GRID_ROWS));
+    options.threads = ArgInt(argc, argv, 5, 0);
+    options.firstSeed = (uint32_t)ArgInt(argc, argv, 6, 1);
+    LevelPackStats stats;
+    if (!GenerateLevelPack(options, stats)) {
+        printf("generate-levels: could not write %s\n", options.path.c_str());
+        return 1;
+    }
+    double levels = (double)(std::max)((uint64_t)1, stats.levels);
+    printf("generate-levels: %llu level(s) of %dx%d in %.2f s, %.0f levels per second\n",
+        (unsigned long long)stats.levels, options.rows, options.cols, stats.seconds, stats.LevelsPerSecond());
+    printf("  %llu rejected, %llu chunk(s), %llu bytes (%.1f bytes per level encoded)\n",
+        (unsigned long long)stats.rejected, (unsigned long long)stats.chunks,
+        (unsigned long long)stats.fileBytes, stats.encodedBytes / levels);
+    printf("  per level: %.1f solution cells, %.1f collectibles, %.1f hazards, %.1f obstacles\n",
+        stats.solutionCells / levels, stats.cellCounts[COLLECTIBLE] / levels,
+        stats.cellCounts[HAZARD] / levels, stats.cellCounts[OBSTACLE] / levels);
+    printf("  peak levels in flight: %zu (window %zu)\n", stats.peakInFlight, stats.window);
+    printf("  %-10s %8s %9s %9s %9s\n", "stage", "threads", "busy", "starved", "blocked");
+    const char* names[STAGE_COUNT] = { "generate", "validate", "write" };
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        const PipelineStageStats& stage = stats.stages[s];
+        double threadSeconds = (std::max)(1e-9, stats.seconds * stage.threads);
+        printf("  %-10s %8d %8.1f%% %8.1f%% %8.1f%%\n", names[s], stage.threads,
+            100 * stage.Utilization(stats.seconds), 100 * stage.starvedSeconds / threadSeconds,
+            100 * stage.blockedSeconds / threadSeconds);
+    }
+
+    LevelPackView pack;
+    if (!pack.Open(options.path)) {
+        printf("verify: %s does not open as a level pack\n", options.path.c_str());
+        return 1;
+    }
+    int badChunks = 0, badLevels = 0, checked = 0, mismatches = 0;
+    for (uint32_t c = 0; c < pack.ChunkCount(); c++)
+        badChunks += !pack.VerifyChunk(c);
+    std::vector<std::vector<int>> grid;
+    for (uint32_t i = 0; i < pack.LevelCount(); i++) {
+        if (!pack.LevelGrid(i, grid)) {
+            badLevels++;
+            continue;
+        }
+        if (i % 997 == 0) {
+            MazeRng rng(pack.Entry(i).seed);
+            mismatches += grid != GenerateRandomMazeLevel(rng, options.rows, options.cols);
+            checked++;
+        }
+    }
+    printf("verify: %d bad chunk(s), %d level(s) failed to decode, %d of %d regenerated level(s) differ\n",
+        badChunks, badLevels, mismatches, checked);
+    return badChunks || badLevels || mismatches || pack.LevelCount() != stats.levels ? 1 : 0;
+}
+
+// Mark the cells of a bordered layout reachable from from, never entering skip
+// or moving between edgeA and edgeB: one what-if check.
+static void FloodWhatIf(const std::vector<uint8_t>& open, int stride, int from, int skip, int edgeA, int edgeB,
+                        std::vector<int>& mark, int stamp, std::vector<int>& queue) {
+    const int offsets[4] = { -stride, 1, stride, -1 };
+    int head = 0, tail = 0;
+    mark[from] = stamp;
+    queue[tail++] = from;
+    while (head < tail) {
+        int cell = queue[head++];
+        for (int d = 0; d < 4; d++) {
+            int n = cell + offsets[d];
+            if (!open[n] || n == skip || mark[n] == stamp)
+                continue;
+            if ((cell == edgeA && n == edgeB) || (cell == edgeB && n == edgeA))
+                continue;
+            mark[n] = stamp;
+            queue[tail++] = n;
+        }
+    }
+}
+
+// Check every cell and move of the analysis by blocking it and flooding again.
+// Returns the number of disagreements.
+static int CheckChokepoints(const ChokepointMap& map, const std::vector<uint8_t>& open, std::vector<int>& mark,
+                            int& stamp, std::vector<int>& queue) {
+    const int offsets[4] = { -map.stride, 1, map.stride, -1 };
+    int errors = 0;
+    for (int r = 0; r < map.rows; r++) {
+        for (int c = 0; c < map.cols; c++) {
+            int v = map.Cell(r, c);
+            if (!open[v])
+                continue;
+            // Blocking v splits its open neighbours into pieces; a cell lies
+            // in one block per piece.
+            int first = stamp + 1, pieces = 0, degree = 0, blocks[4], blockCount = 0;
+            for (int d = 0; d < 4; d++) {
+                int n = v + offsets[d];
+                if (!open[n])
+                    continue;
+                degree++;
+                int block = map.EdgeBlock(r, c, d);
+                if (std::find(blocks, blocks + blockCount, block) == blocks + blockCount)
+                    blocks[blockCount++] = block;
+                if (mark[n] < first) {
+                    FloodWhatIf(open, map.stride, n, v, -1, -1, mark, ++stamp, queue);
+                    pieces++;
+                }
+            }
+            if ((pieces > 1) != map.IsArticulation(r, c) || (degree > 0 && blockCount != pieces))
+                errors++;
+            // A bridge is a move whose two cells fall apart without it.
+            for (int d = 0; d < 4; d++) {
+                int n = v + offsets[d];
+                if (!open[n])
+                    continue;
+                FloodWhatIf(open, map.stride, v, -1, v, n, mark, ++stamp, queue);
+                if ((mark[n] != stamp) != map.IsBridge(r, c, d))
+                    errors++;
+            }
+            if (map.connected && v != map.start && v != map.exit) {
+                FloodWhatIf(open, map.stride, map.start, v, -1, -1, mark, ++stamp, queue);
+                if ((mark[map.exit] != stamp) != map.IsRouteCut(r, c))
+                    errors++;
+            }
+        }
+    }
+    return errors;
+}
+
+// Analyze decorated square levels, check the analysis against what-if floods
+// that block each cell and move in turn, and time it against finding the
+// route cuts by one flood per cell. A single bigSize level shows the DFS
+// copes with long corridors.
+static int CommandBenchChokepoints(int argc, char** argv) {
+    int size = (std::max)(2, ArgInt(argc, argv, 2, 32));
+    int levelCount = (std::max)(1, ArgInt(argc, argv, 3, 200));
+    int bigSize = (std::max)(2, ArgInt(argc, argv, 4, 1024));
+    // Walls and obstacles block, and hazards too for the hazard-free routes.
+    const unsigned blockSets[2] = { CHOKE_BLOCKING_CELLS, CHOKE_BLOCKING_CELLS | (1u << HAZARD) };
+    const char* setNames[2] = { "passable", "hazard-free" };
+    printf("bench-chokepoints: %d level(s) of %dx%d\n", levelCount, size, size);
+    printf("%-12s %12s %10s %10s %10s %10s %8s\n", "graph", "articulation", "bridges", "blocks", "route cuts",
+        "connected", "errors");
+    MazeRng rng(12345);
+    std::vector<std::vector<std::vector<int>>> levels;
+    for (int i = 0; i < levelCount; i++)
+        levels.push_back(GenerateRandomMazeLevel(rng, size, size));
+
+    int stride = size + 2;
+    std::vector<int> mark((size + 2) * stride, 0), queue((size + 2) * stride);
+    int stamp = 0, totalErrors = 0;
+    double analyzeSeconds = 0, whatIfSeconds = 0;
+    long long whatIfCuts = 0, analyzedCuts = 0;
+    for (int s = 0; s < 2; s++) {
+        long long articulation = 0, bridges = 0, blocks = 0, cuts = 0, connected = 0;
+        int errors = 0;
+        for (const auto& grid : levels) {
+            auto start = std::chrono::steady_clock::now();
+            ChokepointMap map = AnalyzeChokepoints(grid, blockSets[s]);
+            analyzeSeconds += SecondsSince(start);
+            std::vector<uint8_t> open((size + 2) * stride, 0);
+            for (int r = 0; r < size; r++)
+                for (int c = 0; c < size; c++)
+                    open[map.Cell(r, c)] = !((blockSets[s] >> grid[r][c]) & 1);
+            errors += CheckChokepoints(map, open, mark, stamp, queue);
+            articulation += map.articulationPoints;
+            bridges += map.bridges;
+            blocks += map.blocks;
+            cuts += map.routeCuts;
+            connected += map.connected;
+            analyzedCuts += map.routeCuts;
+
+            // Route cuts the way decoration would find them without the
+            // analysis: block each cell in turn and flood from the start.
+            start = std::chrono::steady_clock::now();
+            if (map.connected) {
+                for (int r = 0; r < size; r++) {
+                    for (int c = 0; c < size; c++) {
+                        int v = map.Cell(r, c);
+                        if (!open[v] || v == map.start || v == map.exit)
+                            continue;
+                        FloodWhatIf(open, stride, map.start, v, -1, -1, mark, ++stamp, queue);
+                        whatIfCuts += mark[map.exit] != stamp;
+                    }
+                }
+            }
+            whatIfSeconds += SecondsSince(start);
+        }
+        printf("%-12s %12.1f %10.1f %10.1f %10.1f %9.1f%% %8d\n", setNames[s], (double)articulation / levelCount,
+            (double)bridges / levelCount, (double)blocks / levelCount, (double)cuts / levelCount,
+            100.0 * connected / levelCount, errors);
+        totalErrors += errors;
+    }
+    printf("%-24s %14.2f us per level\n", "analysis", analyzeSeconds * 1e6 / (2 * levelCount));
+    printf("%-24s %14.2f us per level\n", "route cuts by what-if", whatIfSeconds * 1e6 / (2 * levelCount));
+
+    MazeRng bigRng(777);
+    auto big = GenerateRandomMazeLevel(bigRng, bigSize, bigSize);
+    // A serpentine corridor: one DFS path through every other row.
+    auto corridor = std::vector<std::vector<int>>(bigSize, std::vector<int>(bigSize, MINIDOT));
+    for (int r = 1; r + 1 < bigSize; r += 2)
+        for (int c = 0; c < bigSize; c++)
+            if (c != ((r / 2) % 2 ? 0 : bigSize - 1))
+                corridor[r][c] = WALL;
+    for (int k = 0; k < 2; k++) {
+        auto start = std::chrono::steady_clock::now();
+        ChokepointMap map = AnalyzeChokepoints(k ? corridor : big);
+        double seconds = SecondsSince(start);
+        printf("%-24s %14.2f ms, %.0f M cells/s, %d route cuts\n", k ? "serpentine level" : "large level",
+            seconds * 1e3, bigSize * (double)bigSize / seconds / 1e6, map.routeCuts);
+    }
+
+    if (totalErrors || whatIfCuts != analyzedCuts) {
+        printf("bench-chokepoints: analysis and what-if floods disagree (%d errors, %lld vs %lld route cuts)\n",
+            totalErrors, analyzedCuts, whatIfCuts);
+        return 1;
+    }
+    return 0;
+}
+
+// Report what SealUnreachableIslands() leaves on each level of a new game,
+// then over many square levels: how often decoration seals cells off, what
+// the pass costs next to carving and decorating, and that every walkable
+// cell is reachable afterwards without stepping on a hazard.
+static int CommandBenchReach(int argc, char** argv) {
+    uint32_t seed = (uint32_t)ArgInt(argc, argv, 2, 1);
+    int size = (std::max)(2, ArgInt(argc, argv, 3, GRID_ROWS));
+    int levelCount = (std::max)(1, ArgInt(argc, argv, 4, 20000));
+
+    printf("bench-reach: levels of seed %u\n", seed);
+    printf("%6s %12s %10s %8s %8s %12s\n", "level", "collectibles", "minidots", "hazards", "islands", "sealed items");
+    MazeRng campaignRng(seed);
+    for (int level = 0; level < TOTAL_LEVELS; level++) {
+        auto grid = DecorateDynamicLevel(campaignRng, GRID_ROWS, GRID_COLS);
+        LevelReach reach = SealUnreachableIslands(grid);
+        printf("%6d %12d %10d %8d %8d %12d\n", level + 1, reach.collectibles, reach.minidots, reach.hazards,
+            reach.islands, reach.sealedItems);
+    }
+
+    MazeRng rng(12345);
+    std::vector<std::vector<std::vector<int>>> levels;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < levelCount; i++)
+        levels.push_back(DecorateDynamicLevel(rng, size, size));
+    double decorateSeconds = SecondsSince(start);
+    long long islandLevels = 0, islands = 0, sealedItems = 0, items = 0;
+    std::vector<LevelReach> reaches(levelCount);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < levelCount; i++)
+        reaches[i] = SealUnreachableIslands(levels[i]);
+    double sealSeconds = SecondsSince(start);
+
+    int stride = size + 2, unreachable = 0;
+    std::vector<uint8_t> open((size + 2) * stride);
+    std::vector<int> mark(open.size(), 0), queue(open.size());
+    for (int i = 0; i < levelCount; i++) {
+        const LevelReach& reach = reaches[i];
+        islandLevels += reach.islands > 0;
+        islands += reach.islands;
+        sealedItems += reach.sealedItems;
+        items += reach.collectibles + reach.minidots;
+        int walkable = 0;
+        for (int r = 0; r < size; r++) {
+            for (int c = 0; c < size; c++) {
+                int value = levels[i][r][c];
+                bool passable = value != WALL && value != OBSTACLE && value != HAZARD;
+                open[(r + 1) * stride + c + 1] = passable;
+                walkable += passable;
+            }
+        }
+        FloodWhatIf(open, stride, stride + 1, -1, -1, -1, mark, i + 1, queue);
+        int reached = (int)std::count(mark.begin(), mark.end(), i + 1);
+        unreachable += walkable - reached;
+    }
+    printf("bench-reach: %d level(s) of %dx%d\n", levelCount, size, size);
+    printf("%-24s %13.2f%%\n", "levels with islands", 100.0 * islandLevels / levelCount);
+    printf("%-24s %14.3f per level\n", "islands", (double)islands / levelCount);
+    printf("%-24s %14.3f per level (%.1f reachable)\n", "sealed items", (double)sealedItems / levelCount,
+        (double)items / levelCount);
+    printf("%-24s %14.1f ns per level\n", "carve and decorate", decorateSeconds * 1e9 / levelCount);
+    printf("%-24s %14.1f ns per level\n", "seal islands", sealSeconds * 1e9 / levelCount);
+    if (unreachable) {
+        printf("bench-reach: %d walkable cell(s) left unreachable without crossing a hazard\n", unreachable);
+        return 1;
+    }
+    return 0;
+}
+
+// Measure what a TRACE_SCOPE costs with tracing off and on, and trace a few
+// new games on worker threads; with out.json given, the trace of those games
+// is written there for Perfetto.
+static int CommandBenchTrace(int argc, char** argv) {
+    int spans = (std::max)(1, ArgInt(argc, argv, 2, 10000000));
+    const char* outPath = argc >= 4 ? argv[3] : nullptr;
+    volatile int sink = 0;
+    auto runSpans = [&]() {
+        for (int i = 0; i < spans; i++) {
+            TRACE_SCOPE("BenchSpan");
+            sink = sink + 1;
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < spans; i++)
+        sink = sink + 1;
+    double baseSeconds = SecondsSince(start);
+    EnableTracing(false);
+    start = std::chrono::steady_clock::now();
+    runSpans();
+    double offSeconds = SecondsSince(start);
+
+    // Traced workload: new games with targeted levels on a few threads.
+    SetTraceThreadName("main");
+    EnableTracing(true);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; t++) {
+        workers.emplace_back([t]() {
+            std::string name = "worker " + std::to_string(t + 1);
+            SetTraceThreadName(name.c_str());
+            GameSession session;
+            session.generator = LEVELGEN_TARGETED;
+            session.NewGame(1000 + t);
+        });
+    }
+    for (auto& worker : workers)
+        worker.join();
+    bool written = outPath && WriteChromeTrace(outPath);
+
+    start = std::chrono::steady_clock::now();
+    runSpans();
+    double onSeconds = SecondsSince(start);
+    EnableTracing(false);
+
+    printf("bench-trace: %d span(s)%s\n", spans, MAZE_TRACING ? "" : ", tracing compiled out");
+    printf("%-24s %14.2f ns per span\n", "empty loop", baseSeconds * 1e9 / spans);
+    printf("%-24s %14.2f ns per span\n", "tracing off", offSeconds * 1e9 / spans);
+    printf("%-24s %14.2f ns per span\n", "tracing on", onSeconds * 1e9 / spans);
+    if (outPath && !written) {
+        printf("bench-trace: could not write %s\n", outPath);
+        return 1;
+    }
+    if (written)
+        printf("bench-trace: trace of 4 new games written to %s\n", outPath);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && strcmp(argv[1], "replay") == 0)
+        return CommandReplay(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "bench-sessions") == 0)
+        return CommandBenchSessions(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "bots") == 0)
+        return CommandBots(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "search-levels") == 0)
+        return CommandSearchLevels(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "mix") == 0)
+        return CommandMix(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "bench-mixer") == 0)
+        return CommandBenchMixer(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "bench-audio") == 0)
+        return CommandBenchAudio(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "pack") == 0)
+        return CommandPack(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "pack-list") == 0)
+        return CommandPackList(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "bench-scores") == 0)
+        return CommandBenchScores(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "bench-nearest") == 0)
+        return CommandBenchNearest(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "bench-fov") == 0)
+        return CommandBenchFov(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "bench-entities") == 0)
+        return CommandBenchEntities(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "bench-portals") == 0)
+        return CommandBenchPortals(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "bench-grids") == 0)
+        return CommandBenchGrids(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "verify-baked") == 0)
+        return CommandVerifyBaked(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "bench-codec") == 0)
+        return CommandBenchCodec(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "generate-levels") == 0)
+        return CommandGenerateLevels(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "bench-chokepoints") == 0)
+        return CommandBenchChokepoints(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "bench-reach") == 0)
+        return CommandBenchReach(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "bench-trace") == 0)
+        return CommandBenchTrace(argc, argv);
+    printf("usage:\n");
+    printf("  MazeTool replay <file.rec> [repeat]\n");
+    printf("  MazeTool bench-sessions [sessions] [steps] [threads]\n");
+    printf("  MazeTool bots [shortest|greedy|random|all] [games] [threads] [firstSeed] [classic|targeted]\n");
+    printf("  MazeTool search-levels [size] [candidates] [threads] [levels] [cuts]\n");
+    printf("  MazeTool mix <out.wav> <in.wav>...\n");
+    printf("  MazeTool bench-mixer [maxVoices] [seconds]\n");
+    printf("  MazeTool bench-audio [commands] [burst]\n");
+    printf("  MazeTool pack <out.pak> <file>...\n");
+    printf("  MazeTool pack-list <file.pak> [verify]\n");
+    printf("  MazeTool bench-scores [entries] [queries]\n");
+    printf("  MazeTool bench-nearest [size] [levels] [queries]\n");
+    printf("  MazeTool bench-fov [size] [radius] [moves]\n");
+    printf("  MazeTool bench-entities [size] [maxEntities] [ticks]\n");
+    printf("  MazeTool bench-portals [size] [levels] [queries]\n");
+    printf("  MazeTool bench-grids [levels]\n");
+    printf("  MazeTool verify-baked [repeat]\n");
+    printf("  MazeTool bench-codec [size] [levels]\n");
+    printf("  MazeTool generate-levels <out.lvp> [levels] [size] [threads] [firstSeed]\n");
+    printf("  MazeTool bench-chokepoints [size] [levels] [bigSize]\n");
+    printf("  MazeTool bench-reach [seed] [size] [levels]\n");
+    printf("  MazeTool bench-trace [spans] [out.json]\n");
+    return 2;
+}
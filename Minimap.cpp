@@ -0,0 +1,83 @@
+#include "Minimap.h"
+
+// Add (sign = 1) or remove (sign = -1) one cell value from a node.
+static void AccumulateCell(OccupancyNode& node, int value, int sign) {
+    node.cells += sign;
+    switch (value) {
+    case WALL:
+    case OBSTACLE:
+        node.wall += sign;
+        break;
+    case HAZARD:
+        node.hazard += sign;
+        break;
+    case COLLECTIBLE:
+    case MINIDOT:
+        node.collectible += sign;
+        node.passable += sign;
+        break;
+    default:
+        node.passable += sign;
+        break;
+    }
+}
+
+OccupancyPyramid BuildOccupancyPyramid(const std::vector<std::vector<int>>& grid) {
+    OccupancyPyramid pyramid;
+    if (grid.empty() || grid[0].empty())
+        return pyramid;
+
+    // Level 0: one node per cell.
+    PyramidLevel base;
+    base.rows = grid.size();
+    base.cols = grid[0].size();
+    base.nodes.resize(base.rows * base.cols);
+    for (int r = 0; r < base.rows; r++)
+        for (int c = 0; c < base.cols; c++)
+            AccumulateCell(base.nodes[r * base.cols + c], grid[r][c], 1);
+    pyramid.levels.push_back(base);
+
+    // Each further level sums 2x2 blocks of the previous one.
+    while (pyramid.levels.back().rows > 1 || pyramid.levels.back().cols > 1) {
+        const PyramidLevel& fine = pyramid.levels.back();
+        PyramidLevel coarse;
+        coarse.rows = (fine.rows + 1) / 2;
+        coarse.cols = (fine.cols + 1) / 2;
+        coarse.nodes.resize(coarse.rows * coarse.cols);
+        for (int r = 0; r < fine.rows; r++) {
+            for (int c = 0; c < fine.cols; c++) {
+                const OccupancyNode& src = fine.nodes[r * fine.cols + c];
+                OccupancyNode& dst = coarse.nodes[(r / 2) * coarse.cols + (c / 2)];
+                dst.cells += src.cells;
+                dst.wall += src.wall;
+                dst.passable += src.passable;
+                dst.hazard += src.hazard;
+                dst.collectible += src.collectible;
+            }
+        }
+        pyramid.levels.push_back(coarse);
+    }
+    return pyramid;
+}
+
+void UpdateOccupancyPyramid(OccupancyPyramid& pyramid, int row, int col, int oldValue, int newValue) {
+    if (oldValue == newValue)
+        return;
+    for (PyramidLevel& level : pyramid.levels) {
+        OccupancyNode& node = level.nodes[row * level.cols + col];
+        AccumulateCell(node, oldValue, -1);
+        AccumulateCell(node, newValue, 1);
+        row /= 2;
+        col /= 2;
+    }
+}
+
+int SelectPyramidLevel(const OccupancyPyramid& pyramid, int pixelWidth, int pixelHeight) {
+    int count = pyramid.levels.size();
+    for (int k = 0; k < count; k++) {
+        const PyramidLevel& level = pyramid.levels[k];
+        if (level.cols <= pixelWidth && level.rows <= pixelHeight)
+            return k;
+    }
+    return count - 1;
+}
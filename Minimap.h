@@ -0,0 +1,40 @@
+// Minimap.h : level-of-detail occupancy pyramid used to draw the minimap
+//
+
+#pragma once
+
+#include "MazeGame.h"
+
+// Cell counts for one pyramid node. A node at pyramid level k covers a
+// 2^k x 2^k block of level cells (clipped at the right and bottom edges).
+struct OccupancyNode {
+    int cells = 0;        // number of level cells under this node
+    int wall = 0;         // WALL and OBSTACLE cells
+    int passable = 0;     // PASSAGE, MINIDOT and COLLECTIBLE cells
+    int hazard = 0;       // HAZARD cells
+    int collectible = 0;  // MINIDOT and COLLECTIBLE cells
+};
+
+// One level of the pyramid, stored row-major.
+struct PyramidLevel {
+    int rows = 0;
+    int cols = 0;
+    std::vector<OccupancyNode> nodes;
+};
+
+// levels[0] matches the grid one node per cell; every following level is a
+// 2x2 reduction of the one before it, down to a single node.
+struct OccupancyPyramid {
+    std::vector<PyramidLevel> levels;
+};
+
+// Build the full pyramid for a level grid.
+OccupancyPyramid BuildOccupancyPyramid(const std::vector<std::vector<int>>& grid);
+
+// Patch the pyramid after one cell changed from oldValue to newValue.
+// Only the single node above the cell on every level is touched.
+void UpdateOccupancyPyramid(OccupancyPyramid& pyramid, int row, int col, int oldValue, int newValue);
+
+// Pick the finest pyramid level that fits in the given pixel size
+// (at least one pixel per node).
+int SelectPyramidLevel(const OccupancyPyramid& pyramid, int pixelWidth, int pixelHeight);
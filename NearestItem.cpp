@@ -0,0 +1,204 @@
+#include "NearestItem.h"
+#include <algorithm>
+
+// Owner of the cells being re-flooded while an item's region is patched.
+static const int PATCHING = -2;
+
+// A teleporter pad blocks too: stepping onto a linked one leaves the cell.
+static bool Blocks(int value) {
+    return value == WALL || value == OBSTACLE || value == HAZARD || value == TELEPORTER;
+}
+
+// BFS from queue[head, tail): every passable neighbour that the popped cell
+// gets closer than before takes its distance and owner. Returns the final tail.
+static int Flood(NearestItemField& field, const std::vector<std::vector<int>>& grid, int head, int tail) {
+    while (head < tail) {
+        int cell = field.queue[head++];
+        int r = cell / field.cols, c = cell % field.cols;
+        int next = field.distance[cell] + 1;
+        for (int dir = 0; dir < 4; dir++) {
+            int dx, dy;
+            MoveDirectionStep(dir, dx, dy);
+            int nr = r + dy, nc = c + dx;
+            if (nr < 0 || nr >= field.rows || nc < 0 || nc >= field.cols || Blocks(grid[nr][nc]))
+                continue;
+            int n = nr * field.cols + nc;
+            if (field.distance[n] != NEAREST_NONE && field.distance[n] <= next)
+                continue;
+            field.distance[n] = next;
+            field.owner[n] = field.owner[cell];
+            field.queue[tail++] = n;
+        }
+    }
+    return tail;
+}
+
+NearestItemField BuildNearestItemField(const std::vector<std::vector<int>>& grid, int itemType) {
+    NearestItemField field;
+    field.itemType = itemType;
+    if (grid.empty() || grid[0].empty())
+        return field;
+    field.rows = grid.size();
+    field.cols = grid[0].size();
+    field.distance.assign(field.rows * field.cols, NEAREST_NONE);
+    field.owner.assign(field.rows * field.cols, NEAREST_NONE);
+    field.queue.resize(field.rows * field.cols);
+    int tail = 0;
+    for (int r = 0; r < field.rows; r++) {
+        for (int c = 0; c < field.cols; c++) {
+            if (grid[r][c] != itemType)
+                continue;
+            int cell = r * field.cols + c;
+            field.distance[cell] = 0;
+            field.owner[cell] = cell;
+            field.queue[tail++] = cell;
+        }
+    }
+    Flood(field, grid, 0, tail);
+    return field;
+}
+
+bool QueryNearestItem(const NearestItemField& field, int row, int col, POINT& item, int& distance) {
+    if (row < 0 || row >= field.rows || col < 0 || col >= field.cols)
+        return false;
+    int cell = row * field.cols + col;
+    if (field.distance[cell] == NEAREST_NONE)
+        return false;
+    distance = field.distance[cell];
+    item = { (long)(field.owner[cell] % field.cols), (long)(field.owner[cell] / field.cols) };
+    return true;
+}
+
+int StepTowardsNearestItem(const NearestItemField& field, int row, int col) {
+    if (row < 0 || row >= field.rows || col < 0 || col >= field.cols)
+        return -1;
+    int here = field.distance[row * field.cols + col];
+    if (here == NEAREST_NONE || here == 0)
+        return -1;
+    for (int dir = 0; dir < 4; dir++) {
+        int dx, dy;
+        MoveDirectionStep(dir, dx, dy);
+        int nr = row + dy, nc = col + dx;
+        if (nr >= 0 && nr < field.rows && nc >= 0 && nc < field.cols
+            && field.distance[nr * field.cols + nc] == here - 1)
+            return dir;
+    }
+    return -1;
+}
+
+// Re-flood the cells that the item at cell owned. Nothing else can change:
+// every other cell's nearest item is still there. The region is refilled
+// from its border, whose cells keep their distances, in order of distance.
+static size_t RemoveItem(NearestItemField& field, int item) {
+    std::vector<int>& region = field.region;
+    region.clear();
+    region.push_back(item);
+    field.owner[item] = PATCHING;
+    for (size_t i = 0; i < region.size(); i++) {
+        int r = region[i] / field.cols, c = region[i] % field.cols;
+        for (int dir = 0; dir < 4; dir++) {
+            int dx, dy;
+            MoveDirectionStep(dir, dx, dy);
+            int nr = r + dy, nc = c + dx;
+            if (nr < 0 || nr >= field.rows || nc < 0 || nc >= field.cols)
+                continue;
+            int n = nr * field.cols + nc;
+            if (field.owner[n] == item) {
+                field.owner[n] = PATCHING;
+                region.push_back(n);
+            }
+        }
+    }
+
+    std::vector<NearestItemSeed>& seeds = field.seeds;
+    seeds.clear();
+    for (int cell : region) {
+        field.distance[cell] = NEAREST_NONE;
+        int r = cell / field.cols, c = cell % field.cols;
+        for (int dir = 0; dir < 4; dir++) {
+            int dx, dy;
+            MoveDirectionStep(dir, dx, dy);
+            int nr = r + dy, nc = c + dx;
+            if (nr < 0 || nr >= field.rows || nc < 0 || nc >= field.cols)
+                continue;
+            int n = nr * field.cols + nc;
+            if (field.owner[n] >= 0)
+                seeds.push_back({ field.distance[n] + 1, cell, field.owner[n] });
+        }
+    }
+    std::sort(seeds.begin(), seeds.end());
+
+    // Settle the region in order of distance: before a cell at distance d
+    // hands d + 1 to its neighbours, every seed at d + 1 or less is placed.
+    size_t s = 0;
+    int head = 0, tail = 0;
+    while (s < seeds.size() || head < tail) {
+        int limit = head < tail ? field.distance[field.queue[head]] + 1 : seeds[s].distance;
+        for (; s < seeds.size() && seeds[s].distance <= limit; s++) {
+            const NearestItemSeed& seed = seeds[s];
+            if (field.owner[seed.cell] != PATCHING)
+                continue;
+            field.distance[seed.cell] = seed.distance;
+            field.owner[seed.cell] = seed.owner;
+            field.queue[tail++] = seed.cell;
+        }
+        if (head == tail)
+            continue;
+        int cell = field.queue[head++];
+        int r = cell / field.cols, c = cell % field.cols;
+        for (int dir = 0; dir < 4; dir++) {
+            int dx, dy;
+            MoveDirectionStep(dir, dx, dy);
+            int nr = r + dy, nc = c + dx;
+            if (nr < 0 || nr >= field.rows || nc < 0 || nc >= field.cols)
+                continue;
+            int n = nr * field.cols + nc;
+            if (field.owner[n] != PATCHING)
+                continue;
+            field.distance[n] = field.distance[cell] + 1;
+            field.owner[n] = field.owner[cell];
+            field.queue[tail++] = n;
+        }
+    }
+    // Cells left over have no item they can reach any more.
+    for (int cell : region) {
+        if (field.owner[cell] == PATCHING)
+            field.owner[cell] = NEAREST_NONE;
+    }
+    return region.size();
+}
+
+size_t UpdateNearestItemField(NearestItemField& field, const std::vector<std::vector<int>>& grid,
+                              int row, int col, int oldValue, int newValue) {
+    bool removed = oldValue == field.itemType && newValue != field.itemType;
+    bool added = newValue == field.itemType && oldValue != field.itemType;
+    if (!removed && !added && Blocks(oldValue) == Blocks(newValue))
+        return 0;
+    int cell = row * field.cols + col;
+    // A cell that starts or stops blocking reroutes paths anywhere.
+    if (Blocks(oldValue) != Blocks(newValue) || (removed && field.owner[cell] != cell)) {
+        field = BuildNearestItemField(grid, field.itemType);
+        return field.distance.size();
+    }
+    if (removed)
+        return RemoveItem(field, cell);
+    if (field.distance[cell] == 0)
+        return 0;
+    field.distance[cell] = 0;
+    field.owner[cell] = cell;
+    field.queue[0] = cell;
+    return Flood(field, grid, 0, 1);
+}
+
+LevelItemIndex BuildLevelItemIndex(const std::vector<std::vector<int>>& grid) {
+    LevelItemIndex index;
+    index.dots = BuildNearestItemField(grid, MINIDOT);
+    index.collectibles = BuildNearestItemField(grid, COLLECTIBLE);
+    return index;
+}
+
+size_t UpdateLevelItemIndex(LevelItemIndex& index, const std::vector<std::vector<int>>& grid,
+                            int row, int col, int oldValue, int newValue) {
+    return UpdateNearestItemField(index.dots, grid, row, col, oldValue, newValue)
+        + UpdateNearestItemField(index.collectibles, grid, row, col, oldValue, newValue);
+}
@@ -0,0 +1,62 @@
+// NearestItem.h : nearest-item distance fields used by hints and bots
+//
+// A field covers one level and one item type (MINIDOT or COLLECTIBLE). Every
+// cell holds the walking distance to the closest item of that type and which
+// item that is, so "how far is the nearest diamond" is one lookup instead of a
+// search. The field is built by one BFS seeded from all items at once. Walls,
+// obstacles, hazards and teleporter pads block, as on the bots' safe paths.
+//
+// Taking or restoring an item only re-floods the cells whose answer changes:
+// the region the taken item owned, or the cells the restored one is now
+// closer to.
+
+#pragma once
+
+#include "MazeGame.h"
+#include <cstddef>
+
+#define NEAREST_NONE -1   // distance and owner of cells no item can reach
+
+// A border cell offering distance to a cell being re-flooded.
+struct NearestItemSeed {
+    int distance, cell, owner;
+    bool operator<(const NearestItemSeed& other) const { return distance < other.distance; }
+};
+
+struct NearestItemField {
+    int rows = 0;
+    int cols = 0;
+    int itemType = MINIDOT;
+    std::vector<int> distance;  // row-major, steps to the nearest item
+    std::vector<int> owner;     // row-major, row * cols + col of that item
+    std::vector<int> queue;     // scratch for builds and patches
+    std::vector<int> region;
+    std::vector<NearestItemSeed> seeds;
+};
+
+// Both item types of one level.
+struct LevelItemIndex {
+    NearestItemField dots;
+    NearestItemField collectibles;
+};
+
+// Build the field for one item type over a level grid.
+NearestItemField BuildNearestItemField(const std::vector<std::vector<int>>& grid, int itemType);
+
+// Distance from (row, col) to the nearest item and that item's cell.
+// Returns false if no item is reachable or the cell itself blocks.
+bool QueryNearestItem(const NearestItemField& field, int row, int col, POINT& item, int& distance);
+
+// Direction index (see MoveDirectionIndex) of a first move from (row, col)
+// along a shortest path to the nearest item, or -1 if there is none.
+int StepTowardsNearestItem(const NearestItemField& field, int row, int col);
+
+// Patch the field after one cell of grid changed from oldValue to newValue
+// (grid already holds the new value). Returns the number of cells whose
+// entry was recomputed.
+size_t UpdateNearestItemField(NearestItemField& field, const std::vector<std::vector<int>>& grid,
+                              int row, int col, int oldValue, int newValue);
+
+LevelItemIndex BuildLevelItemIndex(const std::vector<std::vector<int>>& grid);
+size_t UpdateLevelItemIndex(LevelItemIndex& index, const std::vector<std::vector<int>>& grid,
+                            int row, int col, int oldValue, int newValue);
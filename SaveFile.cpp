@@ -0,0 +1,216 @@
+#include "SaveFile.h"
+#include "Tracing.h"
+#include <fstream>
+#include <cstring>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+uint32_t SaveChecksum(const unsigned char* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+std::vector<unsigned char> EncodeBinarySave(const SaveGameData& data) {
+    SaveHeader header = {};
+    header.magic = SAVE_MAGIC;
+    header.version = SAVE_VERSION;
+    header.levelCount = (uint16_t)data.levels.size();
+    header.rows = data.levels.empty() ? 0 : data.levels[0].size();
+    header.cols = header.rows == 0 ? 0 : data.levels[0][0].size();
+    header.seed = data.seed;
+    header.currentLevel = data.currentLevel;
+    header.lives = data.lives;
+    header.timeLeft = data.timeLeft;
+    header.score = data.score;
+    header.playerX = data.playerPosition.x;
+    header.playerY = data.playerPosition.y;
+    header.indexOffset = sizeof(SaveHeader);
+
+    uint32_t levelBytes = header.rows * header.cols;
+    uint32_t dataOffset = header.indexOffset + header.levelCount * sizeof(SaveIndexEntry);
+    std::vector<unsigned char> buffer(dataOffset + header.levelCount * levelBytes);
+
+    for (int i = 0; i < header.levelCount; i++) {
+        SaveIndexEntry entry = { dataOffset + i * levelBytes, levelBytes };
+        memcpy(&buffer[header.indexOffset + i * sizeof(SaveIndexEntry)], &entry, sizeof(entry));
+        unsigned char* cells = &buffer[entry.offset];
+        const auto& grid = data.levels[i];
+        for (uint32_t r = 0; r < header.rows; r++)
+            for (uint32_t c = 0; c < header.cols; c++)
+                *cells++ = (unsigned char)grid[r][c];
+    }
+
+    header.checksum = SaveChecksum(buffer.data() + sizeof(SaveHeader), buffer.size() - sizeof(SaveHeader));
+    memcpy(buffer.data(), &header, sizeof(header));
+    return buffer;
+}
+
+bool WriteBinarySave(const std::string& path, const SaveGameData& data) {
+    TRACE_SCOPE("WriteBinarySave");
+    std::vector<unsigned char> buffer = EncodeBinarySave(data);
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    if (!ofs)
+        return false;
+    ofs.write((const char*)buffer.data(), buffer.size());
+    return (bool)ofs;
+}
+
+//-----------------------------------------------------
+// MappedFile
+//-----------------------------------------------------
+MappedFile::~MappedFile() {
+    Close();
+}
+
+#ifdef _WIN32
+bool MappedFile::Open(const std::string& path) {
+    Close();
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        Close();
+        return false;
+    }
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        Close();
+        return false;
+    }
+    data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        Close();
+        return false;
+    }
+    size = (size_t)fileSize.QuadPart;
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data)
+        UnmapViewOfFile(data);
+    if (mapping)
+        CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE)
+        CloseHandle(file);
+    data = nullptr;
+    mapping = nullptr;
+    file = INVALID_HANDLE_VALUE;
+    size = 0;
+}
+#else
+bool MappedFile::Open(const std::string& path) {
+    Close();
+    fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        Close();
+        return false;
+    }
+    void* view = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view == MAP_FAILED) {
+        Close();
+        return false;
+    }
+    data = (const unsigned char*)view;
+    size = st.st_size;
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data)
+        munmap((void*)data, size);
+    if (fd >= 0)
+        close(fd);
+    data = nullptr;
+    fd = -1;
+    size = 0;
+}
+#endif
+
+//-----------------------------------------------------
+// BinarySaveView
+//-----------------------------------------------------
+bool BinarySaveView::HasBinaryMagic(const std::string& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    uint32_t magic = 0;
+    if (!ifs.read((char*)&magic, sizeof(magic)))
+        return false;
+    return magic == SAVE_MAGIC;
+}
+
+bool BinarySaveView::Open(const std::string& path) {
+    TRACE_SCOPE("BinarySaveView::Open");
+    header = nullptr;
+    index = nullptr;
+    if (!file.Open(path))
+        return false;
+    const unsigned char* base = file.Data();
+    size_t size = file.Size();
+    if (size < sizeof(SaveHeader))
+        return false;
+    const SaveHeader* h = (const SaveHeader*)base;
+    if (h->magic != SAVE_MAGIC || h->version != SAVE_VERSION)
+        return false;
+    // The game draws and plays fixed-size grids; anything else cannot be loaded.
+    if (h->levelCount == 0 || h->rows != GRID_ROWS || h->cols != GRID_COLS)
+        return false;
+    uint64_t indexEnd = (uint64_t)h->indexOffset + (uint64_t)h->levelCount * sizeof(SaveIndexEntry);
+    if (h->indexOffset < sizeof(SaveHeader) || indexEnd > size)
+        return false;
+    const SaveIndexEntry* entries = (const SaveIndexEntry*)(base + h->indexOffset);
+    uint64_t levelBytes = (uint64_t)h->rows * h->cols;
+    for (int i = 0; i < h->levelCount; i++) {
+        if (entries[i].length != levelBytes || (uint64_t)entries[i].offset + entries[i].length > size)
+            return false;
+    }
+    if (SaveChecksum(base + sizeof(SaveHeader), size - sizeof(SaveHeader)) != h->checksum)
+        return false;
+    header = h;
+    index = entries;
+    return true;
+}
+
+const unsigned char* BinarySaveView::LevelCells(int level) const {
+    return file.Data() + index[level].offset;
+}
+
+std::vector<std::vector<int>> BinarySaveView::LevelGrid(int level) const {
+    int rows = header->rows, cols = header->cols;
+    const unsigned char* cells = LevelCells(level);
+    std::vector<std::vector<int>> grid(rows, std::vector<int>(cols));
+    for (int r = 0; r < rows; r++)
+        for (int c = 0; c < cols; c++)
+            grid[r][c] = *cells++;
+    return grid;
+}
+
+bool BinarySaveView::ToSaveData(SaveGameData& data) const {
+    if (header->currentLevel < 0 || header->currentLevel >= header->levelCount)
+        return false;
+    if (header->playerX < 0 || header->playerX >= (int32_t)header->cols ||
+        header->playerY < 0 || header->playerY >= (int32_t)header->rows)
+        return false;
+    data.seed = header->seed;
+    data.currentLevel = header->currentLevel;
+    data.lives = header->lives;
+    data.timeLeft = header->timeLeft;
+    data.score = header->score;
+    data.playerPosition = { header->playerX, header->playerY };
+    data.levels.clear();
+    for (int i = 0; i < header->levelCount; i++)
+        data.levels.push_back(LevelGrid(i));
+    return true;
+}
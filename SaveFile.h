@@ -0,0 +1,113 @@
+// SaveFile.h : versioned binary save format and memory-mapped loading
+//
+// Layout (little-endian):
+//   SaveHeader
+//   SaveIndexEntry[levelCount]   offset and length of each level's cells
+//   level cells                  one byte per cell, row-major, per level
+// The checksum covers every byte after the header.
+
+#pragma once
+
+#include "MazeGame.h"
+#include <string>
+
+#define SAVE_MAGIC 0x56535A4Du   // "MZSV"
+#define SAVE_VERSION 1
+
+#pragma pack(push, 1)
+struct SaveHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t levelCount;
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t seed;
+    int32_t currentLevel;
+    int32_t lives;
+    int32_t timeLeft;
+    int32_t score;
+    int32_t playerX;
+    int32_t playerY;
+    uint32_t indexOffset;
+    uint32_t checksum;
+};
+
+struct SaveIndexEntry {
+    uint32_t offset;
+    uint32_t length;
+};
+#pragma pack(pop)
+
+// Everything a save holds, in the form the game uses.
+struct SaveGameData {
+    uint32_t seed = 0;
+    int currentLevel = 0;
+    int lives = 0;
+    int timeLeft = 0;
+    int score = 0;
+    POINT playerPosition = { 0, 0 };
+    std::vector<std::vector<std::vector<int>>> levels;
+};
+
+// FNV-1a checksum of a byte range.
+uint32_t SaveChecksum(const unsigned char* data, size_t size);
+
+// Serialize all levels and the player state into one buffer.
+std::vector<unsigned char> EncodeBinarySave(const SaveGameData& data);
+
+// Write a binary save; returns false if the file could not be written.
+bool WriteBinarySave(const std::string& path, const SaveGameData& data);
+
+// Read-only memory mapping of a whole file.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& path);
+    void Close();
+    const unsigned char* Data() const { return data; }
+    size_t Size() const { return size; }
+
+private:
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+// Validated view over a mapped binary save. Level cells are referenced
+// straight from the mapping; nothing is parsed or copied on open.
+class BinarySaveView {
+public:
+    // Returns false if the file is missing, is not a binary save, or fails
+    // the version, bounds or checksum checks. Only saves of one or more
+    // GRID_ROWS x GRID_COLS levels are accepted.
+    bool Open(const std::string& path);
+
+    // True if the file starts with the binary magic (used to tell binary
+    // saves from the older text format).
+    static bool HasBinaryMagic(const std::string& path);
+
+    const SaveHeader& Header() const { return *header; }
+    int LevelCount() const { return header->levelCount; }
+    const unsigned char* LevelCells(int level) const;
+
+    // Widen one level's cells into the game's grid form.
+    std::vector<std::vector<int>> LevelGrid(int level) const;
+
+    // Copy the whole save out; returns false if the stored level or the
+    // player position is out of range.
+    bool ToSaveData(SaveGameData& data) const;
+
+private:
+    MappedFile file;
+    const SaveHeader* header = nullptr;
+    const SaveIndexEntry* index = nullptr;
+};
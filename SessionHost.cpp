@@ -0,0 +1,54 @@
+#include "SessionHost.h"
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+SessionHost::SessionHost(int sessionCount, int threads)
+    : sessions(sessionCount), threadCount(threads) {
+    if (threadCount <= 0)
+        threadCount = (std::max)(1u, std::thread::hardware_concurrency());
+}
+
+// Run fn(begin, end) over the sessions split into one slice per thread.
+template <typename Fn>
+static void ForEachSlice(int sessionCount, int threadCount, Fn fn) {
+    std::vector<std::thread> workers;
+    int perThread = (sessionCount + threadCount - 1) / threadCount;
+    for (int t = 0; t < threadCount; t++) {
+        int begin = t * perThread;
+        int end = (std::min)(sessionCount, begin + perThread);
+        if (begin >= end)
+            break;
+        workers.emplace_back(fn, begin, end);
+    }
+    for (auto& worker : workers)
+        worker.join();
+}
+
+void SessionHost::NewGames(uint32_t firstSeed) {
+    ForEachSlice(sessions.size(), threadCount, [&](int begin, int end) {
+        for (int i = begin; i < end; i++)
+            sessions[i].NewGame(firstSeed + i);
+    });
+}
+
+SessionRunStats SessionHost::RunRandomSteps(int steps, uint32_t policySeed) {
+    SessionRunStats stats;
+    stats.threads = threadCount;
+    auto start = std::chrono::steady_clock::now();
+    ForEachSlice(sessions.size(), threadCount, [&](int begin, int end) {
+        MazeRng policy(policySeed + begin);
+        for (int i = begin; i < end; i++) {
+            GameSession& session = sessions[i];
+            for (int s = 0; s < steps; s++) {
+                GameAction action = (s & 3) == 3 ? ACTION_TICK : (GameAction)policy.Below(4);
+                StepResult result = session.Step(action);
+                if (result == STEP_GAME_OVER || result == STEP_VICTORY)
+                    session.NewGame(session.seed + (uint32_t)sessions.size());
+            }
+        }
+    });
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.steps = (uint64_t)steps * sessions.size();
+    return stats;
+}
@@ -0,0 +1,38 @@
+// SessionHost.h : many independent GameSessions stepped on worker threads
+//
+
+#pragma once
+
+#include "GameSession.h"
+
+// Result of one RunRandomSteps() call.
+struct SessionRunStats {
+    uint64_t steps = 0;
+    double seconds = 0;
+    int threads = 0;
+
+    double StepsPerSecond() const { return seconds > 0 ? steps / seconds : 0; }
+    double StepsPerSecondPerCore() const { return threads > 0 ? StepsPerSecond() / threads : 0; }
+};
+
+// Each worker owns a contiguous slice of the sessions, so sessions are never
+// shared between threads and stepping needs no locks.
+class SessionHost {
+public:
+    // threadCount <= 0 uses one thread per hardware core.
+    SessionHost(int sessionCount, int threadCount);
+
+    // Start every session on its own seed (firstSeed, firstSeed + 1, ...).
+    void NewGames(uint32_t firstSeed);
+
+    // Step every session `steps` times with seeded random actions (a timer
+    // tick every fourth step). Sessions that end are restarted on a new seed.
+    SessionRunStats RunRandomSteps(int steps, uint32_t policySeed);
+
+    std::vector<GameSession>& Sessions() { return sessions; }
+    int ThreadCount() const { return threadCount; }
+
+private:
+    std::vector<GameSession> sessions;
+    int threadCount;
+};
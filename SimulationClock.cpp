@@ -0,0 +1,74 @@
+#include "SimulationClock.h"
+#include <algorithm>
+
+SimulationClock::SimulationClock(int rate, int catchUp)
+    : tickRate(rate), maxCatchUp(catchUp),
+      tickLength(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rate))),
+      accumulator(Clock::duration::zero()) {
+    frameMs.reserve(SIM_FRAME_HISTORY);
+    Reset();
+}
+
+void SimulationClock::Reset() {
+    lastTime = Clock::now();
+    frameStart = lastTime;
+    accumulator = Clock::duration::zero();
+}
+
+int SimulationClock::BeginFrame() {
+    frameStart = Clock::now();
+    accumulator += frameStart - lastTime;
+    lastTime = frameStart;
+    int ticks = (int)(accumulator / tickLength);
+    if (ticks > maxCatchUp) {
+        // Too far behind to catch up: drop the backlog instead of spiralling.
+        stats.droppedTicks += ticks - maxCatchUp;
+        accumulator -= tickLength * (ticks - maxCatchUp);
+        ticks = maxCatchUp;
+    }
+    if (ticks > 1)
+        stats.missedDeadlines++;
+    accumulator -= tickLength * ticks;
+    return ticks;
+}
+
+void SimulationClock::EndFrame() {
+    float ms = std::chrono::duration<float, std::milli>(Clock::now() - frameStart).count();
+    if (frameMs.size() < SIM_FRAME_HISTORY)
+        frameMs.push_back(ms);
+    else
+        frameMs[frameIndex] = ms;
+    frameIndex = (frameIndex + 1) % SIM_FRAME_HISTORY;
+    stats.frames++;
+}
+
+void SimulationClock::RecordTickCost(Clock::duration cost) {
+    double us = std::chrono::duration<double, std::micro>(cost).count();
+    stats.ticks++;
+    tickCostTotalUs += us;
+    stats.tickCostMaxUs = (std::max)(stats.tickCostMaxUs, us);
+}
+
+double SimulationClock::Alpha() const {
+    return std::chrono::duration<double>(accumulator).count() /
+        std::chrono::duration<double>(tickLength).count();
+}
+
+SimulationClock::Clock::duration SimulationClock::UntilNextTick() const {
+    Clock::duration due = tickLength - accumulator - (Clock::now() - lastTime);
+    return due > Clock::duration::zero() ? due : Clock::duration::zero();
+}
+
+FrameStats SimulationClock::Stats() const {
+    FrameStats result = stats;
+    result.tickCostAvgUs = stats.ticks ? tickCostTotalUs / stats.ticks : 0;
+    if (!frameMs.empty()) {
+        std::vector<float> sorted = frameMs;
+        std::sort(sorted.begin(), sorted.end());
+        size_t last = sorted.size() - 1;
+        result.frameP50Ms = sorted[last * 50 / 100];
+        result.frameP95Ms = sorted[last * 95 / 100];
+        result.frameP99Ms = sorted[last * 99 / 100];
+    }
+    return result;
+}
@@ -0,0 +1,66 @@
+// SimulationClock.h : fixed-timestep simulation clock with frame instrumentation
+//
+// The main loop asks BeginFrame() how many fixed ticks to simulate for the
+// real time that has passed, runs them, then renders with Alpha() as the
+// interpolation factor between the last two ticks.
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+#include <cstdint>
+
+#define SIM_TICK_RATE 60          // simulation ticks per second
+#define SIM_MAX_CATCH_UP 8        // most ticks run in one frame before time is dropped
+#define SIM_FRAME_HISTORY 1024    // frames kept for the percentile figures
+
+struct FrameStats {
+    double tickCostAvgUs = 0;     // average time spent in one tick
+    double tickCostMaxUs = 0;     // slowest tick so far
+    double frameP50Ms = 0;        // frame time percentiles over recent frames
+    double frameP95Ms = 0;
+    double frameP99Ms = 0;
+    uint64_t ticks = 0;
+    uint64_t frames = 0;
+    uint64_t missedDeadlines = 0; // frames that needed catch-up ticks
+    uint64_t droppedTicks = 0;    // ticks discarded because the loop fell too far behind
+};
+
+class SimulationClock {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    explicit SimulationClock(int tickRate = SIM_TICK_RATE, int maxCatchUp = SIM_MAX_CATCH_UP);
+
+    // Restart from now and drop any accumulated time (after a pause).
+    void Reset();
+
+    // Start a frame: returns how many ticks to simulate.
+    int BeginFrame();
+    // Finish a frame and record its duration.
+    void EndFrame();
+
+    // Record the cost of one simulated tick.
+    void RecordTickCost(Clock::duration cost);
+
+    // Interpolation factor in [0, 1) between the previous and current tick.
+    double Alpha() const;
+    // Time left until the next tick is due.
+    Clock::duration UntilNextTick() const;
+    int TickRate() const { return tickRate; }
+
+    FrameStats Stats() const;
+
+private:
+    int tickRate;
+    int maxCatchUp;
+    Clock::duration tickLength;
+    Clock::time_point lastTime;
+    Clock::time_point frameStart;
+    Clock::duration accumulator;
+
+    std::vector<float> frameMs;   // ring buffer of recent frame times
+    size_t frameIndex = 0;
+    double tickCostTotalUs = 0;
+    FrameStats stats;
+};
@@ -0,0 +1,125 @@
+#include "SoundBank.h"
+#include "SaveFile.h"
+#include <cstring>
+
+//-----------------------------------------------------------------------------
+// WAV Functions
+//-----------------------------------------------------------------------------
+
+static uint32_t ReadU32(const unsigned char* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t ReadU16(const unsigned char* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+bool DecodeWav(const unsigned char* data, size_t size, SoundClip& clip, bool borrow) {
+    if (size < 12 || memcmp(data, "RIFF", 4) != 0 || memcmp(data + 8, "WAVE", 4) != 0)
+        return false;
+    int format = 0, channels = 0, rate = 0, bits = 0;
+    const unsigned char* pcm = nullptr;
+    size_t pcmSize = 0;
+    // Walk the chunks; fmt and data may come in any order with others between.
+    size_t pos = 12;
+    while (pos + 8 <= size) {
+        uint32_t chunkSize = ReadU32(data + pos + 4);
+        const unsigned char* body = data + pos + 8;
+        if (chunkSize > size - pos - 8)
+            chunkSize = (uint32_t)(size - pos - 8);
+        if (memcmp(data + pos, "fmt ", 4) == 0 && chunkSize >= 16) {
+            format = ReadU16(body);
+            channels = ReadU16(body + 2);
+            rate = (int)ReadU32(body + 4);
+            bits = ReadU16(body + 14);
+        }
+        else if (memcmp(data + pos, "data", 4) == 0) {
+            pcm = body;
+            pcmSize = chunkSize;
+        }
+        pos += 8 + chunkSize + (chunkSize & 1);
+    }
+    if (format != 1 || (channels != 1 && channels != 2) || (bits != 8 && bits != 16) || rate <= 0 || !pcm)
+        return false;
+
+    size_t bytesPerFrame = channels * bits / 8;
+    size_t sourceFrames = pcmSize / bytesPerFrame;
+    if (borrow && bits == 16 && channels == MIXER_CHANNELS && rate == MIXER_SAMPLE_RATE
+        && ((uintptr_t)pcm & 1) == 0) {
+        clip.storage.clear();
+        clip.pcm = (const int16_t*)pcm;
+        clip.frames = sourceFrames;
+        return true;
+    }
+    auto sampleAt = [&](size_t frame, int channel) -> int {
+        const unsigned char* p = pcm + frame * bytesPerFrame + (channel % channels) * (bits / 8);
+        return bits == 8 ? (p[0] - 128) << 8 : (int16_t)ReadU16(p);
+    };
+
+    // Convert to stereo at the mixer rate; resample linearly if needed.
+    size_t frames = rate == MIXER_SAMPLE_RATE ? sourceFrames
+        : (size_t)((double)sourceFrames * MIXER_SAMPLE_RATE / rate);
+    std::vector<int16_t> samples(frames * MIXER_CHANNELS);
+    int16_t* out = samples.data();
+    for (size_t f = 0; f < frames; f++) {
+        for (int c = 0; c < MIXER_CHANNELS; c++) {
+            if (rate == MIXER_SAMPLE_RATE) {
+                *out++ = (int16_t)sampleAt(f, c);
+                continue;
+            }
+            double source = (double)f * rate / MIXER_SAMPLE_RATE;
+            size_t i = (size_t)source;
+            double t = source - i;
+            int a = sampleAt(i, c);
+            int b = i + 1 < sourceFrames ? sampleAt(i + 1, c) : a;
+            *out++ = (int16_t)(a + (b - a) * t);
+        }
+    }
+    clip.SetSamples(std::move(samples));
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// SoundBank Functions
+//-----------------------------------------------------------------------------
+
+bool SoundBank::LoadFile(const std::string& name, const std::string& path) {
+    MappedFile file;
+    if (!file.Open(path))
+        return false;
+    return LoadMemory(name, file.Data(), file.Size());
+}
+
+bool SoundBank::LoadMemory(const std::string& name, const unsigned char* data, size_t size) {
+    return Load(name, data, size, false);
+}
+
+bool SoundBank::LoadView(const std::string& name, const unsigned char* data, size_t size) {
+    return Load(name, data, size, true);
+}
+
+bool SoundBank::Load(const std::string& name, const unsigned char* data, size_t size, bool borrow) {
+    // Voices may be playing a loaded clip, so a name is only ever loaded once.
+    if (Find(name))
+        return true;
+    std::unique_ptr<SoundClip> clip(new SoundClip());
+    clip->name = name;
+    if (!DecodeWav(data, size, *clip, borrow))
+        return false;
+    clips.push_back(std::move(clip));
+    return true;
+}
+
+const SoundClip* SoundBank::Find(const std::string& name) const {
+    for (auto& clip : clips)
+        if (clip->name == name)
+            return clip.get();
+    return nullptr;
+}
+
+size_t SoundBank::BytesUsed() const {
+    size_t bytes = 0;
+    for (auto& clip : clips)
+        bytes += clip->storage.size() * sizeof(int16_t);
+    return bytes;
+}
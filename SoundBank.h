@@ -0,0 +1,56 @@
+// SoundBank.h : WAV assets decoded to PCM once, ready for the mixer
+//
+// PlaySound(SND_FILENAME) re-opens and re-reads a file on every event. The
+// bank decodes each WAV once at startup into the mixer's own format, so a
+// sound event is just a new voice pointing at memory that is already there.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Format every clip is converted to and the mixer renders.
+#define MIXER_SAMPLE_RATE 44100
+#define MIXER_CHANNELS 2
+
+struct SoundClip {
+    std::string name;
+    const int16_t* pcm = nullptr;   // interleaved stereo at MIXER_SAMPLE_RATE
+    size_t frames = 0;
+    std::vector<int16_t> storage;   // owns pcm unless it points into a mapped file
+
+    size_t Frames() const { return frames; }
+    // Take ownership of converted samples.
+    void SetSamples(std::vector<int16_t> samples) {
+        storage = std::move(samples);
+        pcm = storage.data();
+        frames = storage.size() / MIXER_CHANNELS;
+    }
+};
+
+// Decode a RIFF/WAVE image (8 or 16 bit PCM, mono or stereo, any rate) into
+// the mixer format. Returns false for anything else. With borrow set, data
+// already in the mixer format is referenced rather than copied, so it must
+// outlive the clip.
+bool DecodeWav(const unsigned char* data, size_t size, SoundClip& clip, bool borrow = false);
+
+class SoundBank {
+public:
+    bool LoadFile(const std::string& name, const std::string& path);
+    bool LoadMemory(const std::string& name, const unsigned char* data, size_t size);
+    // Like LoadMemory, but the clip may point straight into data (an asset
+    // archive view), which must stay mapped while the bank is in use.
+    bool LoadView(const std::string& name, const unsigned char* data, size_t size);
+
+    // Clips never move once loaded, so voices can keep pointers to them.
+    const SoundClip* Find(const std::string& name) const;
+    size_t Count() const { return clips.size(); }
+    size_t BytesUsed() const;         // decoded copies only; borrowed PCM is not counted
+
+private:
+    bool Load(const std::string& name, const unsigned char* data, size_t size, bool borrow);
+
+    std::vector<std::unique_ptr<SoundClip>> clips;
+};
@@ -0,0 +1,57 @@
+// SpscQueue.h : bounded single-producer single-consumer lock-free queue
+//
+// One thread pushes and one thread pops. Neither side ever takes a lock or
+// waits: TryPush() fails when the ring is full and TryPop() when it is empty.
+// Each side caches the other side's index and only reloads it (one acquire
+// load) when the cached value says full or empty.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+    // Producer thread only.
+    bool TryPush(const T& item) {
+        size_t write = writeIndex.load(std::memory_order_relaxed);
+        if (write - cachedRead == Capacity) {
+            cachedRead = readIndex.load(std::memory_order_acquire);
+            if (write - cachedRead == Capacity)
+                return false;
+        }
+        slots[write & (Capacity - 1)] = item;
+        writeIndex.store(write + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only.
+    bool TryPop(T& item) {
+        size_t read = readIndex.load(std::memory_order_relaxed);
+        if (read == cachedWrite) {
+            cachedWrite = writeIndex.load(std::memory_order_acquire);
+            if (read == cachedWrite)
+                return false;
+        }
+        item = slots[read & (Capacity - 1)];
+        readIndex.store(read + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate; exact only when both sides are idle.
+    size_t Size() const {
+        return writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_acquire);
+    }
+
+private:
+    // Producer and consumer fields sit on separate cache lines so the two
+    // threads do not invalidate each other's line on every operation.
+    alignas(64) std::atomic<size_t> writeIndex{ 0 };
+    size_t cachedRead = 0;      // producer's copy of readIndex
+    alignas(64) std::atomic<size_t> readIndex{ 0 };
+    size_t cachedWrite = 0;     // consumer's copy of writeIndex
+    alignas(64) T slots[Capacity];
+};
@@ -0,0 +1,298 @@
+#include "Teleporters.h"
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <queue>
+#include <utility>
+
+typedef std::vector<std::vector<int>> LevelGrid;
+
+// Cells a route may not cross: the same set the bots avoid.
+static bool BlocksRoute(int value) {
+    return value == WALL || value == OBSTACLE || value == HAZARD;
+}
+
+//-----------------------------------------------------------------------------
+// Placement Functions
+//-----------------------------------------------------------------------------
+
+// Mark the cells of one shortest hazard-free route from the start to the
+// exit; nothing if there is none.
+static std::vector<uint8_t> MarkSafePath(const LevelGrid& grid) {
+    int rows = grid.size(), cols = grid[0].size();
+    std::vector<int> from(rows * cols, -1);
+    std::vector<int> queue(rows * cols);
+    std::vector<uint8_t> onPath(rows * cols, 0);
+    int exit = rows * cols - 1;
+    int head = 0, tail = 0;
+    from[0] = 0;
+    queue[tail++] = 0;
+    while (head < tail && from[exit] < 0) {
+        int cell = queue[head++];
+        int r = cell / cols, c = cell % cols;
+        for (int dir = 0; dir < 4; dir++) {
+            int dx, dy;
+            MoveDirectionStep(dir, dx, dy);
+            int nr = r + dy, nc = c + dx;
+            if (nr < 0 || nr >= rows || nc < 0 || nc >= cols)
+                continue;
+            int next = nr * cols + nc;
+            if (from[next] >= 0 || BlocksRoute(grid[nr][nc]))
+                continue;
+            from[next] = cell;
+            queue[tail++] = next;
+        }
+    }
+    if (from[exit] < 0)
+        return onPath;
+    for (int cell = exit; cell != 0; cell = from[cell])
+        onPath[cell] = 1;
+    onPath[0] = 1;
+    return onPath;
+}
+
+void PlaceTeleporters(std::vector<LevelGrid>& levels, MazeRng& rng) {
+    int count = levels.size();
+    for (int i = 0; i < count; i++) {
+        LevelGrid& grid = levels[i];
+        int cols = grid[0].size();
+        // A pair of its own plus one pad towards each neighbouring level.
+        int pads = 2 + (i > 0) + (i < count - 1);
+        std::vector<uint8_t> onPath = MarkSafePath(grid);
+        std::vector<POINT> cells;
+        for (int r = 0; r < (int)grid.size(); r++) {
+            for (int c = 0; c < cols; c++) {
+                int value = grid[r][c];
+                if ((value == PASSAGE || value == MINIDOT) && !onPath[r * cols + c]
+                    && !(r == 0 && c == 0) && !(r == (int)grid.size() - 1 && c == cols - 1))
+                    cells.push_back({ (long)c, (long)r });
+            }
+        }
+        for (int k = 0; k < pads && !cells.empty(); k++) {
+            int pick = rng.Below((int)cells.size());
+            grid[cells[pick].y][cells[pick].x] = TELEPORTER;
+            cells[pick] = cells.back();
+            cells.pop_back();
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Network Functions
+//-----------------------------------------------------------------------------
+
+TeleportNetwork BuildTeleportNetwork(const std::vector<LevelGrid>& levels) {
+    TeleportNetwork network;
+    if (levels.empty() || levels[0].empty())
+        return network;
+    network.rows = levels[0].size();
+    network.cols = levels[0][0].size();
+    size_t cells = (size_t)network.rows * network.cols;
+    network.padAt.assign(cells * levels.size(), -1);
+    network.tables.resize(levels.size());
+    network.queue.resize(cells);
+    network.steps.resize(cells);
+    for (int level = 0; level < (int)levels.size(); level++) {
+        for (int r = 0; r < network.rows; r++) {
+            for (int c = 0; c < network.cols; c++) {
+                if (levels[level][r][c] != TELEPORTER)
+                    continue;
+                network.padAt[(level * network.rows + r) * network.cols + c] = network.pads.size();
+                network.pads.push_back({ level, { (long)c, (long)r }, -1, -1 });
+            }
+        }
+    }
+    for (size_t i = 0; i + 1 < network.pads.size(); i += 2) {
+        network.pads[i].partner = i + 1;
+        network.pads[i + 1].partner = i;
+    }
+    for (size_t i = 0; i < network.pads.size(); i++) {
+        TeleportPad& pad = network.pads[i];
+        if (pad.partner < 0)
+            continue;
+        PortalTable& table = network.tables[pad.level];
+        pad.slot = table.pads.size();
+        table.pads.push_back(i);
+    }
+    for (int level = 0; level < (int)levels.size(); level++)
+        UpdatePortalTable(network, levels, level);
+    return network;
+}
+
+// BFS over one level from start, leaving the move count to every cell in
+// network.steps (-1 if unreached). The exit and linked pads end a route, so
+// they are reached but never walked through. start itself may be a pad;
+// standing on it does not use it, but stepping off and back on again does,
+// so start counts as two moves away if there is a cell to step off to.
+static void WalkLevel(TeleportNetwork& network, const LevelGrid& grid, int level, POINT start) {
+    int rows = network.rows, cols = network.cols;
+    int exit = rows * cols - 1;
+    const int* padAt = &network.padAt[(size_t)level * rows * cols];
+    std::fill(network.steps.begin(), network.steps.end(), -1);
+    int first = start.y * cols + start.x;
+    int head = 0, tail = 0;
+    network.steps[first] = 0;
+    network.queue[tail++] = first;
+    int back = -1;
+    while (head < tail) {
+        int cell = network.queue[head++];
+        bool linkedPad = padAt[cell] >= 0 && network.pads[padAt[cell]].partner >= 0;
+        bool ends = cell == exit || linkedPad;
+        if (cell != first && ends)
+            continue;
+        if (network.steps[cell] == 1 && !ends)
+            back = 2;
+        int r = cell / cols, c = cell % cols;
+        for (int dir = 0; dir < 4; dir++) {
+            int dx, dy;
+            MoveDirectionStep(dir, dx, dy);
+            int nr = r + dy, nc = c + dx;
+            if (nr < 0 || nr >= rows || nc < 0 || nc >= cols)
+                continue;
+            int next = nr * cols + nc;
+            if (network.steps[next] >= 0 || BlocksRoute(grid[nr][nc]))
+                continue;
+            network.steps[next] = network.steps[cell] + 1;
+            network.queue[tail++] = next;
+        }
+    }
+    network.steps[first] = back;
+}
+
+void UpdatePortalTable(TeleportNetwork& network, const std::vector<LevelGrid>& levels, int level) {
+    PortalTable& table = network.tables[level];
+    int targets = table.pads.size() + 1;
+    int exit = network.rows * network.cols - 1;
+    table.distance.assign(targets * targets, -1);
+    for (int entry = 0; entry < targets; entry++) {
+        POINT start = entry == 0 ? POINT{ 0, 0 } : network.pads[table.pads[entry - 1]].cell;
+        WalkLevel(network, levels[level], level, start);
+        int* row = &table.distance[entry * targets];
+        for (int t = 0; t + 1 < targets; t++) {
+            POINT cell = network.pads[table.pads[t]].cell;
+            row[t] = network.steps[cell.y * network.cols + cell.x];
+        }
+        row[targets - 1] = network.steps[exit];
+    }
+}
+
+bool PortalCellChanged(TeleportNetwork& network, const std::vector<LevelGrid>& levels, int level,
+                       int oldValue, int newValue) {
+    if (level >= (int)network.tables.size() || BlocksRoute(oldValue) == BlocksRoute(newValue))
+        return false;
+    UpdatePortalTable(network, levels, level);
+    return true;
+}
+
+bool TeleportDestination(const TeleportNetwork& network, int level, POINT cell, int& toLevel, POINT& to) {
+    if (network.padAt.empty())
+        return false;
+    int pad = network.PadAt(level, cell.y, cell.x);
+    if (pad < 0 || network.pads[pad].partner < 0)
+        return false;
+    const TeleportPad& partner = network.pads[network.pads[pad].partner];
+    toLevel = partner.level;
+    to = partner.cell;
+    return true;
+}
+
+bool FindLinkedTeleporter(const std::vector<LevelGrid>& levels, int level, POINT cell, int& toLevel, POINT& to) {
+    int count = 0;
+    bool found = false;
+    for (int l = 0; l < (int)levels.size(); l++) {
+        for (int r = 0; r < (int)levels[l].size(); r++) {
+            for (int c = 0; c < (int)levels[l][r].size(); c++) {
+                if (levels[l][r][c] != TELEPORTER)
+                    continue;
+                // The pad after an even-numbered one is its partner ...
+                if (found) {
+                    toLevel = l;
+                    to = { (long)c, (long)r };
+                    return true;
+                }
+                if (l == level && r == cell.y && c == cell.x) {
+                    // ... and an odd-numbered one's partner came just before.
+                    if (count & 1)
+                        return true;
+                    found = true;
+                }
+                toLevel = l;
+                to = { (long)c, (long)r };
+                count++;
+            }
+        }
+    }
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+// Route Functions
+//-----------------------------------------------------------------------------
+
+// Nodes are the start of every level (node = level) and every linked pad the
+// player has just arrived on (node = level count + pad index). Dijkstra over
+// them uses the table rows as edges: a pad target leads on to its partner,
+// the exit to the next level's start or to the finish.
+int ShortestRouteSteps(TeleportNetwork& network, const std::vector<LevelGrid>& levels, int level, POINT cell) {
+    int levelCount = levels.size();
+    if (network.tables.size() != levels.size() || level < 0 || level >= levelCount)
+        return -1;
+    std::vector<int> best(levelCount + network.pads.size(), INT_MAX);
+    std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<std::pair<int, int>>> open;
+    int finish = INT_MAX;
+    // Walking d moves on level `from` to its target t.
+    auto reach = [&](int from, int t, int d) {
+        const PortalTable& table = network.tables[from];
+        int node;
+        if (t == (int)table.pads.size()) {
+            if (from == levelCount - 1) {
+                finish = (std::min)(finish, d);
+                return;
+            }
+            node = from + 1;
+        }
+        else {
+            node = levelCount + network.pads[table.pads[t]].partner;
+        }
+        if (d < best[node]) {
+            best[node] = d;
+            open.push({ d, node });
+        }
+    };
+
+    WalkLevel(network, levels[level], level, cell);
+    const PortalTable& here = network.tables[level];
+    for (int t = 0; t < (int)here.pads.size(); t++) {
+        POINT pad = network.pads[here.pads[t]].cell;
+        int d = network.steps[pad.y * network.cols + pad.x];
+        if (d >= 0)
+            reach(level, t, d);
+    }
+    int exitSteps = network.steps[network.rows * network.cols - 1];
+    if (exitSteps >= 0)
+        reach(level, here.pads.size(), exitSteps);
+
+    while (!open.empty()) {
+        std::pair<int, int> top = open.top();
+        open.pop();
+        int d = top.first, node = top.second;
+        if (d > best[node])
+            continue;
+        if (d >= finish)
+            break;
+        int from = node, entry = 0;
+        if (node >= levelCount) {
+            const TeleportPad& pad = network.pads[node - levelCount];
+            from = pad.level;
+            entry = 1 + pad.slot;
+        }
+        const PortalTable& table = network.tables[from];
+        int targets = table.pads.size() + 1;
+        const int* row = &table.distance[entry * targets];
+        for (int t = 0; t < targets; t++) {
+            if (row[t] >= 0)
+                reach(from, t, d + row[t]);
+        }
+    }
+    return finish == INT_MAX ? -1 : finish;
+}
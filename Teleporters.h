@@ -0,0 +1,87 @@
+// Teleporters.h : teleporter pads, their links and the portal route table
+//
+// Stepping onto a TELEPORTER pad moves the player to the pad it is linked
+// to, which may be on another level. Pads are linked in pairs in reading
+// order over the whole game (level by level, row by row): the first pad with
+// the second, the third with the fourth, and so on; a pad left over is
+// inert and works like a passage. The links follow from the grids alone, so
+// saves, the autosave journal and undo need no extra state.
+// PlaceTeleporters() lays the pads out so that, where a level has room,
+// every level has one pair of its own and one link to each neighbouring
+// level.
+//
+// For route finding each level keeps a table of walking distances between
+// entry points (the start and every linked pad) and its targets (every
+// linked pad and the exit). The shortest route through the whole game is then a Dijkstra
+// over those few nodes instead of a BFS over every cell of every level.
+// Routes avoid hazards, and since stepping onto a linked pad always
+// teleports, they never pass over one.
+
+#pragma once
+
+#include "MazeGame.h"
+#include <cstddef>
+
+struct TeleportPad {
+    int level;
+    POINT cell;
+    int partner;    // index of the linked pad, -1 if inert
+    int slot;       // position in its level's PortalTable::pads, -1 if inert
+};
+
+// Distances within one level. Entry points are the start (entry 0) and the
+// level's linked pads (entry 1 + i); targets are the linked pads (target i)
+// and the exit (target pads.size()). distance[entry * (pads.size() + 1) + target] is the
+// number of moves, or -1 if the target cannot be reached.
+struct PortalTable {
+    std::vector<int> pads;      // linked pads, as indices into TeleportNetwork::pads
+    std::vector<int> distance;
+};
+
+struct TeleportNetwork {
+    int rows = 0;
+    int cols = 0;
+    std::vector<TeleportPad> pads;
+    std::vector<int> padAt;             // per level and cell: pad index or -1
+    std::vector<PortalTable> tables;    // one per level
+    std::vector<int> queue;             // BFS scratch
+    std::vector<int> steps;
+
+    // Pad index at a cell, or -1.
+    int PadAt(int level, int row, int col) const {
+        return padAt[((size_t)level * rows + row) * cols + col];
+    }
+};
+
+// Turn some cells off each level's safe path into pads (see above). The
+// start, the exit and a hazard-free route between them stay untouched.
+void PlaceTeleporters(std::vector<std::vector<std::vector<int>>>& levels, MazeRng& rng);
+
+// Find the pads, link them and build every level's table.
+TeleportNetwork BuildTeleportNetwork(const std::vector<std::vector<std::vector<int>>>& levels);
+
+// Rebuild one level's table: one BFS per entry point.
+void UpdatePortalTable(TeleportNetwork& network, const std::vector<std::vector<std::vector<int>>>& levels,
+                       int level);
+
+// Keep the tables in line after one cell of a level changed. Only a change
+// between a cell routes may cross and one they may not (a hazard turning
+// into a passage, say) rebuilds anything, and then only that level's table;
+// picking up an item leaves the distances as they are. Returns true if the
+// table was rebuilt.
+bool PortalCellChanged(TeleportNetwork& network, const std::vector<std::vector<std::vector<int>>>& levels,
+                       int level, int oldValue, int newValue);
+
+// Where the pad at (level, cell) sends the player. Returns false if there is
+// no pad there or it is inert.
+bool TeleportDestination(const TeleportNetwork& network, int level, POINT cell, int& toLevel, POINT& to);
+
+// The same from the grids alone, by counting pads in reading order; for
+// code that keeps no network, such as the autosave replay.
+bool FindLinkedTeleporter(const std::vector<std::vector<std::vector<int>>>& levels, int level, POINT cell,
+                          int& toLevel, POINT& to);
+
+// Fewest moves from cell of the given level to the exit of the last level,
+// through exits and teleporters, or -1 if there is no route.
+int ShortestRouteSteps(TeleportNetwork& network, const std::vector<std::vector<std::vector<int>>>& levels,
+                       int level, POINT cell);
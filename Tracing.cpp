@@ -0,0 +1,195 @@
+#include "Tracing.h"
+
+#if MAZE_TRACING
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> g_tracingEnabled(false);
+
+namespace {
+
+struct TraceSpanRecord {
+    const char* name;
+    int64_t start;      // TraceNow() nanoseconds
+    int64_t duration;
+    int track;          // thread that recorded it
+};
+
+// One thread's spans. written counts every span the buffer has held; the
+// thread publishes a span by storing the new count with release order.
+struct TraceBuffer {
+    int track = 0;                          // of the thread now using the buffer
+    uint64_t flushed = 0;                   // spans already written out, guarded by registryLock
+    std::atomic<uint64_t> written{ 0 };
+    TraceSpanRecord spans[TRACE_BUFFER_SPANS];
+};
+
+std::mutex registryLock;
+std::vector<std::unique_ptr<TraceBuffer>> buffers;  // every buffer, guarded by registryLock
+std::vector<TraceBuffer*> freeBuffers;              // of threads that ended, guarded by registryLock
+std::vector<std::string> trackNames;                // per thread ever traced, guarded by registryLock
+
+// Hands the thread's buffer back when the thread ends, so workers that come
+// and go reuse a few buffers instead of each leaving one behind.
+struct ThreadTraceBuffer {
+    TraceBuffer* buffer = nullptr;
+
+    ~ThreadTraceBuffer() {
+        if (!buffer)
+            return;
+        std::lock_guard<std::mutex> guard(registryLock);
+        freeBuffers.push_back(buffer);
+    }
+};
+
+thread_local ThreadTraceBuffer threadBuffer;
+
+TraceBuffer* ThreadBuffer() {
+    if (threadBuffer.buffer)
+        return threadBuffer.buffer;
+    std::lock_guard<std::mutex> guard(registryLock);
+    TraceBuffer* buffer;
+    if (!freeBuffers.empty()) {
+        buffer = freeBuffers.back();
+        freeBuffers.pop_back();
+    }
+    else {
+        buffers.push_back(std::unique_ptr<TraceBuffer>(new TraceBuffer));
+        buffer = buffers.back().get();
+    }
+    // Spans keep their own track, so a reused buffer still exports the
+    // spans of the thread that had it before under that thread's name.
+    trackNames.emplace_back();
+    buffer->track = (int)trackNames.size();
+    threadBuffer.buffer = buffer;
+    return buffer;
+}
+
+// Names come from the code, but keep the JSON valid whatever they hold.
+void WriteJsonString(std::ofstream& out, const char* text) {
+    out << '"';
+    for (const char* c = text; *c; c++) {
+        if (*c == '"' || *c == '\\')
+            out << '\\' << *c;
+        else if ((unsigned char)*c < 0x20)
+            out << ' ';
+        else
+            out << *c;
+    }
+    out << '"';
+}
+
+}
+
+//-----------------------------------------------------------------------------
+// Recording Functions
+//-----------------------------------------------------------------------------
+
+void EnableTracing(bool enabled) {
+    g_tracingEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void SetTraceThreadName(const char* name) {
+    TraceBuffer* buffer = ThreadBuffer();
+    std::lock_guard<std::mutex> guard(registryLock);
+    trackNames[buffer->track - 1] = name;
+}
+
+int64_t TraceNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void RecordTraceSpan(const char* name, int64_t start, int64_t end) {
+    TraceBuffer* buffer = ThreadBuffer();
+    uint64_t index = buffer->written.load(std::memory_order_relaxed);
+    TraceSpanRecord& span = buffer->spans[index & (TRACE_BUFFER_SPANS - 1)];
+    span.name = name;
+    span.start = start;
+    span.duration = end - start;
+    span.track = buffer->track;
+    buffer->written.store(index + 1, std::memory_order_release);
+}
+
+//-----------------------------------------------------------------------------
+// Export Functions
+//-----------------------------------------------------------------------------
+
+bool WriteChromeTrace(const std::string& path) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+        return false;
+    std::vector<TraceSpanRecord> spans;
+    std::vector<std::string> names;
+    {
+        std::lock_guard<std::mutex> guard(registryLock);
+        for (const auto& buffer : buffers) {
+            // The owning thread keeps recording while its spans are copied;
+            // any it may have overwritten meanwhile are dropped.
+            uint64_t end = buffer->written.load(std::memory_order_acquire);
+            uint64_t first = end > TRACE_BUFFER_SPANS ? end - TRACE_BUFFER_SPANS : 0;
+            first = (std::max)(first, buffer->flushed);
+            size_t copied = spans.size();
+            for (uint64_t i = first; i < end; i++)
+                spans.push_back(buffer->spans[i & (TRACE_BUFFER_SPANS - 1)]);
+            uint64_t now = buffer->written.load(std::memory_order_acquire);
+            uint64_t intact = now >= TRACE_BUFFER_SPANS ? now - TRACE_BUFFER_SPANS + 1 : 0;
+            if (intact > first) {
+                size_t drop = (size_t)((std::min)(intact, end) - first);
+                spans.erase(spans.begin() + copied, spans.begin() + copied + drop);
+            }
+            buffer->flushed = end;
+        }
+        names = trackNames;
+    }
+
+    int64_t origin = 0;
+    std::vector<bool> used(names.size() + 1, false);
+    if (!spans.empty())
+        origin = spans[0].start;
+    for (const auto& span : spans) {
+        origin = (std::min)(origin, span.start);
+        used[span.track] = true;
+    }
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    char number[96];
+    for (int track = 1; track <= (int)names.size(); track++) {
+        if (!used[track])
+            continue;
+        out << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track
+            << ",\"args\":{\"name\":";
+        const std::string& name = names[track - 1];
+        WriteJsonString(out, name.empty() ? ("thread " + std::to_string(track)).c_str() : name.c_str());
+        out << "}}";
+        first = false;
+    }
+    for (const auto& span : spans) {
+        out << (first ? "\n" : ",\n") << "{\"name\":";
+        WriteJsonString(out, span.name);
+        snprintf(number, sizeof(number), ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+            span.track, (span.start - origin) / 1000.0, span.duration / 1000.0);
+        out << number;
+        first = false;
+    }
+    out << "\n]}\n";
+    return (bool)out;
+}
+
+#else
+
+void EnableTracing(bool) {}
+
+void SetTraceThreadName(const char*) {}
+
+bool WriteChromeTrace(const std::string&) {
+    return false;
+}
+
+#endif
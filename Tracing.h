@@ -0,0 +1,83 @@
+// Tracing.h : scoped timing spans exported as Chrome trace-event JSON
+//
+// TRACE_SCOPE("name") at the top of a block records one span from there to
+// the end of the block. Each thread writes its spans into its own ring
+// buffer, so recording takes no lock; a full buffer overwrites its oldest
+// spans. WriteChromeTrace() collects every buffer into a JSON file that
+// Perfetto (ui.perfetto.dev) and chrome://tracing open, one track per thread.
+//
+// Tracing starts switched off. While it is off, a span costs one relaxed load
+// of the switch and a branch that always goes the same way. Building with
+// MAZE_TRACING defined to 0 removes the spans from the code altogether.
+//
+// Span names must be string literals (or otherwise outlive the trace): only
+// the pointer is stored.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#ifndef MAZE_TRACING
+#define MAZE_TRACING 1
+#endif
+
+#define TRACE_BUFFER_SPANS 16384    // per thread, a power of two
+
+// Switch recording on or off for every thread. No-op when compiled out.
+void EnableTracing(bool enabled);
+
+// Name the calling thread's track in the trace, e.g. "audio".
+void SetTraceThreadName(const char* name);
+
+// Write the spans recorded since the last call (or since tracing started) as
+// Chrome trace-event JSON. Returns false if the file could not be written or
+// tracing is compiled out.
+bool WriteChromeTrace(const std::string& path);
+
+#if MAZE_TRACING
+
+extern std::atomic<bool> g_tracingEnabled;
+
+inline bool TracingEnabled() {
+    return g_tracingEnabled.load(std::memory_order_relaxed);
+}
+
+// Nanoseconds on the steady clock.
+int64_t TraceNow();
+
+// Append one finished span to the calling thread's buffer.
+void RecordTraceSpan(const char* name, int64_t start, int64_t end);
+
+class TraceScope {
+public:
+    explicit TraceScope(const char* spanName) {
+        if (TracingEnabled()) {
+            name = spanName;
+            start = TraceNow();
+        }
+    }
+    ~TraceScope() {
+        if (name)
+            RecordTraceSpan(name, start, TraceNow());
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name = nullptr;    // null while tracing is off
+    int64_t start = 0;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+#else
+
+inline bool TracingEnabled() { return false; }
+
+#define TRACE_SCOPE(name) ((void)0)
+
+#endif
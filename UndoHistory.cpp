@@ -0,0 +1,35 @@
+#include "UndoHistory.h"
+
+void UndoHistory::Push(const UndoDelta& delta) {
+    if (ring.empty())
+        return;
+    ring[(oldest + undoCount) % ring.size()] = delta;
+    if (undoCount == ring.size())
+        oldest = (oldest + 1) % ring.size();
+    else
+        undoCount++;
+    redoCount = 0;
+}
+
+const UndoDelta* UndoHistory::Undo() {
+    if (undoCount == 0)
+        return nullptr;
+    undoCount--;
+    redoCount++;
+    return &ring[(oldest + undoCount) % ring.size()];
+}
+
+const UndoDelta* UndoHistory::Redo() {
+    if (redoCount == 0)
+        return nullptr;
+    const UndoDelta* delta = &ring[(oldest + undoCount) % ring.size()];
+    undoCount++;
+    redoCount--;
+    return delta;
+}
+
+void UndoHistory::Clear() {
+    oldest = 0;
+    undoCount = 0;
+    redoCount = 0;
+}
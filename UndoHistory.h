@@ -0,0 +1,67 @@
+// UndoHistory.h : bounded undo/redo of session steps
+//
+// Each move that changed the session is stored as one packed UndoDelta: the
+// direction, what happened to the target cell, where the player came from
+// and the lives, time and score deltas. The deltas live in a fixed ring, so
+// memory stays constant however long the game runs; once it is full the
+// oldest step can no longer be undone. Undo and redo are O(1).
+
+#pragma once
+
+#include "MazeGame.h"
+#include <cstddef>
+
+// UndoDelta::flags
+#define UNDO_DIR_MASK      0x03   // 0 up, 1 right, 2 down, 3 left
+#define UNDO_TICK          0x04   // timer tick rather than a move
+#define UNDO_ENTERED       0x08   // player stepped onto the target cell
+#define UNDO_CELL_CHANGED  0x10   // target cell went from oldCell to newCell
+#define UNDO_RESET         0x20   // player sent back to the start cell
+#define UNDO_NEXT_LEVEL    0x40   // player advanced to the next level
+#define UNDO_TELEPORT      0x80   // player went through the teleporter on the target cell
+
+#pragma pack(push, 1)
+// One step of play in ten bytes.
+struct UndoDelta {
+    uint8_t flags;
+    uint8_t cells;          // old cell value in the low nibble, new in the high
+    int8_t livesDelta;
+    int8_t scoreDelta;
+    int16_t timeDelta;
+    uint16_t fromX;         // player position before the step
+    uint16_t fromY;
+
+    int OldCell() const { return cells & 0x0F; }
+    int NewCell() const { return cells >> 4; }
+    // Cell the move targeted; meaningless for a tick.
+    POINT Target() const {
+        int dx, dy;
+        MoveDirectionStep(flags & UNDO_DIR_MASK, dx, dy);
+        return { (long)fromX + dx, (long)fromY + dy };
+    }
+};
+#pragma pack(pop)
+
+class UndoHistory {
+public:
+    explicit UndoHistory(size_t capacity = 256) : ring(capacity) {}
+
+    // Record a new step. Drops the oldest one when full and discards the
+    // redo steps, as any new step does.
+    void Push(const UndoDelta& delta);
+    // Step to revert, or null if there is none; the step becomes redoable.
+    const UndoDelta* Undo();
+    // Step to apply again, or null if there is none.
+    const UndoDelta* Redo();
+    void Clear();
+
+    size_t UndoCount() const { return undoCount; }
+    size_t RedoCount() const { return redoCount; }
+    size_t Capacity() const { return ring.size(); }
+
+private:
+    std::vector<UndoDelta> ring;
+    size_t oldest = 0;          // ring index of the oldest undoable step
+    size_t undoCount = 0;
+    size_t redoCount = 0;       // steps after the undo ones, in ring order
+};